@@ -17,7 +17,9 @@ set(TIC80CORE_DIR ${CMAKE_SOURCE_DIR}/src)
 set(TIC80CORE_SRC
     ${TIC80CORE_DIR}/fftdata.c
     ${TIC80CORE_DIR}/core/core.c
+    ${TIC80CORE_DIR}/core/blit.c
     ${TIC80CORE_DIR}/core/draw.c
+    ${TIC80CORE_DIR}/core/profile.c
     ${TIC80CORE_DIR}/core/io.c
     ${TIC80CORE_DIR}/core/sound.c
     ${TIC80CORE_DIR}/tic.c
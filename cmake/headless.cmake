@@ -0,0 +1,78 @@
+################################
+# Headless cart runner
+################################
+
+if(BUILD_HEADLESS)
+
+    add_executable(tic80-headless
+        ${CMAKE_SOURCE_DIR}/src/system/headless/main.c
+        ${CMAKE_SOURCE_DIR}/src/ext/md5.c)
+
+    target_include_directories(tic80-headless PRIVATE
+        ${CMAKE_SOURCE_DIR}/include
+        ${CMAKE_SOURCE_DIR}/src)
+
+    target_link_libraries(tic80-headless PRIVATE tic80core png wave_writer argparse)
+
+    find_package(Threads REQUIRED)
+    target_link_libraries(tic80-headless PRIVATE Threads::Threads)
+
+    if(LINUX)
+        target_link_libraries(tic80-headless PRIVATE m)
+    endif()
+
+    # runs carts on many instances serially and in parallel threads and compares the output
+    add_executable(tic80-stress
+        ${CMAKE_SOURCE_DIR}/src/system/headless/stress.c
+        ${CMAKE_SOURCE_DIR}/src/studio/project.c
+        ${CMAKE_SOURCE_DIR}/src/ext/md5.c)
+
+    target_include_directories(tic80-stress PRIVATE
+        ${CMAKE_SOURCE_DIR}/include
+        ${CMAKE_SOURCE_DIR}/src)
+
+    target_link_libraries(tic80-stress PRIVATE tic80core argparse Threads::Threads)
+
+    if(LINUX)
+        target_link_libraries(tic80-stress PRIVATE m)
+    endif()
+
+    # deterministic demos of the languages that keep their runtime per instance
+    set(STRESS_CARTS)
+
+    if(BUILD_WITH_LUA)
+        list(APPEND STRESS_CARTS
+            ${DEMO_CARTS_IN}/luademo.lua
+            ${DEMO_CARTS_IN}/car.lua
+            ${DEMO_CARTS_IN}/p3d.lua
+            ${DEMO_CARTS_IN}/music.lua)
+    endif()
+
+    if(BUILD_WITH_JS)
+        list(APPEND STRESS_CARTS ${DEMO_CARTS_IN}/jsdemo.js)
+    endif()
+
+    if(BUILD_WITH_SQUIRREL)
+        list(APPEND STRESS_CARTS ${DEMO_CARTS_IN}/squirreldemo.nut)
+    endif()
+
+    if(STRESS_CARTS)
+        enable_testing()
+        add_test(NAME stress COMMAND tic80-stress --threads 4 --frames 300 ${STRESS_CARTS})
+    endif()
+
+    # times the sound synthesizer against a reference copy of the two pass one
+    add_executable(tic80-synthbench
+        ${CMAKE_SOURCE_DIR}/src/system/headless/synthbench.c)
+
+    target_include_directories(tic80-synthbench PRIVATE
+        ${CMAKE_SOURCE_DIR}/include
+        ${CMAKE_SOURCE_DIR}/src)
+
+    target_link_libraries(tic80-synthbench PRIVATE tic80core blipbuf argparse)
+
+    if(LINUX)
+        target_link_libraries(tic80-synthbench PRIVATE m)
+    endif()
+
+endif()
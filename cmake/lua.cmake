@@ -12,6 +12,7 @@ if(BUILD_WITH_LUA AND PREFER_SYSTEM_LIBRARIES)
         add_library(luaapi STATIC
             ${CMAKE_SOURCE_DIR}/src/api/luaapi.c
             ${CMAKE_SOURCE_DIR}/src/api/parse_note.c
+            ${CMAKE_SOURCE_DIR}/src/ext/md5.c
         )
         target_link_libraries(luaapi PRIVATE runtime ${lua_LIBRARY})
         target_include_directories(luaapi PUBLIC
@@ -71,6 +72,7 @@ if(BUILD_WITH_LUA OR BUILD_WITH_MOON OR BUILD_WITH_YUE OR BUILD_WITH_FENNEL)
         ${LUA_SRC}
         ${CMAKE_SOURCE_DIR}/src/api/luaapi.c
         ${CMAKE_SOURCE_DIR}/src/api/parse_note.c
+        ${CMAKE_SOURCE_DIR}/src/ext/md5.c
     )
     target_link_libraries(luaapi PRIVATE runtime)
 
@@ -50,6 +50,12 @@ target_include_directories(tic80studio
 
 target_link_libraries(tic80studio PUBLIC tic80core PRIVATE zip wave_writer argparse giflib png)
 
+if(BUILD_EDITORS AND NOT EMSCRIPTEN AND NOT NINTENDO_3DS AND NOT BAREMETALPI)
+    # surf loads cart covers on a worker thread
+    find_package(Threads REQUIRED)
+    target_link_libraries(tic80studio PRIVATE Threads::Threads)
+endif()
+
 if(USE_NAETT)
     target_compile_definitions(tic80studio PRIVATE USE_NAETT)
     target_link_libraries(tic80studio PRIVATE naett)
@@ -23,7 +23,9 @@
 "CHECK_NEW_VERSION":true,
 "SOFTWARE_RENDERING":false,
 "UI_SCALE":4,
-"TRIM_ON_SAVE":false
+"TRIM_ON_SAVE":false,
+"UNDO_BUDGET":8,
+"FRAME_TIMEOUT":5000
 
 }
 
@@ -47,6 +47,10 @@ extern "C" {
 #define TIC80_SAMPLESIZE        sizeof(TIC80_SAMPLETYPE)
 #define TIC80_SAMPLE_CHANNELS   2
 #define TIC80_FRAMERATE         60
+#define TIC80_DIRTY_SIZE        ((TIC80_FULLHEIGHT + 31) / 32)
+
+// checks if the row of the screen was updated by the last tick
+#define TIC80_DIRTY_ROW(tic, row) (((tic)->dirty[(row) >> 5] >> ((row) & 31)) & 1)
 
 typedef enum {
     TIC80_PIXEL_COLOR_ARGB8888 = (1 << 8) | 32,
@@ -71,6 +75,9 @@ typedef struct
     } samples;
 
     u32 *screen;
+
+    // one bit per screen row, rows without the bit set are left untouched
+    u32 dirty[TIC80_DIRTY_SIZE];
 } tic80;
 
 typedef union
@@ -184,12 +191,38 @@ typedef struct
 
 } tic80_input;
 
+// Instances don't share mutable state, each one can be driven from its own thread.
+// The exceptions are the Janet, mruby and Wren runtimes, which keep the running
+// VM in globals, and the FFT capture device, which is opened once per process
+// and feeds the same samples to every instance. tic80-stress checks this on real carts.
 TIC80_API tic80* tic80_create(s32 samplerate, tic80_pixel_color_format format);
 TIC80_API void tic80_load(tic80* tic, void* cart, s32 size);
 TIC80_API void tic80_tick(tic80* tic, tic80_input input, u64 (*counter)(), u64 (*freq)());
+// Token of the frame tic80_tick() is running on the instance, 0 between frames.
+// It can be read from any thread.
+TIC80_API u32 tic80_frame(tic80* tic);
+// Aborts a cart stuck in its frame with an error. It's meant for a watchdog thread that
+// passes the token it saw in tic80_frame(), the call does nothing and returns false once
+// that frame is over. Lua-based, JavaScript and Janet carts are stopped wherever they
+// are. WASM and Python carts are stopped at their next API call, so a loop that makes
+// none keeps running. Ruby, Squirrel, Wren and Scheme carts ignore it, their runtimes
+// have no way to stop a running script from another thread.
+TIC80_API bool tic80_interrupt(tic80* tic, u32 frame);
+// Synthesizes one frame into tic->samples. Call it from the thread that ticks
+// and queue the samples for the audio device, don't call it from the device callback.
 TIC80_API void tic80_sound(tic80* tic);
 TIC80_API void tic80_delete(tic80* tic);
 
+// Offline rendering of a track or sfx from the first bank of the loaded cart,
+// faster than realtime and without running the cart code. The samples come at
+// the instance sample rate. tic80_render writes up to `frames` interleaved stereo
+// frames to buffer and returns how many were written, fewer once the sound ended.
+// A track or sfx index out of range renders nothing.
+// Don't mix it with tic80_tick/tic80_sound on the same instance.
+TIC80_API void tic80_render_music(tic80* tic, s32 track);
+TIC80_API void tic80_render_sfx(tic80* tic, s32 index);
+TIC80_API s32 tic80_render(tic80* tic, s16* buffer, s32 frames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,11 +29,27 @@
 typedef struct { u8 index; tic_flip flip; tic_rotate rotate; } RemapResult;
 typedef void(*RemapFunc)(void*, s32 x, s32 y, RemapResult* result);
 
+// drawlist() commands, each opcode is followed by its arguments
+typedef enum
+{
+    tic_draw_pix,   // x y color
+    tic_draw_line,  // x0 y0 x1 y1 color
+    tic_draw_rect,  // x y w h color
+    tic_draw_rectb, // x y w h color
+    tic_draw_circ,  // x y radius color
+    tic_draw_spr,   // id x y colorkey scale flip rotate w h
+} tic_draw_command;
+
+// bindings copy script arrays to drawlist() in chunks of this many values
+#define TIC_DRAWLIST_CHUNK 256
+
 typedef void(*TraceOutput)(void*, const char*, u8 color);
 typedef void(*ErrorOutput)(void*, const char*);
 typedef void(*ExitCallback)(void*);
 typedef u64(*CounterCallback)(void*);
 typedef u64(*FreqCallback)(void*);
+typedef void*(*CacheLoad)(void*, const char* key, s32* size);
+typedef void(*CacheSave)(void*, const char* key, const void* buffer, s32 size);
 
 typedef struct
 {
@@ -45,6 +61,15 @@ typedef struct
     FreqCallback freq;
     u64 start;
 
+    // optional cache of compiled cart code, the loaded buffer is freed by the script,
+    // it isn't verified either, so the same trust rules as for bytecode apply
+    CacheLoad cacheLoad;
+    CacheSave cacheSave;
+
+    // run the compiled code embedded in the cart and embed it after compiling,
+    // bytecode isn't verified by the VM, so only enable it for trusted carts
+    bool bytecode;
+
     void* data;
 } tic_tick_data;
 
@@ -324,6 +349,8 @@ enum
         "animated tiles or replace them completely.\n"                                                                  \
         "Some examples include changing sprites to open doorways, "                                                     \
         "hiding sprites used to spawn objects in your game and even to emit the objects themselves.\n"                  \
+        "Instead of a function, remap can be a table with one value per drawn cell, row by row, "                       \
+        "where a value is tile + flip * 256 + rotate * 1024 and nil keeps the map tile.\n"                              \
         "The tilemap is laid out sequentially in RAM - writing 1 to 0x08000 "                                           \
         "will cause tile(sprite) #1 to appear at top left when map() is called.\n"                                      \
         "To set the tile immediately below this we need to write to 0x08000 + 240, ie 0x080F0.",                        \
@@ -822,12 +849,61 @@ enum
         1,                                                                                                              \
         0,                                                                                                              \
         double,                                                                                                         \
-        tic_mem*, s32 startFreq, s32 endFreq)
+        tic_mem*, s32 startFreq, s32 endFreq)                                                                           \
+                                                                                                                        \
+                                                                                                                        \
+    macro(drawlist,                                                                                                     \
+        "drawlist(list)",                                                                                               \
+                                                                                                                        \
+        "Executes a batch of draw commands packed in a flat array of integers.\n"                                       \
+        "Each command is an opcode followed by its arguments:\n"                                                        \
+        "- 0 = pix x y color\n"                                                                                         \
+        "- 1 = line x0 y0 x1 y1 color\n"                                                                                \
+        "- 2 = rect x y w h color\n"                                                                                    \
+        "- 3 = rectb x y w h color\n"                                                                                   \
+        "- 4 = circ x y radius color\n"                                                                                 \
+        "- 5 = spr id x y colorkey scale flip rotate w h\n"                                                             \
+        "Drawing stops at an unknown opcode or an incomplete command.\n"                                                \
+        "It's much cheaper than calling the functions one by one, e.g. for particle systems with thousands of pixels.", \
+        1,                                                                                                              \
+        1,                                                                                                              \
+        0,                                                                                                              \
+        s32,                                                                                                            \
+        tic_mem*, const s32* list, s32 size)
 
 #define TIC_API_DEF(name, _, __, ___, ____, _____, ret, ...) ret tic_api_##name(__VA_ARGS__);
 TIC_API_LIST(TIC_API_DEF)
 #undef TIC_API_DEF
 
+// profiler zones: VM callbacks, core stages and the api function families called by the cart
+#define TIC_PROFILE_LIST(macro)     \
+    macro(tick,     "TIC")          \
+    macro(scanline, "SCN")          \
+    macro(border,   "BDR")          \
+    macro(overline, "OVR")          \
+    macro(sound,    "SOUND")        \
+    macro(blit,     "BLIT")         \
+    macro(draw,     "API DRAW")     \
+    macro(audio,    "API SOUND")    \
+    macro(memory,   "API MEMORY")   \
+    macro(input,    "API INPUT")    \
+    macro(system,   "API SYSTEM")
+
+typedef enum
+{
+#define TIC_PROFILE_DEF(name, _) tic_profile_##name,
+    TIC_PROFILE_LIST(TIC_PROFILE_DEF)
+#undef TIC_PROFILE_DEF
+    tic_profile_count,
+    tic_profile_api = tic_profile_draw,
+} tic_profile_zone;
+
+typedef struct
+{
+    double time[tic_profile_count]; // ms spent in the zone during the last frame
+    u32 calls[tic_profile_count];
+} tic_profile_frame;
+
 struct tic_mem
 {
     tic80           product;
@@ -863,12 +939,40 @@ tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format);
 void tic_core_close(tic_mem* memory);
 void tic_core_pause(tic_mem* memory);
 void tic_core_resume(tic_mem* memory);
+// fft() reads the capture device of FFT_Open(), the host turns it on for the cores that use it
+void tic_core_fft(tic_mem* memory, bool enabled);
+
+// save states of RAM, the core state and the sub-frame audio, the script VM isn't included,
+// the size depends on the sample rate
+u32 tic_core_snapshot_size(tic_mem* memory);
+void tic_core_snapshot(tic_mem* memory, void* buffer);
+bool tic_core_restore(tic_mem* memory, const void* buffer, u32 size);
 void tic_core_tick_start(tic_mem* memory);
 void tic_core_tick(tic_mem* memory, tic_tick_data* data);
 void tic_core_tick_end(tic_mem* memory);
+// token of the frame running from tic_core_tick_start() to the end of tic_core_blit(), 0 between frames
+u32 tic_core_frame(tic_mem* memory);
+// stops the script with an error as soon as possible if `frame` is still running, returns false
+// once it's over, it's meant for watchdogs and can be called from another thread
+bool tic_core_interrupt(tic_mem* memory, u32 frame);
 void tic_core_synth_sound(tic_mem* tic);
+
+// offline rendering through the sound path only, the script and video aren't touched
+// sfx and music are taken from RAM and the samples come at the core sample rate
+void tic_core_render_music(tic_mem* tic, s32 track, bool sustain, u8 mute);
+void tic_core_render_sfx(tic_mem* tic, s32 index);
+// writes up to `frames` interleaved stereo frames, fewer once the sound has ended
+s32 tic_core_render_sound(tic_mem* tic, s16* buffer, s32 frames);
 void tic_core_blit(tic_mem* tic);
 void tic_core_blit_ex(tic_mem* tic, tic_blit_callback clb);
+void tic_core_invalidate(tic_mem* tic, s32 top, s32 bottom);
+
+// pass a counter to start profiling and NULL to stop it
+void tic_core_profile(tic_mem* tic, u64 (*counter)(), u64 (*freq)());
+const tic_profile_frame* tic_core_profile_frame(tic_mem* tic);
+void tic_core_profile_trace(tic_mem* tic, bool record);
+// recorded trace in Chrome trace event format, must be freed by the caller
+char* tic_core_profile_json(tic_mem* tic, s32* size);
 
 #define VBANK(tic, bank)                                \
     bool MACROVAR(_bank_) = tic_api_vbank(tic, bank);   \
@@ -27,18 +27,102 @@
 
 #define FENNEL_CODE(...) #__VA_ARGS__
 
-static const char* execute_fennel_src = FENNEL_CODE(
-  io = { read = true }
+static const char* compile_fennel_src = FENNEL_CODE(
   local fennel = require("fennel")
   debug.traceback = fennel.traceback
   local opts = {allowedGlobals = false, ["error-pinpoint"]={">>", "<<"},
                 filename="game.fnl"}
   local src = ...
-  if(src:find("\n;; +strict: *true")) then opts.allowedGlobals = nil end
-  local ok, msg = pcall(fennel.eval, src, opts)
-  if(not ok) then return msg end
+  if(src:find("\n;; +strict: *true")) then
+    opts.allowedGlobals = {}
+    for name in pairs(_G) do table.insert(opts.allowedGlobals, name) end
+  end
+  local ok, res = pcall(fennel.compileString, src, opts)
+  if(not ok) then return nil, res end
+  return load(res, "@game.fnl")
 );
 
+// a cart restored from bytecode wasn't compiled in this session, fennel.traceback()
+// maps lines with the source map of the compilation, so it's rebuilt on the first error
+static const char* restore_traceback_src = FENNEL_CODE(
+  local src = ...
+  debug.traceback = function(...)
+    local fennel = require("fennel")
+    debug.traceback = fennel.traceback
+    pcall(fennel.compileString, src, {allowedGlobals = false, filename="game.fnl"})
+    return fennel.traceback(...)
+  end
+);
+
+static bool isFennelLoaded(lua_State* fennel)
+{
+    lua_getglobal(fennel, "package");
+    lua_getfield(fennel, -1, "loaded");
+    lua_getfield(fennel, -1, "fennel");
+    bool loaded = !lua_isnil(fennel, -1);
+    lua_pop(fennel, 3);
+
+    return loaded;
+}
+
+// the compiler is only loaded when there is something to compile,
+// carts restored from bytecode don't need it
+static bool loadFennel(lua_State* fennel)
+{
+    if (isFennelLoaded(fennel))
+        return true;
+
+    if (luaL_loadbuffer(fennel, (const char *)loadfennel_lua,
+                        loadfennel_lua_len, "fennel.lua") != LUA_OK)
+    {
+        lua_pushstring(fennel, "failed to load fennel compiler");
+        return false;
+    }
+
+    lua_call(fennel, 0, 0);
+
+    return true;
+}
+
+// package.preload loader, so `(require :fennel)` works in carts restored from bytecode
+static s32 requireFennel(lua_State* fennel)
+{
+    if (!loadFennel(fennel))
+        return lua_error(fennel);
+
+    lua_getglobal(fennel, "package");
+    lua_getfield(fennel, -1, "loaded");
+    lua_getfield(fennel, -1, "fennel");
+
+    return 1;
+}
+
+static bool compileFennel(lua_State* fennel, const char* code)
+{
+    if (!loadFennel(fennel))
+        return false;
+
+    if (luaL_loadbuffer(fennel, compile_fennel_src, strlen(compile_fennel_src), "compile_fennel") != LUA_OK)
+    {
+        lua_pushstring(fennel, "failed to load fennel compiler");
+        return false;
+    }
+
+    lua_pushstring(fennel, code);
+    lua_call(fennel, 1, 2);
+
+    // either the chunk or nil and the error message
+    if (lua_isnil(fennel, -2))
+    {
+        lua_remove(fennel, -2);
+        return false;
+    }
+
+    lua_pop(fennel, 1);
+
+    return true;
+}
+
 static bool initFennel(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -54,28 +138,34 @@ static bool initFennel(tic_mem* tic, const char* code)
 
         lua_settop(fennel, 0);
 
-        if (luaL_loadbuffer(fennel, (const char *)loadfennel_lua,
-                            loadfennel_lua_len, "fennel.lua") != LUA_OK)
-        {
-            core->data->error(core->data->data, "failed to load fennel compiler");
-            return false;
-        }
+        // the compiler expects it, keep it for the carts restored from bytecode too
+        lua_newtable(fennel);
+        lua_pushboolean(fennel, true);
+        lua_setfield(fennel, -2, "read");
+        lua_setglobal(fennel, "io");
 
-        lua_call(fennel, 0, 0);
+        lua_getglobal(fennel, "package");
+        lua_getfield(fennel, -1, "preload");
+        lua_pushcfunction(fennel, requireFennel);
+        lua_setfield(fennel, -2, "fennel");
+        lua_pop(fennel, 2);
 
-        if (luaL_loadbuffer(fennel, execute_fennel_src, strlen(execute_fennel_src), "execute_fennel") != LUA_OK)
+        if (!luaapi_load(core, "fennel", code, compileFennel))
         {
-            core->data->error(core->data->data, "failed to load fennel compiler");
+            core->data->error(core->data->data, lua_tostring(fennel, -1));
             return false;
         }
 
-        lua_pushstring(fennel, code);
-        lua_call(fennel, 1, 1);
-        const char* err = lua_tostring(fennel, -1);
+        if (!isFennelLoaded(fennel))
+        {
+            luaL_loadbuffer(fennel, restore_traceback_src, strlen(restore_traceback_src), "restore_traceback");
+            lua_pushstring(fennel, code);
+            lua_call(fennel, 1, 0);
+        }
 
-        if (err)
+        if (lua_pcall(fennel, 0, 0, 0) != LUA_OK)
         {
-            core->data->error(core->data->data, err);
+            core->data->error(core->data->data, lua_tostring(fennel, -1));
             return false;
         }
     }
@@ -172,18 +262,14 @@ static void evalFennel(tic_mem* tic, const char* code) {
 
     lua_settop(fennel, 0);
 
-    if (luaL_loadbuffer(fennel, execute_fennel_src, strlen(execute_fennel_src), "execute_fennel") != LUA_OK)
+    if (!compileFennel(fennel, code) || lua_pcall(fennel, 0, 0, 0) != LUA_OK)
     {
-        core->data->error(core->data->data, "failed to load fennel compiler");
-    }
-
-    lua_pushstring(fennel, code);
-    lua_call(fennel, 1, 1);
-    const char* err = lua_tostring(fennel, -1);
+        const char* err = lua_tostring(fennel, -1);
 
-    if (err)
-    {
-        core->data->error(core->data->data, err);
+        if (err)
+        {
+            core->data->error(core->data->data, err);
+        }
     }
 }
 
@@ -210,6 +296,8 @@ TIC_EXPORT const tic_script EXPORT_SCRIPT(Fennel) =
         .border         = luaapi_bdr,
         .menu           = luaapi_menu,
       },
+
+      .interrupt          = luaapi_interrupt,
     },
 
     .getOutline         = getFennelOutline,
@@ -81,6 +81,7 @@ static Janet janet_fget(int32_t argc, Janet* argv);
 static Janet janet_fset(int32_t argc, Janet* argv);
 static Janet janet_fft(int32_t argc, Janet* argv);
 static Janet janet_ffts(int32_t argc, Janet* argv);
+static Janet janet_drawlist(int32_t argc, Janet* argv);
 
 static void closeJanet(tic_mem* tic);
 static bool initJanet(tic_mem* tic, const char* code);
@@ -146,6 +147,7 @@ static const JanetReg janet_c_functions[] =
     {"fset", janet_fset, NULL},
     {"fft", janet_fft, NULL},
     {"ffts", janet_ffts, NULL},
+    {"drawlist", janet_drawlist, NULL},
     {NULL, NULL, NULL}
 };
 
@@ -166,9 +168,30 @@ static const char* const JanetKeywords[] =
 };
 
 static JanetFiber* GameFiber = NULL;
+
+// SCN/BDR run for every screen row, keep the functions resolved
+// once a frame instead of looking them up by name every time
+static struct
+{
+    JanetFunction* scn;
+    JanetFunction* scanline;
+    JanetFunction* bdr;
+} Callbacks;
 static JanetBuffer *errBuffer;
 static tic_core* CurrentMachine = NULL;
 
+// an interrupt can only be cleared since 1.28, older interpreters aren't interrupted
+#if JANET_VERSION_MAJOR > 1 || (JANET_VERSION_MAJOR == 1 && JANET_VERSION_MINOR >= 28)
+#   define JANET_INTERRUPT
+#endif
+
+#if defined(JANET_INTERRUPT)
+// the interpreter of the thread running the cart and the token of the frame it was
+// interrupted in, the interrupt holds until the interpreter is told it was handled
+static JanetVM* Interpreter = NULL;
+static tic_atomic InterruptedFrame;
+#endif
+
 
 static inline tic_core* getJanetMachine(void)
 {
@@ -1084,6 +1107,33 @@ static Janet janet_ffts(int32_t argc, Janet* argv)
     return janet_wrap_number(core->api.fft(tic, start_freq, end_freq));
 }
 
+static Janet janet_drawlist(int32_t argc, Janet* argv)
+{
+    janet_fixarity(argc, 1);
+
+    JanetView view = janet_getindexed(argv, 0);
+    s32 list[TIC_DRAWLIST_CHUNK];
+
+    tic_core* core = getJanetMachine(); tic_mem* tic = (tic_mem*)core;
+
+    for(s32 pos = 0; pos < view.len;)
+    {
+        s32 count = MIN(view.len - pos, COUNT_OF(list));
+
+        for(s32 i = 0; i < count; i++)
+            list[i] = (s32)janet_getinteger(view.items, pos + i);
+
+        s32 done = core->api.drawlist(tic, list, count);
+
+        if(done == 0)
+            break;
+
+        pos += done;
+    }
+
+    return janet_wrap_nil();
+}
+
 /* ***************** */
 static void reportError(tic_core* core, Janet result)
 {
@@ -1092,6 +1142,44 @@ static void reportError(tic_core* core, Janet result)
     core->data->error(core->data->data, (char*)errBuffer->data);
 }
 
+static void reportSignal(tic_core* core, JanetSignal status, Janet result)
+{
+    if (status == JANET_SIGNAL_INTERRUPT) {
+        core->data->error(core->data->data, "the script was interrupted, the frame took too long");
+    } else {
+        reportError(core, result);
+    }
+}
+
+#if defined(JANET_INTERRUPT)
+// called from the watchdog thread, the interpreter suspends the fiber at the next
+// loop or call and keeps doing it for the rest of the frame
+static void interruptJanet(tic_mem* tic)
+{
+    u32 frame = tic_core_frame(tic), prev;
+
+    janet_interpreter_interrupt(Interpreter);
+
+    while (!tic_atomic_cas(&InterruptedFrame, prev = tic_atomic_load(&InterruptedFrame), frame));
+
+    if (prev) {
+        janet_interpreter_interrupt_handled(Interpreter);
+    }
+}
+
+// clears an interrupt left from an earlier frame, the script could have returned before it was seen
+static void clearInterrupt(tic_core* core)
+{
+    u32 frame = tic_atomic_load(&InterruptedFrame);
+
+    if (frame && frame != tic_core_frame((tic_mem*)core) && tic_atomic_cas(&InterruptedFrame, frame, 0)) {
+        janet_interpreter_interrupt_handled(Interpreter);
+    }
+}
+#else
+static inline void clearInterrupt(tic_core* core) {}
+#endif
+
 
 static void closeJanet(tic_mem* tic)
 {
@@ -1102,7 +1190,12 @@ static void closeJanet(tic_mem* tic)
         core->currentVM = NULL;
         CurrentMachine = NULL;
         errBuffer = NULL;
+#if defined(JANET_INTERRUPT)
+        Interpreter = NULL;
+        tic_atomic_store(&InterruptedFrame, 0);
+#endif
         GameFiber = NULL;
+        ZEROMEM(Callbacks);
     }
 }
 
@@ -1121,6 +1214,9 @@ static bool initJanet(tic_mem* tic, const char* code)
     janet_table_put(janet_unwrap_table(module_cache), janet_cstringv("tic80"), janet_wrap_table(sub_env));
 
     tic_core* core = (tic_core*)tic;
+#if defined(JANET_INTERRUPT)
+    Interpreter = janet_local_vm();
+#endif
     CurrentMachine = core;
     core->currentVM = (JanetTable*)janet_core_env(NULL);
 
@@ -1152,6 +1248,34 @@ static void evalJanet(tic_mem* tic, const char* code)
 }
 
 
+static JanetFunction* refCallback(tic_core* core, JanetFunction* ref, const char* name)
+{
+    if (ref) {
+        janet_gcunroot(janet_wrap_function(ref));
+    }
+
+    Janet pre_fn;
+    (void)janet_resolve(core->currentVM, janet_csymbol(name), &pre_fn);
+
+    if (janet_type(pre_fn) != JANET_FUNCTION) {
+        return NULL;
+    }
+
+    // keep it alive even if the cart rebinds the name
+    janet_gcroot(pre_fn);
+    return janet_unwrap_function(pre_fn);
+}
+
+static void refCallbacks(tic_core* core)
+{
+    Callbacks.scn = refCallback(core, Callbacks.scn, SCN_FN);
+    Callbacks.scanline = refCallback(core, Callbacks.scanline, "scanline");
+    Callbacks.bdr = refCallback(core, Callbacks.bdr, BDR_FN);
+
+    core->state.defined.scanline = Callbacks.scn != NULL || Callbacks.scanline != NULL;
+    core->state.defined.border = Callbacks.bdr != NULL;
+}
+
 /*
  * Find a function called TIC_FN and execute it. If we can't find it, then
  * it is a problem.
@@ -1160,6 +1284,8 @@ static void callJanetTick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
 
+    clearInterrupt(core);
+
     // Load the TIC function
     Janet pre_fn;
     (void)janet_resolve(core->currentVM, janet_csymbol(TIC_FN), &pre_fn);
@@ -1174,7 +1300,7 @@ static void callJanetTick(tic_mem* tic)
     JanetSignal status = janet_pcall(tic_fn, 0, NULL, &result, &GameFiber);
 
     if (status != JANET_SIGNAL_OK) {
-        reportError(core, result);
+        reportSignal(core, status, result);
     }
 
 #if defined(BUILD_DEPRECATED)
@@ -1185,10 +1311,13 @@ static void callJanetTick(tic_mem* tic)
         JanetSignal status = janet_pcall(ovr_fn, 0, NULL, &result, &GameFiber);
 
         if (status != JANET_SIGNAL_OK) {
-            reportError(core, result);
+            reportSignal(core, status, result);
         }
     }
 #endif
+
+    // pick up SCN/BDR defined or replaced by the cart since the last frame
+    refCallbacks(core);
 }
 
 /*
@@ -1199,6 +1328,8 @@ static void callJanetBoot(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
 
+    clearInterrupt(core);
+
     Janet pre_fn;
     (void)janet_resolve(core->currentVM, janet_csymbol(BOOT_FN), &pre_fn);
 
@@ -1211,7 +1342,7 @@ static void callJanetBoot(tic_mem* tic)
     JanetSignal status = janet_pcall(boot_fn, 0, NULL, &result, &GameFiber);
 
     if (status != JANET_SIGNAL_OK) {
-        reportError(core, result);
+        reportSignal(core, status, result);
     }
 }
 
@@ -1236,19 +1367,36 @@ static void callJanetIntCallback(tic_mem* tic, s32 value, void* data, const char
     JanetSignal status = janet_pcall(fn, 1, argv, &result, &GameFiber);
 
     if (status != JANET_SIGNAL_OK) {
-        reportError(core, result);
+        reportSignal(core, status, result);
+    }
+}
+
+static void callJanetRefCallback(tic_mem* tic, JanetFunction* fn, s32 value)
+{
+    tic_core* core = (tic_core*)tic;
+
+    if (!fn) {
+        return;
+    }
+
+    Janet result = janet_wrap_nil();
+    Janet argv[] = { janet_wrap_integer(value), };
+    JanetSignal status = janet_pcall(fn, 1, argv, &result, &GameFiber);
+
+    if (status != JANET_SIGNAL_OK) {
+        reportSignal(core, status, result);
     }
 }
 
 static void callJanetScanline(tic_mem* tic, s32 row, void* data)
 {
-    callJanetIntCallback(tic, row, data, SCN_FN);
-    callJanetIntCallback(tic, row, data, "scanline");
+    callJanetRefCallback(tic, Callbacks.scn, row);
+    callJanetRefCallback(tic, Callbacks.scanline, row);
 }
 
 static void callJanetBorder(tic_mem* tic, s32 row, void* data)
 {
-    callJanetIntCallback(tic, row, data, BDR_FN);
+    callJanetRefCallback(tic, Callbacks.bdr, row);
 }
 
 static void callJanetMenu(tic_mem* tic, s32 index, void* data)
@@ -1342,6 +1490,10 @@ TIC_EXPORT const tic_script EXPORT_SCRIPT(Janet) =
         .menu           = callJanetMenu,
     },
 
+#if defined(JANET_INTERRUPT)
+    .interrupt          = interruptJanet,
+#endif
+
     .getOutline         = getJanetOutline,
     .eval               = evalJanet,
 
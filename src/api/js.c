@@ -35,6 +35,22 @@ static inline tic_core* getCore(JSContext *ctx)
     return JS_GetContextOpaque(ctx);
 }
 
+// SCN/BDR run for every screen row, keep the functions refreshed
+// once a frame instead of looking them up by name every time,
+// the struct is the opaque of the runtime each cart gets
+typedef struct
+{
+    JSValue global;
+    JSValue scn;
+    JSValue scanline;
+    JSValue bdr;
+} JsCallbacks;
+
+static inline JsCallbacks* getJsCallbacks(JSContext* ctx)
+{
+    return JS_GetRuntimeOpaque(JS_GetRuntime(ctx));
+}
+
 static s32 getInteger(JSContext *ctx, JSValueConst val)
 {
     s32 res;
@@ -117,10 +133,17 @@ static void closeJavascript(tic_mem* tic)
 
     if(ctx)
     {
+        JsCallbacks* callbacks = getJsCallbacks(ctx);
+        JS_FreeValue(ctx, callbacks->global);
+        JS_FreeValue(ctx, callbacks->scn);
+        JS_FreeValue(ctx, callbacks->scanline);
+        JS_FreeValue(ctx, callbacks->bdr);
+
         JSRuntime *rt = JS_GetRuntime(ctx);
         JS_FreeContext(ctx);
         JS_FreeRuntime(rt);
         core->currentVM = NULL;
+        free(callbacks);
     }
 }
 
@@ -219,7 +242,7 @@ static JSValue js_rectb(JSContext *ctx, JSValueConst this_val, s32 argc, JSValue
 
 static JSValue js_spr(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueConst *argv)
 {
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 index = getInteger2(ctx, argv[0], 0);
@@ -449,7 +472,7 @@ static JSValue js_map(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueCo
     s32 sy = getInteger2(ctx, argv[5], 0);
     s32 scale = getInteger2(ctx, argv[7], 1);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(JS_IsArray(ctx, argv[6]))
@@ -827,7 +850,7 @@ static JSValue js_textri(JSContext *ctx, JSValueConst this_val, s32 argc, JSValu
     tic_core* core = getCore(ctx); tic_mem* tic = (tic_mem*)core;
     bool use_map = JS_ToBool(ctx, argv[12]);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     if(JS_IsArray(ctx, argv[13]))
     {
@@ -869,7 +892,7 @@ static JSValue js_ttri(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueC
     tic_core* core = getCore(ctx); tic_mem* tic = (tic_mem*)core;
     tic_texture_src src = getInteger(ctx, argv[12]);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     if(JS_IsArray(ctx, argv[13]))
     {
@@ -1032,6 +1055,53 @@ static JSValue js_ffts(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueC
     return JS_NewFloat64(ctx, core->api.ffts(tic, start_freq, end_freq));
 }
 
+static JSValue js_drawlist(JSContext *ctx, JSValueConst this_val, s32 argc, JSValueConst *argv)
+{
+    tic_core* core = getCore(ctx); tic_mem* tic = (tic_mem*)core;
+
+    if(argc < 1 || !JS_IsObject(argv[0]))
+    {
+        throwError(ctx, "drawlist() expects an array");
+        return JS_UNDEFINED;
+    }
+
+    // plain arrays and typed arrays both work here
+    JSValue length = JS_GetPropertyStr(ctx, argv[0], "length");
+    s32 size = getInteger2(ctx, length, 0);
+    JS_FreeValue(ctx, length);
+
+    s32 list[TIC_DRAWLIST_CHUNK];
+
+    for(s32 pos = 0; pos < size;)
+    {
+        s32 count = MIN(size - pos, COUNT_OF(list));
+
+        for(s32 i = 0; i < count; i++)
+        {
+            JSValue val = JS_GetPropertyUint32(ctx, argv[0], pos + i);
+            list[i] = getInteger(ctx, val);
+            JS_FreeValue(ctx, val);
+        }
+
+        s32 done = core->api.drawlist(tic, list, count);
+
+        if(done == 0)
+            break;
+
+        pos += done;
+    }
+
+    return JS_UNDEFINED;
+}
+
+// QuickJS polls it every few thousand operations, a non zero result
+// throws an uncatchable "interrupted" error out of the script
+static s32 interruptJavascript(JSRuntime* rt, void* opaque)
+{
+    tic_core* core = opaque;
+    return tic_core_interrupted(core);
+}
+
 static bool initJavascript(tic_mem* tic, const char* code)
 {
     closeJavascript(tic);
@@ -1042,6 +1112,11 @@ static bool initJavascript(tic_mem* tic, const char* code)
     tic_core* core = (tic_core*)tic;
     core->currentVM = ctx;
     JS_SetContextOpaque(ctx, core);
+    JS_SetInterruptHandler(rt, interruptJavascript, core);
+
+    JsCallbacks* callbacks = malloc(sizeof(JsCallbacks));
+    *callbacks = (JsCallbacks){JS_GetGlobalObject(ctx), JS_UNDEFINED, JS_UNDEFINED, JS_UNDEFINED};
+    JS_SetRuntimeOpaque(rt, callbacks);
 
     {
         JSValue global = JS_GetGlobalObject(ctx);
@@ -1057,6 +1132,16 @@ static bool initJavascript(tic_mem* tic, const char* code)
 
 #undef  API_FUNC_DEF
 
+        // 'ram' aliases the whole RAM, so effects can touch it without a peek/poke call per byte,
+        // the pointer stays put while a JS cart runs and vbank() swaps the contents, not the pointer
+        {
+            JSValue buffer = JS_NewArrayBuffer(ctx, (u8*)core->memory.ram, TIC_RAM_SIZE, NULL, NULL, false);
+            JSValue ctor = JS_GetPropertyStr(ctx, global, "Uint8Array");
+            JS_SetPropertyStr(ctx, global, "ram", JS_CallConstructor(ctx, ctor, 1, &buffer));
+            JS_FreeValue(ctx, ctor);
+            JS_FreeValue(ctx, buffer);
+        }
+
         JS_FreeValue(ctx, global);
     }
 
@@ -1100,6 +1185,32 @@ static bool callFunc(JSContext* ctx, JSValue func, JSValue this_val)
     return true;
 }
 
+static JSValue refCallback(JSContext* ctx, JSValue ref, const char* name)
+{
+    JS_FreeValue(ctx, ref);
+
+    JSValue func = JS_GetPropertyStr(ctx, getJsCallbacks(ctx)->global, name);
+
+    if(JS_IsFunction(ctx, func))
+        return func;
+
+    JS_FreeValue(ctx, func);
+    return JS_UNDEFINED;
+}
+
+static void refCallbacks(tic_core* core)
+{
+    JSContext* ctx = core->currentVM;
+    JsCallbacks* callbacks = getJsCallbacks(ctx);
+
+    callbacks->scn = refCallback(ctx, callbacks->scn, SCN_FN);
+    callbacks->scanline = refCallback(ctx, callbacks->scanline, "scanline");
+    callbacks->bdr = refCallback(ctx, callbacks->bdr, BDR_FN);
+
+    core->state.defined.scanline = !JS_IsUndefined(callbacks->scn) || !JS_IsUndefined(callbacks->scanline);
+    core->state.defined.border = !JS_IsUndefined(callbacks->bdr);
+}
+
 static void callJavascriptTick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1148,6 +1259,9 @@ static void callJavascriptTick(tic_mem* tic)
                 }
 #endif
             }
+
+            // pick up SCN/BDR defined or replaced by the cart since the last frame
+            refCallbacks(core);
         }
         else core->data->error(core->data->data, "'function TIC()...' isn't found :(");
 
@@ -1156,6 +1270,12 @@ static void callJavascriptTick(tic_mem* tic)
     }
 }
 
+static void callJavascriptRefCallback(JSContext* ctx, JSValue func, s32 value)
+{
+    if(!JS_IsUndefined(func))
+        callFunc1(ctx, func, getJsCallbacks(ctx)->global, JS_NewInt32(ctx, value));
+}
+
 static void callJavascriptIntCallback(tic_mem* tic, s32 value, void* data, const char* name)
 {
     tic_core* core = (tic_core*)tic;
@@ -1175,15 +1295,24 @@ static void callJavascriptIntCallback(tic_mem* tic, s32 value, void* data, const
 
 static void callJavascriptScanline(tic_mem* tic, s32 row, void* data)
 {
-    callJavascriptIntCallback(tic, row, data, SCN_FN);
+    JSContext* ctx = ((tic_core*)tic)->currentVM;
+
+    if(ctx)
+    {
+        const JsCallbacks* callbacks = getJsCallbacks(ctx);
+        callJavascriptRefCallback(ctx, callbacks->scn, row);
 
-    // try to call old scanline
-    callJavascriptIntCallback(tic, row, data, "scanline");
+        // try to call old scanline
+        callJavascriptRefCallback(ctx, callbacks->scanline, row);
+    }
 }
 
 static void callJavascriptBorder(tic_mem* tic, s32 row, void* data)
 {
-    callJavascriptIntCallback(tic, row, data, BDR_FN);
+    JSContext* ctx = ((tic_core*)tic)->currentVM;
+
+    if(ctx)
+        callJavascriptRefCallback(ctx, getJsCallbacks(ctx)->bdr, row);
 }
 
 static void callJavascriptMenu(tic_mem* tic, s32 index, void* data)
@@ -29,6 +29,11 @@
 #include <lualib.h>
 #include <ctype.h>
 
+static bool compileLua(lua_State* lua, const char* code)
+{
+    return luaL_loadstring(lua, code) == LUA_OK;
+}
+
 static bool initLua(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -45,7 +50,7 @@ static bool initLua(tic_mem* tic, const char* code)
 
         lua_settop(lua, 0);
 
-        if(luaL_loadstring(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
+        if(!luaapi_load(core, "lua", code, compileLua) || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
         {
             core->data->error(core->data->data, lua_tostring(lua, -1));
             return false;
@@ -224,6 +229,8 @@ TIC_EXPORT const tic_script EXPORT_SCRIPT(Lua) =
         .border         = luaapi_bdr,
         .menu           = luaapi_menu,
       },
+
+      .interrupt          = luaapi_interrupt,
     },
 
     .getOutline         = getLuaOutline,
@@ -21,7 +21,10 @@
 // SOFTWARE.
 
 #include "core/core.h"
+#include "luaapi.h"
+#include "ext/md5.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <lua.h>
 #include <lauxlib.h>
@@ -30,22 +33,78 @@
 
 extern bool parse_note(const char* noteStr, s32* note, s32* octave);
 
+typedef struct
+{
+    tic_core* core;
+
+    // SCN/BDR run for every screen row, they are called through registry
+    // references refreshed once a frame instead of being looked up by name
+    struct
+    {
+        s32 scn;
+        s32 scanline;
+        s32 bdr;
+    } callbacks;
+
+    // the Lua thread the script runs on, an interrupt has to reach a stuck coroutine too,
+    // the lock keeps it from being switched and collected while the watchdog arms it
+    struct
+    {
+        lua_State* running;
+        tic_atomic lock;
+    } thread;
+} LuaVm;
+
 static inline s32 getLuaNumber(lua_State* lua, s32 index)
 {
-    return (s32)lua_tonumber(lua, index);
+    // most arguments are integers, don't round trip them through a double
+    s32 isint;
+    lua_Integer value = lua_tointegerx(lua, index, &isint);
+    return isint ? (s32)value : (s32)lua_tonumber(lua, index);
 }
 
 static void registerLuaFunction(tic_core* core, lua_CFunction func, const char *name)
 {
-    lua_pushlightuserdata(core->currentVM, core);
-    lua_pushcclosure(core->currentVM, func, 1);
+    lua_pushcfunction(core->currentVM, func);
     lua_setglobal(core->currentVM, name);
 }
 
-static tic_core* getLuaCore(lua_State* lua)
+// the VM data is kept in the state's extra space, new coroutines inherit it from the main thread
+static inline LuaVm* getLuaVm(lua_State* lua)
+{
+    return *(LuaVm**)lua_getextraspace(lua);
+}
+
+static inline tic_core* getLuaCore(lua_State* lua)
 {
-    tic_core* core = lua_touserdata(lua, lua_upvalueindex(1));
-    return core;
+    return getLuaVm(lua)->core;
+}
+
+static s32 getLuaColors(lua_State* lua, s32 index, u8* colors)
+{
+    if(!lua_istable(lua, index))
+    {
+        colors[0] = getLuaNumber(lua, index);
+        return 1;
+    }
+
+    s32 count = 0;
+
+    for(; count < TIC_PALETTE_SIZE; count++)
+    {
+        lua_rawgeti(lua, index, count + 1);
+
+        bool number = lua_isnumber(lua, -1);
+        if(number)
+            colors[count] = getLuaNumber(lua, -1);
+
+        lua_pop(lua, 1);
+
+        if(!number)
+            break;
+    }
+
+    return count;
 }
 
 static s32 lua_peek(lua_State* lua)
@@ -472,7 +531,7 @@ static s32 lua_textri(lua_State* lua)
 
         tic_core* core = getLuaCore(lua);
         tic_mem* tic = (tic_mem*)core;
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         bool use_map = false;
 
@@ -483,29 +542,7 @@ static s32 lua_textri(lua_State* lua)
         //  check for chroma
         if(top >= 14)
         {
-            if(lua_istable(lua, 14))
-            {
-                for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
-                {
-                    lua_rawgeti(lua, 14, i);
-                    if(lua_isnumber(lua, -1))
-                    {
-                        colors[i-1] = getLuaNumber(lua, -1);
-                        count++;
-                        lua_pop(lua, 1);
-                    }
-                    else
-                    {
-                        lua_pop(lua, 1);
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                colors[0] = getLuaNumber(lua, 14);
-                count = 1;
-            }
+            count = getLuaColors(lua, 14, colors);
         }
 
         core->api.textri(tic,
@@ -537,7 +574,7 @@ static s32 lua_ttri(lua_State* lua)
 
         tic_core* core = getLuaCore(lua);
         tic_mem* tic = (tic_mem*)core;
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         tic_texture_src src = tic_tiles_texture;
 
@@ -551,29 +588,7 @@ static s32 lua_ttri(lua_State* lua)
         //  check for chroma
         if(top >= 14)
         {
-            if(lua_istable(lua, 14))
-            {
-                for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
-                {
-                    lua_rawgeti(lua, 14, i);
-                    if(lua_isnumber(lua, -1))
-                    {
-                        colors[i-1] = getLuaNumber(lua, -1);
-                        count++;
-                        lua_pop(lua, 1);
-                    }
-                    else
-                    {
-                        lua_pop(lua, 1);
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                colors[0] = getLuaNumber(lua, 14);
-                count = 1;
-            }
+            count = getLuaColors(lua, 14, colors);
         }
 
         float z[3] = {0, 0, 0};
@@ -701,7 +716,7 @@ static s32 lua_spr(lua_State* lua)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 1)
@@ -715,29 +730,7 @@ static s32 lua_spr(lua_State* lua)
 
             if(top >= 4)
             {
-                if(lua_istable(lua, 4))
-                {
-                    for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
-                    {
-                        lua_rawgeti(lua, 4, i);
-                        if(lua_isnumber(lua, -1))
-                        {
-                            colors[i-1] = getLuaNumber(lua, -1);
-                            count++;
-                            lua_pop(lua, 1);
-                        }
-                        else
-                        {
-                            lua_pop(lua, 1);
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    colors[0] = getLuaNumber(lua, 4);
-                    count = 1;
-                }
+                count = getLuaColors(lua, 4, colors);
 
                 if(top >= 5)
                 {
@@ -815,23 +808,54 @@ static s32 lua_mset(lua_State* lua)
 typedef struct
 {
     lua_State* lua;
-    s32 reg;
+    s32 index;
+    s32 x;
+    s32 y;
+    s32 width;
 } RemapData;
 
 static void remapCallback(void* data, s32 x, s32 y, RemapResult* result)
 {
     RemapData* remap = (RemapData*)data;
     lua_State* lua = remap->lua;
+    s32 top = lua_gettop(lua);
 
-    lua_rawgeti(lua, LUA_REGISTRYINDEX, remap->reg);
+    lua_pushvalue(lua, remap->index);
     lua_pushinteger(lua, result->index);
     lua_pushinteger(lua, x);
     lua_pushinteger(lua, y);
-    lua_pcall(lua, 3, 3, 0);
 
-    result->index = getLuaNumber(lua, -3);
-    result->flip = getLuaNumber(lua, -2);
-    result->rotate = getLuaNumber(lua, -1);
+    if(lua_pcall(lua, 3, 3, 0) == LUA_OK)
+    {
+        result->index = getLuaNumber(lua, -3);
+        result->flip = getLuaNumber(lua, -2);
+        result->rotate = getLuaNumber(lua, -1);
+    }
+
+    lua_settop(lua, top);
+}
+
+// remap table covers the drawn region row by row, a cell value packs
+// the tile index in the low 8 bits, flip in bits 8-9 and rotate in bits 10-11
+static void remapTable(void* data, s32 x, s32 y, RemapResult* result)
+{
+    RemapData* remap = (RemapData*)data;
+    lua_State* lua = remap->lua;
+
+    s32 cell = tic_modulo(y - remap->y, TIC_MAP_HEIGHT) * remap->width
+        + tic_modulo(x - remap->x, TIC_MAP_WIDTH) + 1;
+
+    s32 isint;
+    lua_rawgeti(lua, remap->index, cell);
+    lua_Integer value = lua_tointegerx(lua, -1, &isint);
+    lua_pop(lua, 1);
+
+    if(isint)
+    {
+        result->index = value & 0xff;
+        result->flip = (value >> 8) & 0x3;
+        result->rotate = (value >> 10) & 0x3;
+    }
 }
 
 static s32 lua_map(lua_State* lua)
@@ -843,7 +867,7 @@ static s32 lua_map(lua_State* lua)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 top = lua_gettop(lua);
@@ -865,29 +889,7 @@ static s32 lua_map(lua_State* lua)
 
                 if(top >= 7)
                 {
-                    if(lua_istable(lua, 7))
-                    {
-                        for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
-                        {
-                            lua_rawgeti(lua, 7, i);
-                            if(lua_isnumber(lua, -1))
-                            {
-                                colors[i-1] = getLuaNumber(lua, -1);
-                                count++;
-                                lua_pop(lua, 1);
-                            }
-                            else
-                            {
-                                lua_pop(lua, 1);
-                                break;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        colors[0] = getLuaNumber(lua, 7);
-                        count = 1;
-                    }
+                    count = getLuaColors(lua, 7, colors);
 
                     if(top >= 8)
                     {
@@ -895,18 +897,17 @@ static s32 lua_map(lua_State* lua)
 
                         if(top >= 9)
                         {
-                            if (lua_isfunction(lua, 9))
-                            {
-                                s32 remap = luaL_ref(lua, LUA_REGISTRYINDEX);
+                            bool table = lua_istable(lua, 9);
 
-                                RemapData data = {lua, remap};
+                            if (table || lua_isfunction(lua, 9))
+                            {
+                                RemapData data = {lua, 9, tic_modulo(x, TIC_MAP_WIDTH), tic_modulo(y, TIC_MAP_HEIGHT), w};
 
                                 tic_core* core = getLuaCore(lua);
                                 tic_mem* tic = (tic_mem*)core;
 
-                                core->api.map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
-
-                                luaL_unref(lua, LUA_REGISTRYINDEX, data.reg);
+                                core->api.map(tic, x, y, w, h, sx, sy, colors, count, scale,
+                                    table ? remapTable : remapCallback, &data);
 
                                 return 0;
                             }
@@ -1595,6 +1596,42 @@ static s32 lua_ffts(lua_State* lua)
     return 0;
 }
 
+static s32 lua_drawlist(lua_State* lua)
+{
+    if(lua_gettop(lua) == 1 && lua_istable(lua, 1))
+    {
+        tic_core* core = getLuaCore(lua);
+        tic_mem* tic = (tic_mem*)core;
+
+        s32 size = (s32)lua_rawlen(lua, 1);
+        s32 list[TIC_DRAWLIST_CHUNK];
+
+        for(s32 pos = 0; pos < size;)
+        {
+            s32 count = MIN(size - pos, COUNT_OF(list));
+
+            for(s32 i = 0; i < count; i++)
+            {
+                lua_rawgeti(lua, 1, pos + i + 1);
+                list[i] = getLuaNumber(lua, -1);
+                lua_pop(lua, 1);
+            }
+
+            s32 done = core->api.drawlist(tic, list, count);
+
+            if(done == 0)
+                break;
+
+            pos += done;
+        }
+
+        return 0;
+    }
+
+    luaL_error(lua, "invalid params, drawlist(list)\n");
+    return 0;
+}
+
 static int lua_dofile(lua_State *lua)
 {
     luaL_error(lua, "unknown method: \"dofile\"\n");
@@ -1609,6 +1646,104 @@ static int lua_loadfile(lua_State *lua)
     return 0;
 }
 
+// the hook stays armed and fails every instruction, so a pcall() in the stuck loop can't catch
+// the error for good, it's removed in the next frame
+static void interruptHook(lua_State* lua, lua_Debug* ar)
+{
+    luaL_error(lua, "the script was interrupted, the frame took too long");
+}
+
+static void lockLuaVm(LuaVm* vm)
+{
+    while(!tic_atomic_cas(&vm->thread.lock, 0, 1));
+}
+
+static void unlockLuaVm(LuaVm* vm)
+{
+    tic_atomic_store(&vm->thread.lock, 0);
+}
+
+// a thread that runs in an interrupted frame gets the hook and a hook left from an earlier frame is removed
+static void setRunningThread(LuaVm* vm, lua_State* thread)
+{
+    lockLuaVm(vm);
+
+    vm->thread.running = thread;
+
+    if(tic_core_interrupted(vm->core))
+        lua_sethook(thread, interruptHook, LUA_MASKCOUNT, 1);
+    else if(lua_gethook(thread) == interruptHook)
+        lua_sethook(thread, NULL, 0, 0);
+
+    unlockLuaVm(vm);
+}
+
+// runs the wrapped coroutine function from the upvalue as the running thread `co`
+static s32 resumeThread(lua_State* lua, lua_State* co)
+{
+    LuaVm* vm = getLuaVm(lua);
+    s32 top = lua_gettop(lua);
+
+    lua_pushvalue(lua, lua_upvalueindex(1));
+    lua_insert(lua, 1);
+
+    setRunningThread(vm, co);
+    s32 status = lua_pcall(lua, top, LUA_MULTRET, 0);
+    setRunningThread(vm, lua);
+
+    return status == LUA_OK ? lua_gettop(lua) : lua_error(lua);
+}
+
+static s32 lua_coresume(lua_State* lua)
+{
+    lua_State* co = lua_tothread(lua, 1);
+    luaL_argexpected(lua, co, 1, "coroutine");
+
+    return resumeThread(lua, co);
+}
+
+static s32 lua_cowrapped(lua_State* lua)
+{
+    return resumeThread(lua, lua_tothread(lua, lua_upvalueindex(2)));
+}
+
+static s32 lua_cowrap(lua_State* lua)
+{
+    lua_pushvalue(lua, lua_upvalueindex(1));
+    lua_insert(lua, 1);
+    lua_call(lua, lua_gettop(lua) - 1, 1);
+
+    // the coroutine is the only upvalue of the closure made by the original wrap()
+    if(lua_getupvalue(lua, -1, 1) && lua_isthread(lua, -1))
+        lua_pushcclosure(lua, lua_cowrapped, 2);
+    else
+        lua_pop(lua, 1);
+
+    return 1;
+}
+
+// coroutine.resume() and wrap() are routed through the VM to know the running thread
+static void wrapCoroutines(lua_State* lua)
+{
+    static const luaL_Reg Functions[] =
+    {
+        {"resume", lua_coresume},
+        {"wrap", lua_cowrap},
+    };
+
+    if(lua_getglobal(lua, LUA_COLIBNAME) == LUA_TTABLE)
+    {
+        for(s32 i = 0; i < COUNT_OF(Functions); i++)
+        {
+            lua_getfield(lua, -1, Functions[i].name);
+            lua_pushcclosure(lua, Functions[i].func, 1);
+            lua_setfield(lua, -2, Functions[i].name);
+        }
+    }
+
+    lua_pop(lua, 1);
+}
+
 void luaapi_open(lua_State *lua)
 {
     static const luaL_Reg loadedlibs[] =
@@ -1643,6 +1778,12 @@ void luaapi_init(tic_core* core)
 #endif
     };
 
+    LuaVm* vm = malloc(sizeof(LuaVm));
+    *vm = (LuaVm){core, {LUA_NOREF, LUA_NOREF, LUA_NOREF}, {core->currentVM}};
+    *(LuaVm**)lua_getextraspace(core->currentVM) = vm;
+
+    wrapCoroutines(core->currentVM);
+
     for (s32 i = 0; i < COUNT_OF(ApiItems); i++)
         registerLuaFunction(core, ApiItems[i].func, ApiItems[i].name);
 
@@ -1656,11 +1797,128 @@ void luaapi_close(tic_mem* tic)
 
     if(core->currentVM)
     {
+        LuaVm* vm = getLuaVm(core->currentVM);
         lua_close(core->currentVM);
         core->currentVM = NULL;
+        free(vm);
     }
 }
 
+// bytecode, cached or embedded in the cart, is prefixed with the hash of the code it was compiled from
+enum {BytecodeHashSize = 16};
+
+typedef struct
+{
+    u8* data;
+    size_t size;
+} BytecodeBuffer;
+
+static void bytecodeHash(const char* lang, const char* code, u8* hash)
+{
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    // bytecode is specific to the Lua version
+    MD5_Update(&ctx, LUA_RELEASE, sizeof LUA_RELEASE);
+    MD5_Update(&ctx, lang, strlen(lang) + 1);
+    MD5_Update(&ctx, code, strlen(code));
+    MD5_Final(hash, &ctx);
+}
+
+static bool loadBytecode(lua_State* lua, const u8* hash, const void* buffer, s32 size)
+{
+    if(size > BytecodeHashSize && memcmp(buffer, hash, BytecodeHashSize) == 0)
+    {
+        if(luaL_loadbufferx(lua, (const char*)buffer + BytecodeHashSize, size - BytecodeHashSize, "bytecode", "b") == LUA_OK)
+            return true;
+
+        lua_pop(lua, 1);
+    }
+
+    return false;
+}
+
+static s32 writeBytecode(lua_State* lua, const void* data, size_t size, void* userdata)
+{
+    BytecodeBuffer* buffer = userdata;
+    u8* ptr = realloc(buffer->data, buffer->size + size);
+
+    if(!ptr)
+        return 1;
+
+    memcpy(ptr + buffer->size, data, size);
+    buffer->data = ptr;
+    buffer->size += size;
+
+    return 0;
+}
+
+static void embedBytecode(tic_binary* section, const void* buffer, s32 size)
+{
+    if(size <= TIC_BINARY_SIZE && (section->size != size || memcmp(section->data, buffer, size)))
+    {
+        memcpy(section->data, buffer, size);
+        section->size = size;
+    }
+}
+
+bool luaapi_load(tic_core* core, const char* lang, const char* code, luaapi_compile compile)
+{
+    lua_State* lua = core->currentVM;
+    const tic_tick_data* data = core->data;
+    tic_binary* section = &core->memory.cart.bytecode;
+
+    u8 hash[BytecodeHashSize];
+    bytecodeHash(lang, code, hash);
+
+    char key[BytecodeHashSize * 2 + 1];
+    for(s32 i = 0; i < BytecodeHashSize; i++)
+        sprintf(key + i * 2, "%02x", hash[i]);
+
+    if(data->bytecode && loadBytecode(lua, hash, section->data, section->size))
+        return true;
+
+    if(data->cacheLoad)
+    {
+        s32 size = 0;
+        void* buffer = data->cacheLoad(data->data, key, &size);
+
+        if(buffer)
+        {
+            bool done = loadBytecode(lua, hash, buffer, size);
+
+            if(done && data->bytecode)
+                embedBytecode(section, buffer, size);
+
+            free(buffer);
+
+            if(done)
+                return true;
+        }
+    }
+
+    if(!compile(lua, code))
+        return false;
+
+    if(data->cacheSave || data->bytecode)
+    {
+        BytecodeBuffer buffer = {0};
+
+        if(writeBytecode(lua, hash, sizeof hash, &buffer) == 0
+            && lua_dump(lua, writeBytecode, &buffer, 0) == 0)
+        {
+            if(data->cacheSave)
+                data->cacheSave(data->data, key, buffer.data, (s32)buffer.size);
+
+            if(data->bytecode)
+                embedBytecode(section, buffer.data, (s32)buffer.size);
+        }
+
+        free(buffer.data);
+    }
+
+    return true;
+}
+
 /*
 ** Message handler which appends stract trace to exceptions.
 ** This function was extractred from lua.c.
@@ -1702,6 +1960,64 @@ static s32 docall (lua_State *lua, s32 narg, s32 nres)
     return status;
 }
 
+static s32 refCallback(lua_State* lua, s32 ref, const char* name)
+{
+    luaL_unref(lua, LUA_REGISTRYINDEX, ref);
+
+    lua_getglobal(lua, name);
+
+    if(lua_isfunction(lua, -1))
+        return luaL_ref(lua, LUA_REGISTRYINDEX);
+
+    lua_pop(lua, 1);
+    return LUA_NOREF;
+}
+
+static void refCallbacks(tic_core* core)
+{
+    lua_State* lua = core->currentVM;
+    LuaVm* vm = getLuaVm(lua);
+
+    vm->callbacks.scn = refCallback(lua, vm->callbacks.scn, SCN_FN);
+    vm->callbacks.scanline = refCallback(lua, vm->callbacks.scanline, "scanline");
+    vm->callbacks.bdr = refCallback(lua, vm->callbacks.bdr, BDR_FN);
+
+    core->state.defined.scanline = vm->callbacks.scn != LUA_NOREF || vm->callbacks.scanline != LUA_NOREF;
+    core->state.defined.border = vm->callbacks.bdr != LUA_NOREF;
+}
+
+static void callLuaRefCallback(tic_mem* tic, s32 ref, s32 value)
+{
+    tic_core* core = (tic_core*)tic;
+    lua_State* lua = core->currentVM;
+
+    if (lua && ref != LUA_NOREF)
+    {
+        lua_rawgeti(lua, LUA_REGISTRYINDEX, ref);
+        lua_pushinteger(lua, value);
+        if(docall(lua, 1, 0) != LUA_OK)
+            core->data->error(core->data->data, lua_tostring(lua, -1));
+    }
+}
+
+// lua_sethook() is safe to call asynchronously, the hook fires on the next instruction,
+// so the VM doesn't pay for a count hook polling a flag while nothing is wrong
+void luaapi_interrupt(tic_mem* tic)
+{
+    tic_core* core = (tic_core*)tic;
+    lua_State* lua = core->currentVM;
+    LuaVm* vm = getLuaVm(lua);
+
+    lockLuaVm(vm);
+
+    lua_sethook(lua, interruptHook, LUA_MASKCOUNT, 1);
+
+    if(vm->thread.running)
+        lua_sethook(vm->thread.running, interruptHook, LUA_MASKCOUNT, 1);
+
+    unlockLuaVm(vm);
+}
+
 void luaapi_tick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1710,6 +2026,9 @@ void luaapi_tick(tic_mem* tic)
 
     if(lua)
     {
+        // the last frame could have been interrupted after the script returned
+        setRunningThread(getLuaVm(lua), lua);
+
         lua_getglobal(lua, TIC_FN);
         if(lua_isfunction(lua, -1))
         {
@@ -1734,6 +2053,9 @@ void luaapi_tick(tic_mem* tic)
                 else lua_pop(lua, 1);
             }
 #endif
+
+            // pick up SCN/BDR defined or replaced by the cart since the last frame
+            refCallbacks(core);
         }
         else
         {
@@ -1763,15 +2085,24 @@ void callLuaIntCallback(tic_mem* tic, s32 value, void* data, const char* name)
 
 void luaapi_scn(tic_mem* tic, s32 row, void* data)
 {
-    callLuaIntCallback(tic, row, data, SCN_FN);
+    lua_State* lua = ((tic_core*)tic)->currentVM;
+
+    if(lua)
+    {
+        const LuaVm* vm = getLuaVm(lua);
+        callLuaRefCallback(tic, vm->callbacks.scn, row);
 
-    // try to call old scanline
-    callLuaIntCallback(tic, row, data, "scanline");
+        // try to call old scanline
+        callLuaRefCallback(tic, vm->callbacks.scanline, row);
+    }
 }
 
 void luaapi_bdr(tic_mem* tic, s32 row, void* data)
 {
-    callLuaIntCallback(tic, row, data, BDR_FN);
+    lua_State* lua = ((tic_core*)tic)->currentVM;
+
+    if(lua)
+        callLuaRefCallback(tic, getLuaVm(lua)->callbacks.bdr, row);
 }
 
 void luaapi_menu(tic_mem* tic, s32 index, void* data)
@@ -36,4 +36,12 @@ void luaapi_scn(tic_mem* tic, s32 row, void* data);
 void luaapi_bdr(tic_mem* tic, s32 row, void* data);
 void luaapi_menu(tic_mem* tic, s32 index, void* data);
 void luaapi_close(tic_mem* tic);
+void luaapi_interrupt(tic_mem* tic);
 void luaapi_open(lua_State *lua);
+
+// pushes the compiled cart chunk or an error message and returns false
+typedef bool(*luaapi_compile)(lua_State* lua, const char* code);
+
+// same as `compile`, but takes the chunk from the bytecode cache or the cart bytecode section
+// if it was compiled from the same code before, freshly compiled chunks are stored to both
+bool luaapi_load(tic_core* core, const char* lang, const char* code, luaapi_compile compile);
@@ -31,13 +31,13 @@ static inline bool isalnum_(char c) {return isalnum(c) || c == '_';}
 
 #define MOON_CODE(...) #__VA_ARGS__
 
-static const char* execute_moonscript_src = MOON_CODE(
+static const char* compile_moonscript_src = MOON_CODE(
     local fn, err = require('moonscript.base').loadstring(...)
 
     if not fn then
         error(err)
     end
-    return fn()
+    return fn
 );
 
 static void setloaded(lua_State* l, char* name)
@@ -55,14 +55,58 @@ static void setloaded(lua_State* l, char* name)
     lua_settop(l, top);
 }
 
+extern s32 luaopen_lpeg(lua_State *lua);
+
+// the compiler is only loaded when there is something to compile,
+// carts restored from bytecode don't need it
+static bool loadMoonscript(lua_State* moon)
+{
+    lua_getglobal(moon, _ms_loadstring);
+    bool loaded = lua_isfunction(moon, -1);
+    lua_pop(moon, 1);
+
+    if (loaded)
+        return true;
+
+    luaopen_lpeg(moon);
+    setloaded(moon, "lpeg");
+    lua_pop(moon, 1);
+
+    if (luaL_loadbuffer(moon, (const char *)moonscript_lua, moonscript_lua_len, "moonscript.lua") != LUA_OK)
+    {
+        lua_pushstring(moon, "failed to load moonscript.lua");
+        return false;
+    }
+
+    lua_call(moon, 0, 0);
+
+    if (luaL_loadbuffer(moon, compile_moonscript_src, strlen(compile_moonscript_src), "compile_moonscript") != LUA_OK)
+    {
+        lua_pushstring(moon, "failed to load moonscript compiler");
+        return false;
+    }
+
+    lua_setglobal(moon, _ms_loadstring);
+
+    return true;
+}
+
+static bool compileMoonscript(lua_State* moon, const char* code)
+{
+    if (!loadMoonscript(moon))
+        return false;
+
+    lua_getglobal(moon, _ms_loadstring);
+    lua_pushstring(moon, code);
+
+    return lua_pcall(moon, 1, 1, 0) == LUA_OK;
+}
+
 static void evalMoonscript(tic_mem* tic, const char* code) {
     tic_core* core = (tic_core*)tic;
     lua_State* lua = core->currentVM;
 
-    lua_getglobal(lua, _ms_loadstring);
-
-    lua_pushstring(lua, code);
-    if (lua_pcall(lua, 1, 1, 0) != LUA_OK)
+    if (!compileMoonscript(lua, code) || lua_pcall(lua, 0, 1, 0) != LUA_OK)
     {
         const char* msg = lua_tostring(lua, -1);
         if (msg)
@@ -72,8 +116,6 @@ static void evalMoonscript(tic_mem* tic, const char* code) {
     }
 }
 
-extern s32 luaopen_lpeg(lua_State *lua);
-
 static bool initMoonscript(tic_mem* tic, const char* code)
 {
     tic_core* core = (tic_core*)tic;
@@ -82,9 +124,6 @@ static bool initMoonscript(tic_mem* tic, const char* code)
     lua_State* lua = core->currentVM = luaL_newstate();
     luaapi_open(lua);
 
-    luaopen_lpeg(lua);
-    setloaded(lua, "lpeg");
-
     luaapi_init(core);
 
     {
@@ -92,25 +131,7 @@ static bool initMoonscript(tic_mem* tic, const char* code)
 
         lua_settop(moon, 0);
 
-        if (luaL_loadbuffer(moon, (const char *)moonscript_lua, moonscript_lua_len, "moonscript.lua") != LUA_OK)
-        {
-            core->data->error(core->data->data, "failed to load moonscript.lua");
-            return false;
-        }
-
-        lua_call(moon, 0, 0);
-
-        if (luaL_loadbuffer(moon, execute_moonscript_src, strlen(execute_moonscript_src), "execute_moonscript") != LUA_OK)
-        {
-            core->data->error(core->data->data, "failed to load moonscript compiler");
-            return false;
-        }
-
-        lua_setglobal(lua, _ms_loadstring);
-        lua_getglobal(lua, _ms_loadstring);
-
-        lua_pushstring(moon, code);
-        if (lua_pcall(moon, 1, 1, 0) != LUA_OK)
+        if (!luaapi_load(core, "moon", code, compileMoonscript) || lua_pcall(moon, 0, 1, 0) != LUA_OK)
         {
             const char* msg = lua_tostring(moon, -1);
 
@@ -214,6 +235,8 @@ TIC_EXPORT const tic_script EXPORT_SCRIPT(Moon) =
         .border         = luaapi_bdr,
         .menu           = luaapi_menu,
       },
+
+      .interrupt          = luaapi_interrupt,
     },
 
     .getOutline         = getMoonOutline,
@@ -430,7 +430,7 @@ static mrb_value mrb_spr(mrb_state* mrb, mrb_value self)
     mrb_int w = 1, h = 1, scale = 1;
     mrb_int flip = tic_no_flip, rotate = tic_no_rotate;
     mrb_value colors_obj;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     mrb_int count = 0;
 
     mrb_int argc = mrb_get_args(mrb, "iii|oiiiii", &index, &x, &y, &colors_obj, &scale, &flip, &rotate, &w, &h);
@@ -568,6 +568,35 @@ static mrb_value mrb_ffts(mrb_state* mrb, mrb_value self)
     }
 }
 
+static mrb_value mrb_drawlist(mrb_state* mrb, mrb_value self)
+{
+    mrb_value list_obj;
+    mrb_get_args(mrb, "A", &list_obj);
+
+    tic_core* core = getMRubyMachine(mrb);
+    tic_mem* tic = (tic_mem*)core;
+
+    s32 size = ARY_LEN(RARRAY(list_obj));
+    s32 list[TIC_DRAWLIST_CHUNK];
+
+    for(s32 pos = 0; pos < size;)
+    {
+        s32 count = MIN(size - pos, COUNT_OF(list));
+
+        for(s32 i = 0; i < count; i++)
+            list[i] = mrb_int(mrb, mrb_ary_entry(list_obj, pos + i));
+
+        s32 done = core->api.drawlist(tic, list, count);
+
+        if(done == 0)
+            break;
+
+        pos += done;
+    }
+
+    return mrb_nil_value();
+}
+
 typedef struct
 {
     mrb_state* mrb;
@@ -1028,6 +1057,15 @@ static mrb_value mrb_mouse(mrb_state *mrb, mrb_value self)
     return hash;
 }
 
+// SCN/BDR run for every screen row, check once a frame which of them the cart
+// defines and call them by symbol instead of interning their names every time
+static struct
+{
+    mrb_sym scn;
+    mrb_sym scanline;
+    mrb_sym bdr;
+} Callbacks;
+
 static void closeMRuby(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1042,6 +1080,7 @@ static void closeMRuby(tic_mem* tic)
 
         free(currentVM);
         CurrentMachine = core->currentVM = NULL;
+        ZEROMEM(Callbacks);
     }
 }
 
@@ -1124,6 +1163,22 @@ static void evalMRuby(tic_mem* tic, const char* code) {
     catcherr(core);
 }
 
+static mrb_sym refCallback(mrb_state* mrb, const char* name)
+{
+    mrb_sym sym = mrb_intern_cstr(mrb, name);
+    return mrb_respond_to(mrb, mrb_top_self(mrb), sym) ? sym : 0;
+}
+
+static void refCallbacks(tic_core* core, mrb_state* mrb)
+{
+    Callbacks.scn = refCallback(mrb, SCN_FN);
+    Callbacks.scanline = refCallback(mrb, "scanline");
+    Callbacks.bdr = refCallback(mrb, BDR_FN);
+
+    core->state.defined.scanline = Callbacks.scn || Callbacks.scanline;
+    core->state.defined.border = Callbacks.bdr;
+}
+
 static void callMRubyTick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1137,6 +1192,9 @@ static void callMRubyTick(tic_mem* tic)
         {
             mrb_funcall(mrb, mrb_top_self(mrb), TicFunc, 0);
             catcherr(core);
+
+            // pick up SCN/BDR defined or replaced by the cart since the last frame
+            refCallbacks(core, mrb);
         }
         else
         {
@@ -1174,16 +1232,29 @@ static void callMRubyIntCallback(tic_mem* tic, s32 value, void* data, const char
     }
 }
 
+static void callMRubySymCallback(tic_mem* tic, mrb_sym sym, s32 value)
+{
+    tic_core* core = (tic_core*)tic;
+    mrb_state* mrb = ((mrbVm*)core->currentVM)->mrb;
+
+    if (mrb && sym)
+    {
+        mrb_value arg = mrb_fixnum_value(value);
+        mrb_funcall_argv(mrb, mrb_top_self(mrb), sym, 1, &arg);
+        catcherr(core);
+    }
+}
+
 static void callMRubyScanline(tic_mem* tic, s32 row, void* data)
 {
-    callMRubyIntCallback(tic, row, data, SCN_FN);
+    callMRubySymCallback(tic, Callbacks.scn, row);
 
-    callMRubyIntCallback(tic, row, data, "scanline");
+    callMRubySymCallback(tic, Callbacks.scanline, row);
 }
 
 static void callMRubyBorder(tic_mem* tic, s32 row, void* data)
 {
-    callMRubyIntCallback(tic, row, data, BDR_FN);
+    callMRubySymCallback(tic, Callbacks.bdr, row);
 }
 
 static void callMRubyMenu(tic_mem* tic, s32 index, void* data)
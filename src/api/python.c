@@ -512,6 +512,40 @@ static bool py_memset(int argc, py_Ref argv)
     return true;
 }
 
+// drawlist(list: list[int])
+// s32 (*drawlist)(tic_mem*, const s32*, s32)
+static bool py_drawlist(int argc, py_Ref argv)
+{
+    PY_CHECK_ARG_TYPE(0, tp_list);
+    py_Ref cmds = py_arg(0);
+    s32 size = py_list_len(cmds);
+    s32 list[TIC_DRAWLIST_CHUNK];
+
+    tic_core* core = get_core();
+
+    for (s32 pos = 0; pos < size;)
+    {
+        s32 count = MIN(size - pos, COUNT_OF(list));
+
+        for (s32 i = 0; i < count; i++)
+        {
+            py_ItemRef item = py_list_getitem(cmds, pos + i);
+            if (!py_checkint(item)) return false;
+            list[i] = py_toint(item);
+        }
+
+        s32 done = core->api.drawlist((tic_mem*)core, list, count);
+
+        if (done == 0)
+            break;
+
+        pos += done;
+    }
+
+    py_newnone(py_retval());
+    return true;
+}
+
 // mget(x: int, y: int) -> int
 // u8 (*mget)(tic_mem*, s32, s32)
 static bool py_mget(int argc, py_Ref argv)
@@ -1031,56 +1065,140 @@ static bool py_vbank(int argc, py_Ref argv)
 
 /*************TIC-80 MISC BEGIN****************/
 
+// ram[addr] -> int, ram[addr] = value
+// reads and writes the current RAM directly, without going through peek/poke
+static bool py_ram_index(py_Ref index, s32* addr)
+{
+    if (!py_checkint(index)) return false;
+
+    *addr = py_toint(index);
+    if (*addr < 0 || *addr >= TIC_RAM_SIZE)
+        return IndexError("ram index %d out of range", *addr);
+
+    return true;
+}
+
+static bool py_ram_getitem(int argc, py_Ref argv)
+{
+    PY_CHECK_ARGC(2);
+    s32 addr;
+    if (!py_ram_index(py_arg(1), &addr)) return false;
+
+    tic_core* core = get_core();
+    py_newint(py_retval(), core->memory.ram->data[addr]);
+    return true;
+}
+
+static bool py_ram_setitem(int argc, py_Ref argv)
+{
+    PY_CHECK_ARGC(3);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    s32 addr;
+    if (!py_ram_index(py_arg(1), &addr)) return false;
+
+    tic_core* core = get_core();
+    core->memory.ram->data[addr] = py_toint(py_arg(2));
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool py_ram_len(int argc, py_Ref argv)
+{
+    PY_CHECK_ARGC(1);
+    py_newint(py_retval(), TIC_RAM_SIZE);
+    return true;
+}
+
+// the API calls are where a script leaves pocketpy, which has no hook to stop a running script,
+// a frame interrupted by the watchdog raises an error at the next call, a loop making none isn't stopped
+static bool check_interrupt()
+{
+    tic_core* core = get_core();
+
+    if (tic_core_interrupted(core))
+        return py_exception(tp_RuntimeError, "the script was interrupted, the frame took too long");
+
+    return true;
+}
+
+#define PY_CHECKED_DEF(NAME) \
+    static bool py_##NAME##_checked(int argc, py_Ref argv) { return check_interrupt() && py_##NAME(argc, argv); }
+
+#define PY_CHECKED_API(NAME, SIGNATURE) PY_CHECKED_DEF(NAME)
+
+#define PY_API_LIST(macro) \
+    macro(btn,      "btn(id: int) -> bool") \
+    macro(btnp,     "btnp(id: int, hold=-1, period=-1) -> bool") \
+    macro(cls,      "cls(color=0)") \
+    macro(spr,      "spr(id: int, x: int, y: int, colorkey=-1, scale=1, flip=0, rotate=0, w=1, h=1)") \
+    macro(print,    "print(text, x=0, y=0, color=15, fixed=False, scale=1, alt=False)") \
+    macro(circ,     "circ(x: int, y: int, radius: int, color: int)") \
+    macro(circb,    "circb(x: int, y: int, radius: int, color: int)") \
+    macro(clip,     "clip(x: int, y: int, width: int, height: int)") \
+    macro(elli,     "elli(x: int, y: int, a: int, b: int, color: int)") \
+    macro(ellib,    "ellib(x: int, y: int, a: int, b: int, color: int)") \
+    macro(exit,     "exit()") \
+    macro(fget,     "fget(sprite_id: int, flag: int) -> bool") \
+    macro(fset,     "fset(sprite_id: int, flag: int, b: bool)") \
+    macro(font,     "font(text: str, x: int, y: int, chromakey: int, char_width=8, char_height=8, fixed=False, scale=1, alt=False) -> int") \
+    macro(key,      "key(code=-1) -> bool") \
+    macro(keyp,     "keyp(code=-1, hold=-1, period=-17) -> bool") \
+    macro(line,     "line(x0: float, y0: float, x1: float, y1: float, color: int)") \
+    macro(map,      "map(x=0, y=0, w=30, h=17, sx=0, sy=0, colorkey=-1, scale=1, remap=None)") \
+    macro(memcpy,   "memcpy(dest: int, source: int, size: int)") \
+    macro(memset,   "memset(dest: int, value: int, size: int)") \
+    macro(drawlist, "drawlist(list: list[int])") \
+    macro(mget,     "mget(x: int, y: int) -> int") \
+    macro(mset,     "mset(x: int, y: int, tile_id: int)") \
+    macro(mouse,    "mouse() -> tuple[int, int, bool, bool, bool, int, int]") \
+    macro(music,    "music(track=-1, frame=-1, row=-1, loop=True, sustain=False, tempo=-1, speed=-1)") \
+    macro(peekbits, "peek(addr: int, bits=8) -> int") \
+    macro(peek1,    "peek1(addr: int) -> int") \
+    macro(peek2,    "peek2(addr: int) -> int") \
+    macro(peek4,    "peek4(addr: int) -> int") \
+    macro(pix,      "pix(x: int, y: int, color: int | None = None) -> int | None") \
+    macro(pmem,     "pmem(index: int, value: int | None = None) -> int | None") \
+    macro(pokebits, "poke(addr: int, value: int, bits=8)") \
+    macro(poke1,    "poke1(addr: int, value: int)") \
+    macro(poke2,    "poke2(addr: int, value: int)") \
+    macro(poke4,    "poke4(addr: int, value: int)") \
+    macro(rect,     "rect(x: int, y: int, w: int, h: int, color: int)") \
+    macro(rectb,    "rectb(x: int, y: int, w: int, h: int, color: int)") \
+    macro(reset,    "reset()") \
+    macro(sfx,      "sfx(id: int, note=-1, duration=-1, channel=0, volume=15, speed=0)") \
+    macro(sync,     "sync(mask=0, bank=0, tocart=False)") \
+    macro(ttri,     "ttri(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, u1: float, v1: float, u2: float, v2: float, u3: float, v3: float, texsrc=0, chromakey=-1, z1=0.0, z2=0.0, z3=0.0)") \
+    macro(time,     "time() -> float") \
+    macro(trace,    "trace(message, color=15)") \
+    macro(tri,      "tri(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, color: int)") \
+    macro(trib,     "trib(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, color: int)") \
+    macro(tstamp,   "tstamp() -> int") \
+    macro(vbank,    "vbank(bank: int | None = None) -> int")
+
+PY_API_LIST(PY_CHECKED_API)
+PY_CHECKED_DEF(ram_getitem)
+PY_CHECKED_DEF(ram_setitem)
+
+static void bind_ram(py_GlobalRef mod)
+{
+    py_Type type = py_newtype("RAM", tp_object, mod, NULL);
+    py_bindmethod(type, "__getitem__", py_ram_getitem_checked);
+    py_bindmethod(type, "__setitem__", py_ram_setitem_checked);
+    py_bindmethod(type, "__len__", py_ram_len);
+
+    py_newobject(py_retval(), type, 0, 0);
+    py_setdict(mod, py_name("ram"), py_retval());
+}
+
 static void bind_pkpy_v2()
 {
     py_GlobalRef mod = py_getmodule("__main__");
-    py_bind(mod, "btn(id: int) -> bool", py_btn);
-    py_bind(mod, "btnp(id: int, hold=-1, period=-1) -> bool", py_btnp);
-    py_bind(mod, "cls(color=0)", py_cls);
-    py_bind(mod, "spr(id: int, x: int, y: int, colorkey=-1, scale=1, flip=0, rotate=0, w=1, h=1)",
-            py_spr);
-    py_bind(mod, "print(text, x=0, y=0, color=15, fixed=False, scale=1, alt=False)", py_print);
-    py_bind(mod, "circ(x: int, y: int, radius: int, color: int)", py_circ);
-    py_bind(mod, "circb(x: int, y: int, radius: int, color: int)", py_circb);
-    py_bind(mod, "clip(x: int, y: int, width: int, height: int)", py_clip);
-    py_bind(mod, "elli(x: int, y: int, a: int, b: int, color: int)", py_elli);
-    py_bind(mod, "ellib(x: int, y: int, a: int, b: int, color: int)", py_ellib);
-    py_bind(mod, "exit()", py_exit);
-    py_bind(mod, "fget(sprite_id: int, flag: int) -> bool", py_fget);
-    py_bind(mod, "fset(sprite_id: int, flag: int, b: bool)", py_fset);
-    py_bind(mod, "font(text: str, x: int, y: int, chromakey: int, char_width=8, char_height=8, fixed=False, scale=1, alt=False) -> int", py_font);
-    py_bind(mod, "key(code=-1) -> bool", py_key);
-    py_bind(mod, "keyp(code=-1, hold=-1, period=-17) -> bool", py_keyp);
-    py_bind(mod, "line(x0: float, y0: float, x1: float, y1: float, color: int)", py_line);
-    py_bind(mod, "map(x=0, y=0, w=30, h=17, sx=0, sy=0, colorkey=-1, scale=1, remap=None)", py_map);
-    py_bind(mod, "memcpy(dest: int, source: int, size: int)", py_memcpy);
-    py_bind(mod, "memset(dest: int, value: int, size: int)", py_memset);
-    py_bind(mod, "mget(x: int, y: int) -> int", py_mget);
-    py_bind(mod, "mset(x: int, y: int, tile_id: int)", py_mset);
-    py_bind(mod, "mouse() -> tuple[int, int, bool, bool, bool, int, int]", py_mouse);
-    py_bind(mod, "music(track=-1, frame=-1, row=-1, loop=True, sustain=False, tempo=-1, speed=-1)", py_music);
-    py_bind(mod, "peek(addr: int, bits=8) -> int", py_peekbits);
-    py_bind(mod, "peek1(addr: int) -> int", py_peek1);
-    py_bind(mod, "peek2(addr: int) -> int", py_peek2);
-    py_bind(mod, "peek4(addr: int) -> int", py_peek4);
-    py_bind(mod, "pix(x: int, y: int, color: int | None = None) -> int | None", py_pix);
-    py_bind(mod, "pmem(index: int, value: int | None = None) -> int | None", py_pmem);
-    py_bind(mod, "poke(addr: int, value: int, bits=8)", py_pokebits);
-    py_bind(mod, "poke1(addr: int, value: int)", py_poke1);
-    py_bind(mod, "poke2(addr: int, value: int)", py_poke2);
-    py_bind(mod, "poke4(addr: int, value: int)", py_poke4);
-    py_bind(mod, "rect(x: int, y: int, w: int, h: int, color: int)", py_rect);
-    py_bind(mod, "rectb(x: int, y: int, w: int, h: int, color: int)", py_rectb);
-    py_bind(mod, "reset()", py_reset);
-    py_bind(mod, "sfx(id: int, note=-1, duration=-1, channel=0, volume=15, speed=0)", py_sfx);
-    py_bind(mod, "sync(mask=0, bank=0, tocart=False)", py_sync);
-    py_bind(mod, "ttri(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, u1: float, v1: float, u2: float, v2: float, u3: float, v3: float, texsrc=0, chromakey=-1, z1=0.0, z2=0.0, z3=0.0)", py_ttri);
-    py_bind(mod, "time() -> float", py_time);
-    py_bind(mod, "trace(message, color=15)", py_trace);
-    py_bind(mod, "tri(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, color: int)", py_tri);
-    py_bind(mod, "trib(x1: float, y1: float, x2: float, y2: float, x3: float, y3: float, color: int)", py_trib);
-    py_bind(mod, "tstamp() -> int", py_tstamp);
-    py_bind(mod, "vbank(bank: int | None = None) -> int", py_vbank);
+
+#define PY_BIND(NAME, SIGNATURE) py_bind(mod, SIGNATURE, py_##NAME##_checked);
+    PY_API_LIST(PY_BIND)
+#undef PY_BIND
+
+    bind_ram(mod);
 }
 
 void close_pkpy_v2(tic_mem* tic)
@@ -1133,6 +1251,11 @@ void tick_pkpy_v2(tic_mem* tic)
     {
         log_and_clearexc(p0);
     }
+
+    // SCN/BDR are looked up by their interned names, only tell the blit
+    // whether the cart defines them so it can skip the per-row calls
+    core->state.defined.scanline = py_getglobal(N.SCN) != NULL;
+    core->state.defined.border = py_getglobal(N.BDR) != NULL;
 }
 
 void boot_pkpy_v2(tic_mem* tic)
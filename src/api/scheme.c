@@ -30,11 +30,36 @@
 
 static const char* TicCore = "_TIC80";
 
-tic_core* getSchemeCore(s7_scheme* sc)
+typedef struct
+{
+    s7_pointer value;
+    s7_int loc;
+} SchemeRef;
+
+// kept in the TicCore variable
+typedef struct
+{
+    tic_core* core;
+
+    // SCN/BDR run for every screen row, keep the procedures protected from the gc
+    // instead of resolving their names every time
+    struct
+    {
+        SchemeRef scn;
+        SchemeRef bdr;
+    } callbacks;
+} SchemeVm;
+
+static SchemeVm* getSchemeVm(s7_scheme* sc)
 {
     return s7_c_pointer(s7_name_to_value(sc, TicCore));
 }
 
+tic_core* getSchemeCore(s7_scheme* sc)
+{
+    return getSchemeVm(sc)->core;
+}
+
 s7_pointer scheme_print(s7_scheme* sc, s7_pointer args)
 {
     //print(text x=0 y=0 color=15 fixed=false scale=1 smallfont=false) -> width
@@ -145,7 +170,7 @@ s7_pointer scheme_spr(s7_scheme* sc, s7_pointer args)
     const s32 x         = s7_integer(s7_cadr(args));
     const s32 y         = s7_integer(s7_caddr(args));
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     if (argn > 3)
     {
@@ -311,7 +336,7 @@ s7_pointer scheme_map(s7_scheme* sc, s7_pointer args)
 
     const int argn = s7_list_length(sc, args);
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     if (argn > 6) {
         s7_pointer colorkey = s7_list_ref(sc, args, 6);
@@ -492,7 +517,7 @@ s7_pointer scheme_font(s7_scheme* sc, s7_pointer args)
     const s32 x = s7_integer(s7_cadr(args));
     const s32 y = s7_integer(s7_caddr(args));
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
     s7_pointer colorkey = s7_cadddr(args);
     parseTransparentColorsArg(sc, colorkey, trans_colors, &trans_count);
@@ -629,7 +654,7 @@ s7_pointer scheme_ttri(s7_scheme* sc, s7_pointer args)
     const int argn = s7_list_length(sc, args);
     const tic_texture_src texsrc = (tic_texture_src)(argn > 12 ? s7_integer(s7_list_ref(sc, args, 12)) : 0);
 
-    static u8 trans_colors[TIC_PALETTE_SIZE];
+    u8 trans_colors[TIC_PALETTE_SIZE];
     u8 trans_count = 0;
 
     if (argn > 13)
@@ -772,6 +797,51 @@ s7_pointer scheme_ffts(s7_scheme* sc, s7_pointer args)
     return s7_make_real(sc, core->api.ffts(tic, start_freq, end_freq));
 }
 
+s7_pointer scheme_drawlist(s7_scheme* sc, s7_pointer args)
+{
+    // drawlist(list) where list is a vector or a list of integers
+    tic_core* core = getSchemeCore(sc);
+    tic_mem* tic = (tic_mem*)core;
+
+    s7_pointer cmds = s7_car(args);
+    const bool vector = s7_is_vector(cmds);
+    const s32 size = vector ? s7_vector_length(cmds) : MAX(s7_list_length(sc, cmds), 0);
+
+    s32 list[TIC_DRAWLIST_CHUNK];
+
+    for(s32 pos = 0; pos < size;)
+    {
+        const s32 count = MIN(size - pos, COUNT_OF(list));
+
+        s7_pointer it = cmds;
+        for(s32 i = 0; i < count; i++)
+        {
+            if(vector)
+            {
+                list[i] = s7_number_to_integer(sc, s7_vector_ref(sc, cmds, pos + i));
+            }
+            else
+            {
+                list[i] = s7_number_to_integer(sc, s7_car(it));
+                it = s7_cdr(it);
+            }
+        }
+
+        const s32 done = core->api.drawlist(tic, list, count);
+
+        if(done == 0)
+            break;
+
+        pos += done;
+
+        if(!vector)
+            for(s32 i = 0; i < done; i++)
+                cmds = s7_cdr(cmds);
+    }
+
+    return s7_nil(sc);
+}
+
 static void initAPI(tic_core* core)
 {
     s7_scheme* sc = core->currentVM;
@@ -801,8 +871,10 @@ static void closeScheme(tic_mem* tic)
 
     if(core->currentVM)
     {
+        SchemeVm* vm = getSchemeVm(core->currentVM);
         s7_free(core->currentVM);
         core->currentVM = NULL;
+        free(vm);
     }
 }
 
@@ -857,7 +929,9 @@ static bool initScheme(tic_mem* tic, const char* code)
                                     (set! (hook 'result) #f))))");
     s7_eval_c_string(sc, defstructStr);
 
-    s7_define_variable(sc, TicCore, s7_make_c_pointer(sc, core));
+    SchemeVm* vm = calloc(1, sizeof(SchemeVm));
+    vm->core = core;
+    s7_define_variable(sc, TicCore, s7_make_c_pointer(sc, vm));
     s7_load_c_string(sc, code, strlen(code));
 
 
@@ -871,6 +945,22 @@ static bool initScheme(tic_mem* tic, const char* code)
     return true;
 }
 
+static void refCallback(s7_scheme* sc, SchemeRef* ref, const char* name)
+{
+    if (ref->value) {
+        s7_gc_unprotect_at(sc, ref->loc);
+        ref->value = NULL;
+    }
+
+    if (s7_is_defined(sc, name)) {
+        s7_pointer value = s7_name_to_value(sc, name);
+        if (s7_is_procedure(value)) {
+            ref->value = value;
+            ref->loc = s7_gc_protect(sc, value);
+        }
+    }
+}
+
 static void callSchemeTick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -880,6 +970,14 @@ static void callSchemeTick(tic_mem* tic)
     if (isTicDefined) {
         s7_call(sc, s7_name_to_value(sc, ticFnName), s7_nil(sc));
     }
+
+    // pick up SCN/BDR defined or replaced by the cart since the last frame
+    SchemeVm* vm = getSchemeVm(sc);
+    refCallback(sc, &vm->callbacks.scn, "SCN");
+    refCallback(sc, &vm->callbacks.bdr, "BDR");
+
+    core->state.defined.scanline = vm->callbacks.scn.value != NULL;
+    core->state.defined.border = vm->callbacks.bdr.value != NULL;
 }
 
 static void callSchemeBoot(tic_mem* tic)
@@ -899,10 +997,9 @@ static void callSchemeScanline(tic_mem* tic, s32 row, void* data)
     tic_core* core = (tic_core*)tic;
     s7_scheme* sc = core->currentVM;
 
-    static const char* scnFnName = "SCN";
-    const bool isScnDefined = s7_is_defined(sc, scnFnName);
-    if (isScnDefined) {
-        s7_call(sc, s7_name_to_value(sc, scnFnName), s7_cons(sc, s7_make_integer(sc, row), s7_nil(sc)));
+    const SchemeRef* ref = &getSchemeVm(sc)->callbacks.scn;
+    if (ref->value) {
+        s7_call(sc, ref->value, s7_cons(sc, s7_make_integer(sc, row), s7_nil(sc)));
     }
 }
 
@@ -911,10 +1008,9 @@ static void callSchemeBorder(tic_mem* tic, s32 row, void* data)
     tic_core* core = (tic_core*)tic;
     s7_scheme* sc = core->currentVM;
 
-    static const char* bdrFnName = "BDR";
-    bool isBdrDefined = s7_is_defined(sc, bdrFnName);
-    if (isBdrDefined) {
-        s7_call(sc, s7_name_to_value(sc, bdrFnName), s7_cons(sc, s7_make_integer(sc, row), s7_nil(sc)));
+    const SchemeRef* ref = &getSchemeVm(sc)->callbacks.bdr;
+    if (ref->value) {
+        s7_call(sc, ref->value, s7_cons(sc, s7_make_integer(sc, row), s7_nil(sc)));
     }
 }
 
@@ -35,6 +35,21 @@ extern bool parse_note(const char* noteStr, s32* note, s32* octave);
 
 static const char TicCore[] = "_TIC80";
 
+// the foreign pointer of the main VM
+typedef struct
+{
+    tic_core* core;
+
+    // SCN/BDR run for every screen row, keep references to the closures
+    // instead of looking them up in the root table every time
+    struct
+    {
+        HSQOBJECT scn;
+        HSQOBJECT scanline;
+        HSQOBJECT bdr;
+    } callbacks;
+} SquirrelVm;
+
 static float getSquirrelFloat(HSQUIRRELVM vm, s32 index)
 {
     SQFloat f = 0.0;
@@ -64,7 +79,7 @@ static void registerSquirrelFunction(tic_core* core, SQFUNCTION func, const char
 static tic_core* getSquirrelCore(HSQUIRRELVM vm)
 {
 #if USE_FOREIGN_POINTER
-    return (tic_core*)sq_getforeignpointer(vm);
+    return ((SquirrelVm*)sq_getforeignptr(vm))->core;
 #else
     sq_pushregistrytable(vm);
     sq_pushstring(vm, TicCore, -1);
@@ -499,7 +514,7 @@ static SQInteger squirrel_ttri(HSQUIRRELVM vm)
             pt[i] = getSquirrelFloat(vm, i + 2);
 
         tic_core* core = getSquirrelCore(vm); tic_mem* tic = (tic_mem*)core;
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         tic_texture_src src = tic_tiles_texture;
 
@@ -655,7 +670,7 @@ static SQInteger squirrel_spr(HSQUIRRELVM vm)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 2)
@@ -818,7 +833,7 @@ static SQInteger squirrel_map(HSQUIRRELVM vm)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     SQInteger top = sq_gettop(vm);
@@ -1581,6 +1596,44 @@ static SQInteger squirrel_ffts(HSQUIRRELVM vm)
     return 0;
 }
 
+static SQInteger squirrel_drawlist(HSQUIRRELVM vm)
+{
+    tic_core* core = getSquirrelCore(vm);
+    tic_mem* tic = (tic_mem*)core;
+
+    if (sq_gettop(vm) == 2 && OT_ARRAY == sq_gettype(vm, 2))
+    {
+        s32 size = (s32)sq_getsize(vm, 2);
+        s32 list[TIC_DRAWLIST_CHUNK];
+
+        for(s32 pos = 0; pos < size;)
+        {
+            s32 count = MIN(size - pos, COUNT_OF(list));
+
+            for(s32 i = 0; i < count; i++)
+            {
+                sq_pushinteger(vm, (SQInteger)(pos + i));
+                sq_rawget(vm, 2);
+                list[i] = getSquirrelNumber(vm, -1);
+                sq_poptop(vm);
+            }
+
+            s32 done = core->api.drawlist(tic, list, count);
+
+            if(done == 0)
+                break;
+
+            pos += done;
+        }
+
+        return 0;
+    }
+
+    sq_throwerror(vm, "invalid params, drawlist(list)\n");
+
+    return 0;
+}
+
 static SQInteger squirrel_dofile(HSQUIRRELVM vm)
 {
     return sq_throwerror(vm, "unknown method: \"dofile\"\n");
@@ -1612,10 +1665,6 @@ static void initAPI(tic_core* core)
     sq_newslot(vm, -3, SQTrue);
     sq_poptop(vm);
 
-#if USE_FOREIGN_POINTER
-    sq_setforeignptr(vm, core);
-#endif
-
 #define API_FUNC_DEF(name, ...) {squirrel_ ## name, #name},
     static const struct{SQFUNCTION func; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
 #undef API_FUNC_DEF
@@ -1636,8 +1685,10 @@ static void closeSquirrel(tic_mem* tic)
 
     if(core->currentVM)
     {
+        SquirrelVm* squirrelVm = sq_getforeignptr(core->currentVM);
         sq_close(core->currentVM);
         core->currentVM = NULL;
+        free(squirrelVm);
     }
 }
 
@@ -1650,6 +1701,15 @@ static bool initSquirrel(tic_mem* tic, const char* code)
     HSQUIRRELVM vm = core->currentVM = sq_open(100);
     squirrel_open_builtins(vm);
 
+    {
+        SquirrelVm* squirrelVm = malloc(sizeof(SquirrelVm));
+        squirrelVm->core = core;
+        sq_resetobject(&squirrelVm->callbacks.scn);
+        sq_resetobject(&squirrelVm->callbacks.scanline);
+        sq_resetobject(&squirrelVm->callbacks.bdr);
+        sq_setforeignptr(vm, squirrelVm);
+    }
+
     sq_newclosure(vm, squirrel_errorHandler, 0);
     sq_seterrorhandler(vm);
 
@@ -1697,6 +1757,40 @@ static void errorReport(tic_mem* tic)
     sq_pop(vm, 3); // remove string, error and root table.
 }
 
+static void refCallback(HSQUIRRELVM vm, HSQOBJECT* obj, const char* name)
+{
+    sq_release(vm, obj);
+    sq_resetobject(obj);
+
+    sq_pushroottable(vm);
+    sq_pushstring(vm, name, -1);
+
+    if (SQ_SUCCEEDED(sq_get(vm, -2)))
+    {
+        if(sq_gettype(vm, -1) & (OT_CLOSURE|OT_NATIVECLOSURE))
+        {
+            sq_getstackobj(vm, -1, obj);
+            sq_addref(vm, obj);
+        }
+
+        sq_pop(vm, 2); // closure and root table
+    }
+    else sq_poptop(vm);
+}
+
+static void refCallbacks(tic_core* core)
+{
+    HSQUIRRELVM vm = core->currentVM;
+    SquirrelVm* squirrelVm = sq_getforeignptr(vm);
+
+    refCallback(vm, &squirrelVm->callbacks.scn, SCN_FN);
+    refCallback(vm, &squirrelVm->callbacks.scanline, "scanline");
+    refCallback(vm, &squirrelVm->callbacks.bdr, BDR_FN);
+
+    core->state.defined.scanline = !sq_isnull(squirrelVm->callbacks.scn) || !sq_isnull(squirrelVm->callbacks.scanline);
+    core->state.defined.border = !sq_isnull(squirrelVm->callbacks.bdr);
+}
+
 static void callSquirrelTick(tic_mem* tic)
 {
     tic_core* core = (tic_core*)tic;
@@ -1738,6 +1832,9 @@ static void callSquirrelTick(tic_mem* tic)
                 else sq_poptop(vm);
             }
 #endif
+
+            // pick up SCN/BDR defined or replaced by the cart since the last frame
+            refCallbacks(core);
         }
         else
         {
@@ -1801,17 +1898,55 @@ static void callSquirrelIntCallback(tic_mem* tic, s32 value, void* data, const c
     }
 }
 
+static void callSquirrelRefCallback(tic_core* core, const HSQOBJECT* obj, s32 value)
+{
+    HSQUIRRELVM vm = core->currentVM;
+
+    if (!sq_isnull(*obj))
+    {
+        sq_pushobject(vm, *obj);
+        sq_pushroottable(vm);
+        sq_pushinteger(vm, value);
+
+        if(SQ_FAILED(sq_call(vm, 2, SQFalse, SQTrue)))
+        {
+            sq_getlasterror(vm);
+            sq_tostring(vm, -1);
+
+            const SQChar* errorString = "unknown error";
+            sq_getstring(vm, -1, &errorString);
+            if (core->data)
+                core->data->error(core->data->data, errorString);
+            sq_pop(vm, 2); // error string and error
+        }
+
+        sq_poptop(vm); // closure
+    }
+}
+
 static void callSquirrelScanline(tic_mem* tic, s32 row, void* data)
 {
-    callSquirrelIntCallback(tic, row, data, SCN_FN);
+    tic_core* core = (tic_core*)tic;
+
+    if (core->currentVM)
+    {
+        const SquirrelVm* squirrelVm = sq_getforeignptr(core->currentVM);
+        callSquirrelRefCallback(core, &squirrelVm->callbacks.scn, row);
 
-    // try to call old scanline
-    callSquirrelIntCallback(tic, row, data, "scanline");
+        // try to call old scanline
+        callSquirrelRefCallback(core, &squirrelVm->callbacks.scanline, row);
+    }
 }
 
 static void callSquirrelBorder(tic_mem* tic, s32 row, void* data)
 {
-    callSquirrelIntCallback(tic, row, data, BDR_FN);
+    tic_core* core = (tic_core*)tic;
+
+    if (core->currentVM)
+    {
+        const SquirrelVm* squirrelVm = sq_getforeignptr(core->currentVM);
+        callSquirrelRefCallback(core, &squirrelVm->callbacks.bdr, row);
+    }
 }
 
 static void callSquirrelMenu(tic_mem* tic, s32 index, void* data)
@@ -46,11 +46,22 @@ typedef float           f32;
 
 static const char TicCore[] = "_TIC80";
 
-IM3Function BDR_function;
-IM3Function SCN_function;
-IM3Function TIC_function;
-IM3Function BOOT_function;
-IM3Function MENU_function;
+// runtime userdata, keeps the exported callbacks per instance
+// so several WASM carts can run in one process
+typedef struct
+{
+    tic_core* core;
+
+    // wasm3 environments aren't thread safe, so every runtime gets its own,
+    // it's freed after the runtime, which releases its code pages into it
+    IM3Environment env;
+
+    IM3Function tic;
+    IM3Function boot;
+    IM3Function scn;
+    IM3Function bdr;
+    IM3Function menu;
+} WasmVm;
 
 #define FATAL(msg, ...) { printf("Error: [Fatal] " msg "\n", ##__VA_ARGS__); goto _onfatal; }
 #define WASM_STACK_SIZE 64*1024
@@ -139,7 +150,13 @@ M3Result wasm_dump(IM3Runtime runtime)
 
 static tic_core* getWasmCore(IM3Runtime ctx)
 {
-    return (tic_core*)ctx->userdata;
+    return ((WasmVm*)ctx->userdata)->core;
+}
+
+static WasmVm* getWasmVm(tic_core* core)
+{
+    IM3Runtime runtime = core->currentVM;
+    return runtime ? runtime->userdata : NULL;
 }
 
 m3ApiRawFunction(wasmtic_line)
@@ -879,6 +896,27 @@ m3ApiRawFunction(wasmtic_memcpy)
     m3ApiSuccess();
 }
 
+// the list is read in place from the module memory
+m3ApiRawFunction(wasmtic_drawlist)
+{
+    m3ApiReturnType  (int32_t)
+
+    m3ApiGetArgMem   (const s32*, list)
+    m3ApiGetArg      (int32_t, size)
+
+    if (size < 0) size = 0;
+
+    // the byte size must not wrap where size_t is 32 bits wide
+    if (size > INT32_MAX / (s32)sizeof(s32))
+        m3ApiTrap(m3Err_trapOutOfBoundsMemoryAccess);
+
+    m3ApiCheckMem(list, size * sizeof(s32));
+
+    tic_core* core = getWasmCore(runtime); tic_mem* tic = (tic_mem*)core;
+
+    m3ApiReturn(core->api.drawlist(tic, list, size));
+}
+
 
 m3ApiRawFunction(wasmtic_exit)
 {
@@ -1002,55 +1040,71 @@ m3ApiRawFunction(wasmtic_mouse)
 
 
 
+// the TIC API imports are where a WASM cart leaves wasm3, a frame interrupted by the watchdog
+// traps at its next call, wasm3 has no metering to stop a loop that makes none
+m3ApiRawFunction(callTicFunction)
+{
+    if (tic_core_interrupted(getWasmCore(runtime)))
+        m3ApiTrap("the script was interrupted, the frame took too long");
+
+    return ((M3RawCall)_ctx->userdata)(runtime, _ctx, _sp, _mem);
+}
+
+static M3Result linkTicFunction(IM3Module module, const char* name, const char* signature, M3RawCall function)
+{
+    return m3_LinkRawFunctionEx (module, "env", name, signature, callTicFunction, (const void*)function);
+}
+
 M3Result linkTicAPI(IM3Module module)
 {
     M3Result result = m3Err_none;
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "btn",     "i(i)",          &wasmtic_btn)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "btnp",    "i(iii)",        &wasmtic_btnp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "clip",    "v(iiii)",       &wasmtic_clip)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "cls",     "v(i)",          &wasmtic_cls)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "circ",    "v(iiii)",       &wasmtic_circ)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "circb",   "v(iiii)",       &wasmtic_circb)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "elli",    "v(iiiii)",      &wasmtic_elli)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "ellib",   "v(iiiii)",      &wasmtic_ellib)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "exit",    "v()",           &wasmtic_exit)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "fget",    "i(ii)",         &wasmtic_fget)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "fset",    "v(iii)",        &wasmtic_fset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "font",    "i(*iiiiiiiii)", &wasmtic_font)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "key",     "i(i)",          &wasmtic_key)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "keyp",    "i(iii)",        &wasmtic_keyp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "line",    "v(ffffi)",      &wasmtic_line)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "btn",     "i(i)",          &wasmtic_btn)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "btnp",    "i(iii)",        &wasmtic_btnp)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "clip",    "v(iiii)",       &wasmtic_clip)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "cls",     "v(i)",          &wasmtic_cls)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "circ",    "v(iiii)",       &wasmtic_circ)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "circb",   "v(iiii)",       &wasmtic_circb)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "drawlist", "i(*i)",        &wasmtic_drawlist)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "elli",    "v(iiiii)",      &wasmtic_elli)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "ellib",   "v(iiiii)",      &wasmtic_ellib)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "exit",    "v()",           &wasmtic_exit)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "fget",    "i(ii)",         &wasmtic_fget)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "fset",    "v(iii)",        &wasmtic_fset)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "font",    "i(*iiiiiiiii)", &wasmtic_font)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "key",     "i(i)",          &wasmtic_key)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "keyp",    "i(iii)",        &wasmtic_keyp)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "line",    "v(ffffi)",      &wasmtic_line)));
     // TODO: needs a lot of help for all the optional arguments
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "map",     "v(iiiiiiiiii)", &wasmtic_map)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "memcpy",  "v(iii)",        &wasmtic_memcpy)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "memset",  "v(iii)",        &wasmtic_memset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mget",    "i(ii)",         &wasmtic_mget)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mset",    "v(iii)",        &wasmtic_mset)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mouse",   "v(*)",          &wasmtic_mouse)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "music",   "v(iiiiiii)",    &wasmtic_music)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "pix",     "i(iii)",        &wasmtic_pix)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek",    "i(ii)",         &wasmtic_peek)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek4",   "i(i)",          &wasmtic_peek4)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek2",   "i(i)",          &wasmtic_peek2)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "peek1",   "i(i)",          &wasmtic_peek1)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "pmem",    "i(iI)",         &wasmtic_pmem)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke",    "v(iii)",        &wasmtic_poke)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke4",   "v(ii)",         &wasmtic_poke4)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke2",   "v(ii)",         &wasmtic_poke2)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "poke1",   "v(ii)",         &wasmtic_poke1)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "print",   "i(*iiiiii)",    &wasmtic_print)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "rect",    "v(iiiii)",      &wasmtic_rect)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "rectb",   "v(iiiii)",      &wasmtic_rectb)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "sfx",     "v(iiiiiiii)",   &wasmtic_sfx)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "spr",     "v(iiiiiiiiii)", &wasmtic_spr)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "sync",    "v(iii)",        &wasmtic_sync)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "time",    "f()",           &wasmtic_time)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "tstamp",  "i()",           &wasmtic_tstamp)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "trace",   "v(*i)",         &wasmtic_trace)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "tri",     "v(ffffffi)",    &wasmtic_tri)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "trib",    "v(ffffffi)",    &wasmtic_trib)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "ttri",  "v(ffffffffffffiiifffi)",    &wasmtic_ttri)));
-    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "vbank",   "i(i)",          &wasmtic_vbank)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "map",     "v(iiiiiiiiii)", &wasmtic_map)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "memcpy",  "v(iii)",        &wasmtic_memcpy)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "memset",  "v(iii)",        &wasmtic_memset)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "mget",    "i(ii)",         &wasmtic_mget)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "mset",    "v(iii)",        &wasmtic_mset)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "mouse",   "v(*)",          &wasmtic_mouse)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "music",   "v(iiiiiii)",    &wasmtic_music)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "pix",     "i(iii)",        &wasmtic_pix)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "peek",    "i(ii)",         &wasmtic_peek)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "peek4",   "i(i)",          &wasmtic_peek4)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "peek2",   "i(i)",          &wasmtic_peek2)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "peek1",   "i(i)",          &wasmtic_peek1)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "pmem",    "i(iI)",         &wasmtic_pmem)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "poke",    "v(iii)",        &wasmtic_poke)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "poke4",   "v(ii)",         &wasmtic_poke4)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "poke2",   "v(ii)",         &wasmtic_poke2)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "poke1",   "v(ii)",         &wasmtic_poke1)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "print",   "i(*iiiiii)",    &wasmtic_print)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "rect",    "v(iiiii)",      &wasmtic_rect)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "rectb",   "v(iiiii)",      &wasmtic_rectb)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "sfx",     "v(iiiiiiii)",   &wasmtic_sfx)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "spr",     "v(iiiiiiiiii)", &wasmtic_spr)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "sync",    "v(iii)",        &wasmtic_sync)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "time",    "f()",           &wasmtic_time)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "tstamp",  "i()",           &wasmtic_tstamp)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "trace",   "v(*i)",         &wasmtic_trace)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "tri",     "v(ffffffi)",    &wasmtic_tri)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "trib",    "v(ffffffi)",    &wasmtic_trib)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "ttri",  "v(ffffffffffffiiifffi)",    &wasmtic_ttri)));
+    _   (SuppressLookupFailure (linkTicFunction (module, "vbank",   "i(i)",          &wasmtic_vbank)));
 
 _catch:
   return result;
@@ -1064,12 +1118,10 @@ void deinitWasmRuntime( IM3Runtime runtime )
         printf("WARNING deinitWasm of null");
         return;
     }
-    IM3Environment env = runtime -> environment;
-    printf("deiniting env %p\n", env);
-
-    tic_core* tic = getWasmCore(runtime);
+    WasmVm* vm = runtime->userdata;
     m3_FreeRuntime (runtime);
-    m3_FreeEnvironment (env);
+    m3_FreeEnvironment (vm->env);
+    free(vm);
 }
 
 static void closeWasm(tic_mem* tic)
@@ -1099,33 +1151,35 @@ static void closeWasm(tic_mem* tic)
     }
 }
 
-// TODO: restore functionality
-// static u64 ForceExitCounter = 0;
-
-// s32 wasm_timeout_check(void* udata)
-// {
-//     tic_core* core = (tic_core*)udata;
-//     tic_tick_data* tick = core->data;
-
-//     return ForceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
-// }
-
-
 static bool initWasm(tic_mem* tic, const char* code)
 {
     // closeWasm(tic);
     tic_core* core = (tic_core*)tic;
     dbg("Initializing WASM3 runtime %p\n", core);
 
-    IM3Environment env = m3_NewEnvironment ();
-    if(!env)
+    WasmVm* vm = calloc(1, sizeof(WasmVm));
+
+    if(!vm)
+    {
+        core->data->error(core->data->data, "Unable to init WASM VM");
+        return false;
+    }
+
+    vm->core = core;
+    vm->env = m3_NewEnvironment ();
+
+    if(!vm->env)
     {
+        free(vm);
         core->data->error(core->data->data, "Unable to init WASM env");
         return false;
     }
-    IM3Runtime runtime = m3_NewRuntime (env, WASM_STACK_SIZE, core);
+
+    IM3Runtime runtime = m3_NewRuntime (vm->env, WASM_STACK_SIZE, vm);
     if(!runtime)
     {
+        m3_FreeEnvironment (vm->env);
+        free(vm);
         core->data->error(core->data->data, "Unable to init WASM runtime");
         return false;
     }
@@ -1180,11 +1234,11 @@ static bool initWasm(tic_mem* tic, const char* code)
         return false;
     }
 
-    m3_FindFunction (&BDR_function, runtime, BDR_FN);
-    m3_FindFunction (&SCN_function, runtime, SCN_FN);
-    m3_FindFunction (&BOOT_function, runtime, BOOT_FN);
-    m3_FindFunction (&MENU_function, runtime, MENU_FN);
-    result = m3_FindFunction (&TIC_function, runtime, TIC_FN);
+    m3_FindFunction (&vm->bdr, runtime, BDR_FN);
+    m3_FindFunction (&vm->scn, runtime, SCN_FN);
+    m3_FindFunction (&vm->boot, runtime, BOOT_FN);
+    m3_FindFunction (&vm->menu, runtime, MENU_FN);
+    result = m3_FindFunction (&vm->tic, runtime, TIC_FN);
 
     if (result)
     {
@@ -1192,20 +1246,22 @@ static bool initWasm(tic_mem* tic, const char* code)
         return false;
     }
 
+    // wasm exports can't change after loading, skip the per-row calls for good
+    core->state.defined.scanline = vm->scn != NULL;
+    core->state.defined.border = vm->bdr != NULL;
+
     return true;
 }
 
 static void callWasmTick(tic_mem* tic)
 {
-    // ForceExitCounter = 0;
-
     tic_core* core = (tic_core*)tic;
 
     IM3Runtime runtime = core->currentVM;
 
     if(!runtime) { return; }
 
-    M3Result res = m3_CallV(TIC_function);
+    M3Result res = m3_CallV(getWasmVm(core)->tic);
     if(res)
     {
         core->data->error(core->data->data, res);
@@ -1219,9 +1275,11 @@ static void callWasmBoot(tic_mem* tic)
     IM3Runtime runtime = core->currentVM;
 
     if(!runtime) { return; }
-    if (BOOT_function == NULL) { return; }
 
-    M3Result res = m3_CallV(BOOT_function);
+    IM3Function boot = getWasmVm(core)->boot;
+    if (boot == NULL) { return; }
+
+    M3Result res = m3_CallV(boot);
     if(res)
     {
         core->data->error(core->data->data, res);
@@ -1246,17 +1304,20 @@ static void callWasmIntFunc(tic_mem* tic, IM3Function func, s32 value, void* dat
 
 static void callWasmScanline(tic_mem* tic, s32 row, void* data)
 {
-    callWasmIntFunc(tic, SCN_function, row, data);
+    WasmVm* vm = getWasmVm((tic_core*)tic);
+    if (vm) callWasmIntFunc(tic, vm->scn, row, data);
 }
 
 static void callWasmBorder(tic_mem* tic, s32 row, void* data)
 {
-    callWasmIntFunc(tic, BDR_function, row, data);
+    WasmVm* vm = getWasmVm((tic_core*)tic);
+    if (vm) callWasmIntFunc(tic, vm->bdr, row, data);
 }
 
 static void callWasmMenu(tic_mem* tic, s32 index, void* data)
 {
-    callWasmIntFunc(tic, MENU_function, index, data);
+    WasmVm* vm = getWasmVm((tic_core*)tic);
+    if (vm) callWasmIntFunc(tic, vm->menu, index, data);
 }
 
 static inline bool isalnum_(char c) {return isalnum(c) || c == '_';}
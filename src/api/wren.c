@@ -148,6 +148,7 @@ class TIC {\n\
     foreign static exit()\n\
     foreign static fft(start_freq, end_freq)\n\
     foreign static ffts(start_freq, end_freq)\n\
+    foreign static drawlist(list)\n\
     foreign static map_width__\n\
     foreign static map_height__\n\
     foreign static spritesize__\n\
@@ -1507,6 +1508,42 @@ static void wren_ffts(WrenVM* vm)
     wrenError(vm, "invalid params, ffts(start_freq, end_freq)\n");
 }
 
+static void wren_drawlist(WrenVM* vm)
+{
+    tic_core* core = getWrenCore(vm);
+    tic_mem* tic = (tic_mem*)core;
+
+    if (wrenGetSlotCount(vm) == 2 && isList(vm, 1))
+    {
+        wrenEnsureSlots(vm, 3);
+
+        s32 size = wrenGetListCount(vm, 1);
+        s32 list[TIC_DRAWLIST_CHUNK];
+
+        for(s32 pos = 0; pos < size;)
+        {
+            s32 count = MIN(size - pos, COUNT_OF(list));
+
+            for(s32 i = 0; i < count; i++)
+            {
+                wrenGetListElement(vm, 1, pos + i, 2);
+                list[i] = isNumber(vm, 2) ? getWrenNumber(vm, 2) : -1;
+            }
+
+            s32 done = core->api.drawlist(tic, list, count);
+
+            if(done == 0)
+                break;
+
+            pos += done;
+        }
+
+        return;
+    }
+
+    wrenError(vm, "invalid params, drawlist(list)\n");
+}
+
 static WrenForeignMethodFn foreignTicMethods(const char* signature)
 {
     if (strcmp(signature, "static TIC.btn()"                    ) == 0) return wren_btn;
@@ -1620,6 +1657,7 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
 
     if (strcmp(signature, "static TIC.fft(_,_)"                 ) == 0) return wren_fft;
     if (strcmp(signature, "static TIC.ffts(_,_)"                ) == 0) return wren_ffts;
+    if (strcmp(signature, "static TIC.drawlist(_)"              ) == 0) return wren_drawlist;
 
     // internal functions
     if (strcmp(signature, "static TIC.map_width__"              ) == 0) return wren_map_width;
@@ -35,30 +35,31 @@ static inline bool isalnum_(char c)
 
 #define YUE_CODE(...) #__VA_ARGS__
 
-static void evalYuescript(tic_mem* tic, const char* code)
+static bool compileYuescript(lua_State* lua, const char* code)
 {
-    tic_core* core = (tic_core*)tic;
-    lua_State* lua = (lua_State*)core->currentVM;
-
     yue::YueCompiler compiler;
     auto result = compiler.compile(code, yue::YueConfig());
 
     if (result.error)
     {
-        core->data->error(core->data->data, result.error->displayMessage.c_str());
-        return;
+        lua_pushstring(lua, result.error->displayMessage.c_str());
+        return false;
     }
 
-    const char* luaCode = result.codes.c_str();
-    if (luaL_loadstring(lua, luaCode) == LUA_OK)
+    return luaL_loadstring(lua, result.codes.c_str()) == LUA_OK;
+}
+
+static void evalYuescript(tic_mem* tic, const char* code)
+{
+    tic_core* core = (tic_core*)tic;
+    lua_State* lua = (lua_State*)core->currentVM;
+
+    if (!compileYuescript(lua, code) || lua_pcall(lua, 0, 0, 0) != LUA_OK)
     {
-        if (lua_pcall(lua, 0, 0, 0) != LUA_OK)
+        const char* msg = lua_tostring(lua, -1);
+        if (msg)
         {
-            const char* msg = lua_tostring(lua, -1);
-            if (msg)
-            {
-                core->data->error(core->data->data, msg);
-            }
+            core->data->error(core->data->data, msg);
         }
     }
 }
@@ -74,7 +75,14 @@ static bool initYuescript(tic_mem* tic, const char* code)
 
     luaapi_init(core);
 
-    evalYuescript(tic, code);
+    if (!luaapi_load(core, "yue", code, compileYuescript) || lua_pcall(lua, 0, 0, 0) != LUA_OK)
+    {
+        const char* msg = lua_tostring(lua, -1);
+        if (msg)
+        {
+            core->data->error(core->data->data, msg);
+        }
+    }
 
     return true;
 }
@@ -201,7 +209,8 @@ extern "C" TIC_EXPORT const tic_script EXPORT_SCRIPT(Yue) = {
             luaapi_scn, // scanline
             luaapi_bdr, // border
             luaapi_menu // menu
-        }},
+        },
+        luaapi_interrupt}, // interrupt
     getYueOutline,         // getOutline
     evalYuescript,         // eval
     "--[[",                // blockCommentStart
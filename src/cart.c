@@ -57,6 +57,7 @@ typedef enum
     CHUNK_SCREEN,       // 18
     CHUNK_BINARY,       // 19
     CHUNK_LANG,         // 20
+    CHUNK_BYTECODE,     // 21
 } ChunkType;
 
 typedef struct
@@ -79,204 +80,272 @@ static const u8 Waveforms[] = {0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0
 
 static s32 chunkSize(const Chunk* chunk)
 {
-    return chunk->size == 0 && (chunk->type == CHUNK_CODE || chunk->type == CHUNK_BINARY) ? TIC_BANK_SIZE : retro_le_to_cpu16(chunk->size);
+    return chunk->size == 0 && (chunk->type == CHUNK_CODE || chunk->type == CHUNK_BINARY || chunk->type == CHUNK_BYTECODE) ? TIC_BANK_SIZE : retro_le_to_cpu16(chunk->size);
 }
 
-static png_buffer getRawCartFromPng(png_buffer buffer)
+// unpacks the cart from a PNG into a buffer of sizeof(tic_cartridge), returns 0 on failure
+static s32 unpackPngCart(png_buffer buffer, u8* dst)
 {
+    s32 size = 0;
     png_buffer zip = png_decode(buffer);
 
     if (zip.size)
     {
-        png_buffer buf = png_create(sizeof(tic_cartridge));
-
-        buf.size = tic_tool_unzip(buf.data, buf.size, zip.data, zip.size);
+        size = tic_tool_unzip(dst, sizeof(tic_cartridge), zip.data, zip.size);
         free(zip.data);
-
-        if(buf.size)
-            return buf;
-
-        free(buf.data);
     }
 
-    return (png_buffer){.data = NULL, .size = 0};
+    return size;
 }
 
-tic_cartridge* loadPngCart(png_buffer buffer)
+bool tic_cart_index_open(tic_cart_index* index, const u8* buffer, s32 size)
 {
-    png_buffer buf = getRawCartFromPng(buffer);
+    ZEROMEM(index->chunks);
+    index->png.size = 0;
 
-    if(buf.data)
+    // check if this cartridge is in PNG format
+    if (size >= 4 && !memcmp(buffer, "\x89PNG", 4))
     {
-        tic_cartridge* cart = malloc(sizeof(tic_cartridge));
-        tic_cart_load(cart, buf.data, buf.size);
-        free(buf.data);
+        if(!index->png.data && !(index->png.data = malloc(sizeof(tic_cartridge))))
+            return false;
 
-        return cart;
-    }
+        index->png.size = unpackPngCart((png_buffer){.data = (u8*)buffer, .size = size}, index->png.data);
 
-    return NULL;
-}
+        if(!index->png.size)
+            return false;
 
-void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size)
-{
-    memset(cart, 0, sizeof(tic_cartridge));
+        buffer = index->png.data;
+        size = index->png.size;
+    }
+
+    const u8* ptr = buffer;
     const u8* end = buffer + size;
-    u8 *chunk_cart = NULL;
 
-    // check if this cartridge is in PNG format
-    if (!memcmp(buffer, "\x89PNG", 4))
+    for(s32 order = 1; end - ptr >= (s32)sizeof(Chunk); order++)
     {
-        png_buffer buf = getRawCartFromPng((png_buffer){.data = (u8*)buffer, .size = size});
+        const Chunk* chunk = (Chunk*)ptr;
+        ptr += sizeof(Chunk);
 
-        if(buf.data)
-        {
-            chunk_cart = buf.data;
-            buffer = buf.data;
-            size = buf.size;
-            end = buffer + size;
-        }
-        else
-            return;
+        s32 length = chunkSize(chunk);
+
+        // skip truncated chunk at the end of the buffer
+        if(end - ptr < length)
+            break;
+
+        // deprecated cover always goes to the bank 0 screen
+        s32 bank = chunk->type == CHUNK_COVER_DEP ? 0 : chunk->bank;
+
+        index->chunks[chunk->type][bank] = (tic_cart_chunk){ptr, length, order};
+
+        ptr += length;
     }
 
-#define LOAD_CHUNK(to) memcpy(&to, ptr, MIN(sizeof(to), chunk->size ? retro_le_to_cpu16(chunk->size) : TIC_BANK_SIZE))
+    return true;
+}
+
+void tic_cart_index_close(tic_cart_index* index)
+{
+    FREE(index->png.data);
+    index->png.data = NULL;
+    index->png.size = 0;
+}
+
+static void loadChunk(tic_cartridge* cart, ChunkType type, s32 bank, const tic_cart_chunk* chunk)
+{
+    const u8* ptr = chunk->data;
 
-    // load palette chunk first
+#define LOAD_CHUNK(to) memcpy(&to, ptr, MIN(sizeof(to), chunk->size))
+
+    switch(type)
     {
-        const u8* ptr = buffer;
-        while (ptr < end)
+    case CHUNK_PALETTE:     LOAD_CHUNK(cart->banks[bank].palette);              break;
+    case CHUNK_DEFAULT:
+        memcpy(&cart->banks[bank].palette, Sweetie16, sizeof Sweetie16);
+        memcpy(&cart->banks[bank].sfx.waveforms, Waveforms, sizeof Waveforms);
+        break;
+    case CHUNK_TILES:       LOAD_CHUNK(cart->banks[bank].tiles);                break;
+    case CHUNK_SPRITES:     LOAD_CHUNK(cart->banks[bank].sprites);              break;
+    case CHUNK_MAP:         LOAD_CHUNK(cart->banks[bank].map);                  break;
+    case CHUNK_SAMPLES:     LOAD_CHUNK(cart->banks[bank].sfx.samples);          break;
+    case CHUNK_WAVEFORM:    LOAD_CHUNK(cart->banks[bank].sfx.waveforms);        break;
+    case CHUNK_MUSIC:       LOAD_CHUNK(cart->banks[bank].music.tracks);         break;
+    case CHUNK_PATTERNS:    LOAD_CHUNK(cart->banks[bank].music.patterns);       break;
+    case CHUNK_FLAGS:       LOAD_CHUNK(cart->banks[bank].flags);                break;
+    case CHUNK_SCREEN:      LOAD_CHUNK(cart->banks[bank].screen);               break;
+#if defined(BUILD_DEPRECATED)
+    case CHUNK_COVER_DEP:
         {
-            const Chunk* chunk = (Chunk*)ptr;
-            ptr += sizeof(Chunk);
+            // workaround to load deprecated cover section
+            gif_image* image = gif_read_data(ptr, chunk->size);
 
-            switch (chunk->type)
+            if (image)
             {
-            case CHUNK_PALETTE:
-                LOAD_CHUNK(cart->banks[chunk->bank].palette);
-                break;
-            case CHUNK_DEFAULT:
-                memcpy(&cart->banks[chunk->bank].palette, Sweetie16, sizeof Sweetie16);
-                memcpy(&cart->banks[chunk->bank].sfx.waveforms, Waveforms, sizeof Waveforms);
-                break;
-            default: break;
-            }
+                if(image->width == TIC80_WIDTH && image->height == TIC80_HEIGHT)
+                    for (s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
+                        tic_tool_poke4(cart->bank0.screen.data, i,
+                            tic_nearest_color(cart->bank0.palette.vbank0.colors, (const tic_rgb*)&image->palette[image->buffer[i]], TIC_PALETTE_SIZE));
 
-            ptr += chunkSize(chunk);
+                gif_close(image);
+            }
         }
-
-#if defined(BUILD_DEPRECATED)
-        // workaround to support ancient carts without palette
-        // load DB16 palette if it not exists
-        if (EMPTY(cart->bank0.palette.vbank0.data))
+        break;
+    case CHUNK_PATTERNS_DEP:
         {
-            static const u8 DB16[] = { 0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6 };
-            memcpy(cart->bank0.palette.vbank0.data, DB16, sizeof DB16);
+            // workaround to load deprecated music patterns section
+            // and automatically convert volume value to a command
+            tic_patterns* ptrns = &cart->banks[bank].music.patterns;
+            LOAD_CHUNK(*ptrns);
+            for(s32 i = 0; i < MUSIC_PATTERNS; i++)
+                for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
+                {
+                    tic_track_row* row = &ptrns->data[i].rows[r];
+                    if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
+                    {
+                        row->command = tic_music_cmd_volume;
+                        row->param2 = row->param1 = MAX_VOLUME - row->param1;
+                    }
+                }
         }
+        break;
 #endif
+    default: break;
     }
 
-    struct CodeChunk {s32 size; const char* data;} code[TIC_BANKS] = {0};
-    struct BinaryChunk {s32 size; const u8* data;} binary[TIC_BINARY_BANKS] = {0};
+#undef LOAD_CHUNK
+}
 
+// loads the chunks of the given types in the order they are stored in the cart
+static void loadChunks(tic_cartridge* cart, const tic_cart_index* index, s32 bank, const ChunkType* types, s32 count)
+{
+    for(s32 order = 0;;)
     {
-        const u8* ptr = buffer;
-        while(ptr < end)
+        const tic_cart_chunk* next = NULL;
+        ChunkType type = CHUNK_DUMMY;
+
+        for(s32 i = 0; i < count; i++)
         {
-            const Chunk* chunk = (Chunk*)ptr;
-            ptr += sizeof(Chunk);
+            const tic_cart_chunk* chunk = &index->chunks[types[i]][bank];
+
+            if(chunk->order > order && (!next || chunk->order < next->order))
+                next = chunk, type = types[i];
+        }
+
+        if(!next) break;
+
+        loadChunk(cart, type, bank, next);
+        order = next->order;
+    }
+}
+
+static void loadPalette(tic_cartridge* cart, const tic_cart_index* index, s32 bank)
+{
+    static const ChunkType Types[] = {CHUNK_PALETTE, CHUNK_DEFAULT};
+    loadChunks(cart, index, bank, Types, COUNT_OF(Types));
 
-            switch(chunk->type)
-            {
-            case CHUNK_TILES:       LOAD_CHUNK(cart->banks[chunk->bank].tiles);             break;
-            case CHUNK_SPRITES:     LOAD_CHUNK(cart->banks[chunk->bank].sprites);           break;
-            case CHUNK_MAP:         LOAD_CHUNK(cart->banks[chunk->bank].map);               break;
-            case CHUNK_SAMPLES:     LOAD_CHUNK(cart->banks[chunk->bank].sfx.samples);       break;
-            case CHUNK_WAVEFORM:    LOAD_CHUNK(cart->banks[chunk->bank].sfx.waveforms);     break;
-            case CHUNK_MUSIC:       LOAD_CHUNK(cart->banks[chunk->bank].music.tracks);      break;
-            case CHUNK_PATTERNS:    LOAD_CHUNK(cart->banks[chunk->bank].music.patterns);    break;
-            case CHUNK_FLAGS:       LOAD_CHUNK(cart->banks[chunk->bank].flags);             break;
-            case CHUNK_SCREEN:      LOAD_CHUNK(cart->banks[chunk->bank].screen);            break;
-            case CHUNK_LANG:        LOAD_CHUNK(cart->lang);                                 break;
-            case CHUNK_BINARY:
-                binary[chunk->bank] = (struct BinaryChunk){chunkSize(chunk), ptr};
-                break;
-            case CHUNK_CODE:
-                code[chunk->bank] = (struct CodeChunk){chunkSize(chunk), (char*)ptr};
-                break;
 #if defined(BUILD_DEPRECATED)
-            case CHUNK_CODE_ZIP:
-                tic_tool_unzip(cart->code.data, TIC_CODE_SIZE, ptr, retro_le_to_cpu16(chunk->size));
-                break;
-            case CHUNK_COVER_DEP:
-                {
-                    // workaround to load deprecated cover section
-                    gif_image* image = gif_read_data(ptr, retro_le_to_cpu16(chunk->size));
+    // workaround to support ancient carts without palette
+    // load DB16 palette if it not exists
+    if (bank == 0 && EMPTY(cart->bank0.palette.vbank0.data))
+    {
+        static const u8 DB16[] = { 0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6 };
+        memcpy(cart->bank0.palette.vbank0.data, DB16, sizeof DB16);
+    }
+#endif
+}
 
-                    if (image)
-                    {
-                        if(image->width == TIC80_WIDTH && image->height == TIC80_HEIGHT)
-                            for (s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
-                                tic_tool_poke4(cart->bank0.screen.data, i,
-                                    tic_nearest_color(cart->bank0.palette.vbank0.colors, (const tic_rgb*)&image->palette[image->buffer[i]], TIC_PALETTE_SIZE));
+void tic_cart_load_cover(tic_cartridge* cart, const tic_cart_index* index)
+{
+    static const ChunkType Types[] = {CHUNK_SCREEN, CHUNK_COVER_DEP};
 
-                        gif_close(image);
-                    }
-                }
-                break;
-            case CHUNK_PATTERNS_DEP:
-                {
-                    // workaround to load deprecated music patterns section
-                    // and automatically convert volume value to a command
-                    tic_patterns* ptrns = &cart->banks[chunk->bank].music.patterns;
-                    LOAD_CHUNK(*ptrns);
-                    for(s32 i = 0; i < MUSIC_PATTERNS; i++)
-                        for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
-                        {
-                            tic_track_row* row = &ptrns->data[i].rows[r];
-                            if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
-                            {
-                                row->command = tic_music_cmd_volume;
-                                row->param2 = row->param1 = MAX_VOLUME - row->param1;
-                            }
-                        }
-                }
-                break;
+    // palette goes first, deprecated cover is converted with it
+    loadPalette(cart, index, 0);
+    loadChunks(cart, index, 0, Types, COUNT_OF(Types));
+}
+
+void tic_cart_load_bank(tic_cartridge* cart, const tic_cart_index* index, s32 bank)
+{
+    static const ChunkType Types[] =
+    {
+        CHUNK_TILES, CHUNK_SPRITES, CHUNK_MAP, CHUNK_SAMPLES, CHUNK_WAVEFORM, CHUNK_MUSIC,
+        CHUNK_PATTERNS, CHUNK_FLAGS, CHUNK_SCREEN, CHUNK_COVER_DEP, CHUNK_PATTERNS_DEP,
+    };
+
+    loadPalette(cart, index, bank);
+    loadChunks(cart, index, bank, Types, COUNT_OF(Types));
+}
+
+void tic_cart_load_code(tic_cartridge* cart, const tic_cart_index* index)
+{
+    const tic_cart_chunk* lang = &index->chunks[CHUNK_LANG][0];
+
+    if(lang->data)
+        memcpy(&cart->lang, lang->data, MIN(sizeof cart->lang, lang->size));
+
+    memset(cart->code.data, 0, sizeof cart->code.data);
+
+#if defined(BUILD_DEPRECATED)
+    RFOR(const tic_cart_chunk*, chunk, index->chunks[CHUNK_CODE_ZIP])
+        if (chunk->data)
+            tic_tool_unzip(cart->code.data, TIC_CODE_SIZE, chunk->data, chunk->size);
 #endif
-            default: break;
+
+    if (!*cart->code.data)
+    {
+        char* ptr = cart->code.data;
+        RFOR(const tic_cart_chunk*, chunk, index->chunks[CHUNK_CODE])
+            if (chunk->data)
+            {
+                memcpy(ptr, chunk->data, chunk->size);
+                ptr += chunk->size;
             }
+    }
+}
 
-            ptr += chunkSize(chunk);
-        }
-#undef LOAD_CHUNK
+static void loadBinary(tic_binary* binary, const tic_cart_index* index, ChunkType type)
+{
+    u32 total_size = 0;
+    char* ptr = binary->data;
 
-        {
-            u32 total_size = 0;
-            char* ptr = cart->binary.data;
-            RFOR(const struct BinaryChunk*, chunk, binary)
-                if (chunk->size)
-                {
-                    memcpy(ptr, chunk->data, chunk->size);
-                    ptr += chunk->size;
-                    total_size += chunk->size;
-                }
-            cart->binary.size = total_size;
-        }
+    for(s32 bank = TIC_BINARY_BANKS - 1; bank >= 0; bank--)
+    {
+        const tic_cart_chunk* chunk = &index->chunks[type][bank];
 
-        if (!*cart->code.data)
+        if (chunk->size)
         {
-            char* ptr = cart->code.data;
-            RFOR(const struct CodeChunk*, chunk, code)
-                if (chunk->data)
-                {
-                    memcpy(ptr, chunk->data, chunk->size);
-                    ptr += chunk->size;
-                }
+            memcpy(ptr, chunk->data, chunk->size);
+            ptr += chunk->size;
+            total_size += chunk->size;
         }
     }
-    // if we have allocated the buffer from a PNG chunk
-    if (chunk_cart)
-        free(chunk_cart);
+
+    binary->size = total_size;
+}
+
+bool tic_cart_load_index(tic_cartridge* cart, tic_cart_index* index, const u8* buffer, s32 size)
+{
+    if(!tic_cart_index_open(index, buffer, size))
+        return false;
+
+    memset(cart, 0, sizeof(tic_cartridge));
+
+    for(s32 bank = 0; bank < TIC_BANKS; bank++)
+        tic_cart_load_bank(cart, index, bank);
+
+    loadBinary(&cart->binary, index, CHUNK_BINARY);
+    loadBinary(&cart->bytecode, index, CHUNK_BYTECODE);
+    tic_cart_load_code(cart, index);
+
+    return true;
+}
+
+void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size)
+{
+    tic_cart_index index = {0};
+
+    if(!tic_cart_load_index(cart, &index, buffer, size))
+        memset(cart, 0, sizeof(tic_cartridge));
+
+    tic_cart_index_close(&index);
 }
 
 
@@ -318,6 +387,20 @@ static u8* saveChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32
     return saveFixedChunk(buffer, type, from, chunkSize, bank);
 }
 
+static u8* saveBinary(u8* buffer, ChunkType type, const tic_binary* binary)
+{
+    const char* ptr = binary->data;
+    s32 remaining = binary->size;
+
+    for (s32 i = binary->size / TIC_BANK_SIZE; i >= 0; --i, ptr += TIC_BANK_SIZE)
+    {
+        buffer = saveFixedChunk(buffer, type, ptr, MIN(remaining, TIC_BANK_SIZE), i);
+        remaining -= TIC_BANK_SIZE;
+    }
+
+    return buffer;
+}
+
 s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
 {
     u8* start = buffer;
@@ -355,19 +438,13 @@ s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
         buffer = SAVE_CHUNK(CHUNK_SCREEN,   cart->banks[i].screen,          i);
     }
 
-    const char* ptr;
     if (cart->binary.size)
-    {
-        ptr = cart->binary.data;
-        s32 remaining = cart->binary.size;
-        for (s32 i = cart->binary.size / TIC_BANK_SIZE; i >= 0; --i, ptr += TIC_BANK_SIZE)
-        {
-            buffer = saveFixedChunk(buffer, CHUNK_BINARY, ptr, MIN(remaining, TIC_BANK_SIZE), i);
-            remaining -= TIC_BANK_SIZE;
-        }
-    }
+        buffer = saveBinary(buffer, CHUNK_BINARY, &cart->binary);
+
+    if (cart->bytecode.size)
+        buffer = saveBinary(buffer, CHUNK_BYTECODE, &cart->bytecode);
 
-    ptr = cart->code.data;
+    const char* ptr = cart->code.data;
     for(s32 i = strlen(ptr) / TIC_BANK_SIZE; i >= 0; --i, ptr += TIC_BANK_SIZE)
         buffer = saveFixedChunk(buffer, CHUNK_CODE, ptr, MIN(strlen(ptr), TIC_BANK_SIZE), i);
 
@@ -24,5 +24,41 @@
 
 #include "tic.h"
 
+#define TIC_CART_CHUNK_TYPES 32
+
+typedef struct
+{
+    const u8* data;
+    s32 size;
+    s32 order; // position in the cart, 0 if there is no such chunk
+} tic_cart_chunk;
+
+// chunk directory of a cart buffer, built in one pass without copying anything,
+// the chunks point into the buffer, so it has to outlive the index
+typedef struct
+{
+    tic_cart_chunk chunks[TIC_CART_CHUNK_TYPES][TIC_BANKS];
+
+    // PNG carts are unpacked here, opening the same index again reuses the buffer
+    struct
+    {
+        u8* data;
+        s32 size;
+    } png;
+} tic_cart_index;
+
 void tic_cart_load(tic_cartridge* rom, const u8* buffer, s32 size);
 s32  tic_cart_save(const tic_cartridge* rom, u8* buffer);
+
+// the index has to be zeroed before the first open, close frees the PNG buffer
+bool tic_cart_index_open(tic_cart_index* index, const u8* buffer, s32 size);
+void tic_cart_index_close(tic_cart_index* index);
+
+// loads the whole cart through an index kept by the caller, so PNG carts reuse its buffer,
+// returns false and leaves the cart as it is if the buffer can't be opened
+bool tic_cart_load_index(tic_cartridge* rom, tic_cart_index* index, const u8* buffer, s32 size);
+
+// the loaders below only write their part of the cart, zero it first
+void tic_cart_load_cover(tic_cartridge* rom, const tic_cart_index* index);
+void tic_cart_load_code(tic_cartridge* rom, const tic_cart_index* index);
+void tic_cart_load_bank(tic_cartridge* rom, const tic_cart_index* index, s32 bank);
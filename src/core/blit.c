@@ -0,0 +1,248 @@
+// MIT License
+
+// Copyright (c) 2024 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "api.h"
+#include "core.h"
+
+#include <string.h>
+
+#if defined(TIC80_NO_SIMD) || defined(__EMSCRIPTEN__)
+// scalar path only
+#elif (defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__))
+#define BLIT_SSE2
+#include <emmintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BLIT_AVX2
+#include <immintrin.h>
+#endif
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLIT_NEON
+#include <arm_neon.h>
+#endif
+
+enum
+{
+    RowSize = TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE,
+    Bank1 = TIC_PALETTE_SIZE,
+};
+
+// every row converter takes two 4bpp screen rows and writes TIC80_WIDTH pixels,
+// vbank1 pixel is used unless it equals the clear color, vbank0 pixel otherwise
+
+static void blitRowScalar(u32* dst, const u8* src0, const u8* src1, u8 clear, const tic_blitpal* pal0, const tic_blitpal* pal1)
+{
+    for(const u8* end = src0 + RowSize; src0 != end; ++src0, ++src1)
+    {
+        u8 lo = *src1 & 0xf, hi = *src1 >> 4;
+
+        *dst++ = lo != clear ? pal1->data[lo] : pal0->data[*src0 & 0xf];
+        *dst++ = hi != clear ? pal1->data[hi] : pal0->data[*src0 >> 4];
+    }
+}
+
+// split palette to byte planes, plane[i][c] is the i-th byte of the c color
+static inline void palettePlanes(u8 planes[sizeof(u32)][TIC_PALETTE_SIZE], const tic_blitpal* pal)
+{
+    const u8* src = (const u8*)pal->data;
+
+    for(s32 c = 0; c != TIC_PALETTE_SIZE; ++c)
+        for(s32 i = 0; i != sizeof(u32); ++i)
+            planes[i][c] = *src++;
+}
+
+#if defined(BLIT_SSE2)
+
+// converts 8 bytes of both rows to 16 pixels,
+// SSE2 has no byte shuffle, so only the composition is vectorized
+static inline void blitChunkSse2(u32* dst, const u8* src0, const u8* src1, __m128i clear, const u32* lut)
+{
+    const __m128i mask = _mm_set1_epi8(0xf);
+    const __m128i bank1 = _mm_set1_epi8(Bank1);
+
+    __m128i b0 = _mm_loadl_epi64((const __m128i*)src0);
+    __m128i b1 = _mm_loadl_epi64((const __m128i*)src1);
+
+    __m128i p0 = _mm_unpacklo_epi8(_mm_and_si128(b0, mask), _mm_and_si128(_mm_srli_epi16(b0, 4), mask));
+    __m128i p1 = _mm_unpacklo_epi8(_mm_and_si128(b1, mask), _mm_and_si128(_mm_srli_epi16(b1, 4), mask));
+
+    // index in the joined palette: vbank0 colors go first, vbank1 ones after
+    __m128i sel = _mm_cmpeq_epi8(p1, clear);
+    __m128i idx = _mm_or_si128(_mm_and_si128(sel, p0), _mm_andnot_si128(sel, _mm_add_epi8(p1, bank1)));
+
+    union { __m128i v; u8 data[16]; } index;
+    _mm_storeu_si128(&index.v, idx);
+
+    for(s32 i = 0; i != COUNT_OF(index.data); ++i)
+        dst[i] = lut[index.data[i]];
+}
+
+static inline void joinPalettes(u32* lut, const tic_blitpal* pal0, const tic_blitpal* pal1)
+{
+    memcpy(lut, pal0->data, sizeof pal0->data);
+    memcpy(lut + Bank1, pal1->data, sizeof pal1->data);
+}
+
+static void blitRowSse2(u32* dst, const u8* src0, const u8* src1, u8 clear, const tic_blitpal* pal0, const tic_blitpal* pal1)
+{
+    u32 lut[TIC_PALETTE_SIZE * TIC_PALETTES];
+    joinPalettes(lut, pal0, pal1);
+
+    const __m128i clr = _mm_set1_epi8(clear);
+
+    for(s32 i = 0; i != RowSize; i += 8, dst += 16)
+        blitChunkSse2(dst, src0 + i, src1 + i, clr, lut);
+}
+
+#endif
+
+#if defined(BLIT_AVX2)
+
+__attribute__((target("avx2")))
+static inline __m256i unpackAvx2(const u8* src)
+{
+    const __m128i mask = _mm_set1_epi8(0xf);
+
+    __m128i b = _mm_loadu_si128((const __m128i*)src);
+    __m128i lo = _mm_and_si128(b, mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+
+    // lane0: pixels 0..15, lane1: pixels 16..31
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lo, hi)), _mm_unpackhi_epi8(lo, hi), 1);
+}
+
+__attribute__((target("avx2")))
+static void blitRowAvx2(u32* dst, const u8* src0, const u8* src1, u8 clear, const tic_blitpal* pal0, const tic_blitpal* pal1)
+{
+    u8 planes0[sizeof(u32)][TIC_PALETTE_SIZE], planes1[sizeof(u32)][TIC_PALETTE_SIZE];
+    palettePlanes(planes0, pal0);
+    palettePlanes(planes1, pal1);
+
+    __m256i p0[sizeof(u32)], p1[sizeof(u32)];
+    for(s32 i = 0; i != sizeof(u32); ++i)
+    {
+        p0[i] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)planes0[i]));
+        p1[i] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)planes1[i]));
+    }
+
+    const __m256i clr = _mm256_set1_epi8(clear);
+
+    enum { Chunk = 16, Tail = RowSize % Chunk };
+
+    s32 i = 0;
+    for(; i != RowSize - Tail; i += Chunk, dst += Chunk * 2)
+    {
+        __m256i idx0 = unpackAvx2(src0 + i);
+        __m256i idx1 = unpackAvx2(src1 + i);
+        __m256i sel = _mm256_cmpeq_epi8(idx1, clr);
+
+        __m256i c[sizeof(u32)];
+        for(s32 j = 0; j != sizeof(u32); ++j)
+            c[j] = _mm256_blendv_epi8(_mm256_shuffle_epi8(p1[j], idx1), _mm256_shuffle_epi8(p0[j], idx0), sel);
+
+        // interleave byte planes to pixels, unpacks work inside 128bit lanes
+        __m256i c01lo = _mm256_unpacklo_epi8(c[0], c[1]), c01hi = _mm256_unpackhi_epi8(c[0], c[1]);
+        __m256i c23lo = _mm256_unpacklo_epi8(c[2], c[3]), c23hi = _mm256_unpackhi_epi8(c[2], c[3]);
+
+        __m256i q0 = _mm256_unpacklo_epi16(c01lo, c23lo); // 0..3 16..19
+        __m256i q1 = _mm256_unpackhi_epi16(c01lo, c23lo); // 4..7 20..23
+        __m256i q2 = _mm256_unpacklo_epi16(c01hi, c23hi); // 8..11 24..27
+        __m256i q3 = _mm256_unpackhi_epi16(c01hi, c23hi); // 12..15 28..31
+
+        _mm256_storeu_si256((__m256i*)dst + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+        _mm256_storeu_si256((__m256i*)dst + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+        _mm256_storeu_si256((__m256i*)dst + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+        _mm256_storeu_si256((__m256i*)dst + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+    }
+
+    if(Tail)
+    {
+        u32 lut[TIC_PALETTE_SIZE * TIC_PALETTES];
+        joinPalettes(lut, pal0, pal1);
+        blitChunkSse2(dst, src0 + i, src1 + i, _mm_set1_epi8(clear), lut);
+    }
+}
+
+#endif
+
+#if defined(BLIT_NEON)
+
+static void blitRowNeon(u32* dst, const u8* src0, const u8* src1, u8 clear, const tic_blitpal* pal0, const tic_blitpal* pal1)
+{
+    u8 planes0[sizeof(u32)][TIC_PALETTE_SIZE], planes1[sizeof(u32)][TIC_PALETTE_SIZE];
+    palettePlanes(planes0, pal0);
+    palettePlanes(planes1, pal1);
+
+    uint8x16_t p0[sizeof(u32)], p1[sizeof(u32)];
+    for(s32 i = 0; i != sizeof(u32); ++i)
+        p0[i] = vld1q_u8(planes0[i]), p1[i] = vld1q_u8(planes1[i]);
+
+    const uint8x8_t mask = vdup_n_u8(0xf);
+    const uint8x16_t clr = vdupq_n_u8(clear);
+
+    for(s32 i = 0; i != RowSize; i += 8, dst += 16)
+    {
+        uint8x8_t b0 = vld1_u8(src0 + i), b1 = vld1_u8(src1 + i);
+        uint8x8x2_t z0 = vzip_u8(vand_u8(b0, mask), vshr_n_u8(b0, 4));
+        uint8x8x2_t z1 = vzip_u8(vand_u8(b1, mask), vshr_n_u8(b1, 4));
+        uint8x16_t idx0 = vcombine_u8(z0.val[0], z0.val[1]);
+        uint8x16_t idx1 = vcombine_u8(z1.val[0], z1.val[1]);
+        uint8x16_t sel = vceqq_u8(idx1, clr);
+
+        uint8x16x4_t c;
+        for(s32 j = 0; j != sizeof(u32); ++j)
+            c.val[j] = vbslq_u8(sel, vqtbl1q_u8(p0[j], idx0), vqtbl1q_u8(p1[j], idx1));
+
+        // store interleaves byte planes back to pixels
+        vst4q_u8((u8*)dst, c);
+    }
+}
+
+#endif
+
+#if defined(BLIT_AVX2)
+
+static tic_blit_row SelectedRow = blitRowSse2;
+
+// runs once at load time, before any thread can blit
+__attribute__((constructor)) static void selectBlitRow()
+{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        SelectedRow = blitRowAvx2;
+}
+
+#endif
+
+tic_blit_row tic_core_blit_row()
+{
+#if defined(BLIT_AVX2)
+    return SelectedRow;
+#elif defined(BLIT_SSE2)
+    return blitRowSse2;
+#elif defined(BLIT_NEON)
+    return blitRowNeon;
+#else
+    return blitRowScalar;
+#endif
+}
@@ -250,7 +250,8 @@ s32 tic_api_tstamp(tic_mem* memory)
 static void updateSaveid(tic_mem* memory)
 {
     memset(memory->saveid, 0, sizeof memory->saveid);
-    const char* saveid = tic_tool_metatag(memory->cart.code.data, "saveid", NULL);
+    char saveid[TIC_SAVEID_SIZE];
+    tic_tool_metatag(memory->cart.code.data, "saveid", NULL, saveid, sizeof saveid);
     if (*saveid)
     {
         strncpy(memory->saveid, saveid, TIC_SAVEID_SIZE - 1);
@@ -365,6 +366,12 @@ void tic_api_reset(tic_mem* memory)
     soundClear(memory);
     updateSaveid(memory);
     font2ram(memory);
+
+    // restart the spectrum smoothing, the fft config and the host switch are kept
+    {
+        tic_fft fft = {.cfg = core->fft.cfg, .amplification = 1.0f, .enabled = core->fft.enabled};
+        core->fft = fft;
+    }
 }
 
 static void cart2ram(tic_mem* memory)
@@ -435,15 +442,73 @@ s32 tic_api_vbank(tic_mem* tic, s32 bank)
     return prev;
 }
 
+// an interrupt in flight is still poking the VM, the frame can't end under it
+static void closeFrame(tic_core* core)
+{
+    for(;;)
+    {
+        u32 state = tic_atomic_load(&core->frame.state);
+
+        if(!(state & tic_frame_interrupting) && tic_atomic_cas(&core->frame.state, state, 0))
+            break;
+    }
+}
+
+static void openFrame(tic_core* core)
+{
+    closeFrame(core);
+
+    // tokens skip 0 and leave the low bits for the interrupt state
+    if(++core->frame.count > UINT32_MAX >> 2)
+        core->frame.count = 1;
+
+    tic_atomic_store(&core->frame.state, core->frame.count << 2);
+}
+
+u32 tic_core_frame(tic_mem* tic)
+{
+    tic_core* core = (tic_core*)tic;
+
+    return tic_atomic_load(&core->frame.state) & ~(u32)tic_frame_flags;
+}
+
+bool tic_core_interrupt(tic_mem* tic, u32 frame)
+{
+    tic_core* core = (tic_core*)tic;
+
+    // only a frame that is still running and wasn't interrupted yet can be claimed
+    if(!frame || !tic_atomic_cas(&core->frame.state, frame, frame | tic_frame_interrupting))
+        return false;
+
+    const tic_script* script = core->currentScript;
+    if(core->currentVM && script && script->interrupt)
+        script->interrupt(tic);
+
+    tic_atomic_store(&core->frame.state, frame | tic_frame_interrupted);
+
+    return true;
+}
+
+void tic_core_fft(tic_mem* tic, bool enabled)
+{
+    tic_core* core = (tic_core*)tic;
+
+    core->fft.enabled = enabled;
+}
+
 void tic_core_tick(tic_mem* tic, tic_tick_data* data)
 {
     tic_core* core = (tic_core*)tic;
 
     core->data = data;
 
-    if (fftEnabled)
+    // a script error raised inside an api call skips its apiEnd(),
+    // every entry into the script starts from the top level again
+    core->profile.depth = 0;
+
+    if (core->fft.enabled)
     {
-        FFT_GetFFT(fftData);
+        FFT_GetFFT(&core->fft);
     }
     if (!core->state.initialized)
     {
@@ -459,11 +524,14 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
             core->state.synced = 0;
             tic->input.data = 0;
 
-            if(strcmp(tic_tool_metatag(code, "input", config->singleComment), "mouse") == 0)
+            char input[TIC_METATAG_SIZE];
+            tic_tool_metatag(code, "input", config->singleComment, input, sizeof input);
+
+            if(strcmp(input, "mouse") == 0)
                 tic->input.mouse = 1;
-            else if(strcmp(tic_tool_metatag(code, "input", config->singleComment), "gamepad") == 0)
+            else if(strcmp(input, "gamepad") == 0)
                 tic->input.gamepad = 1;
-            else if(strcmp(tic_tool_metatag(code, "input", config->singleComment), "keyboard") == 0)
+            else if(strcmp(input, "keyboard") == 0)
                 tic->input.keyboard = 1;
             else tic->input.data = -1;  // default is all enabled
 
@@ -472,6 +540,8 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
             if (config->useBinarySection)
                 code = tic->cart.binary.data;
 
+            core->state.defined.scanline = core->state.defined.border = true;
+
             done = tic_init_vm(core, code, config);
         }
         else
@@ -489,7 +559,9 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
         else return;
     }
 
+    u64 start = tic_core_profile_begin(core);
     core->state.tick(tic);
+    tic_core_profile_end(core, tic_profile_tick, start);
 }
 
 void tic_core_pause(tic_mem* memory)
@@ -524,13 +596,173 @@ void tic_core_resume(tic_mem* memory)
     }
 }
 
+#define SNAPSHOT_MAGIC 0x53434954 // "TICS"
+#define SNAPSHOT_VERSION 2
+
+typedef struct
+{
+    u32 magic;
+    u32 version;
+    u32 size;
+    u8 input;
+    // music delay command rows as indexes into RAM patterns, -1 if none
+    s32 delay[TIC_SOUND_CHANNELS];
+    // size of each of the left and right blip buffer states after the snapshot, 0 if none
+    u32 blip;
+} tic_snapshot_header;
+
+// the layout is fixed for a build and pointers are stored as offsets
+typedef struct
+{
+    tic_snapshot_header header;
+    tic_core_state_data state;
+    tic_ram ram;
+} tic_snapshot;
+
+// blip_buf keeps its state opaque, so the sub-frame audio is saved by the layout of blip_buf 1.1,
+// this header followed by the samples, a new buffer is checked against it before it's trusted
+typedef struct
+{
+    u64 factor;
+    u64 offset;
+    s32 avail;
+    s32 size;
+    s32 integrator;
+} BlipState;
+
+enum
+{
+    BlipExtraSamples = 18, // half_width * 2 + end_frame_extra
+    BlipTimeBits = 52,
+};
+
+static u32 blipStateSize(const struct blip_t* blip, s32 size, s32 samplerate)
+{
+    const BlipState* state = (const BlipState*)blip;
+
+    // the factor blip_set_rates() has to come up with
+    double rate = (double)((u64)1 << BlipTimeBits) * samplerate / CLOCKRATE;
+    u64 factor = (u64)rate;
+    if(factor < rate) factor++;
+
+    return state && state->factor == factor && state->size == size && state->avail == 0 && state->integrator == 0
+        ? sizeof(BlipState) + (size + BlipExtraSamples) * sizeof(s32)
+        : 0;
+}
+
+u32 tic_core_snapshot_size(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+
+    return sizeof(tic_snapshot) + core->blip.state * 2;
+}
+
+void tic_core_snapshot(tic_mem* memory, void* buffer)
+{
+    tic_core* core = (tic_core*)memory;
+    tic_snapshot* snapshot = buffer;
+    const tic_track_row* rows = memory->ram->music.patterns.data[0].rows;
+
+    ZEROMEM(snapshot->header);
+    snapshot->header.magic = SNAPSHOT_MAGIC;
+    snapshot->header.version = SNAPSHOT_VERSION;
+    snapshot->header.size = tic_core_snapshot_size(memory);
+    snapshot->header.input = memory->input.data;
+    snapshot->header.blip = core->blip.state;
+
+    memcpy(&snapshot->state, &core->state, sizeof(tic_core_state_data));
+    memcpy(&snapshot->ram, memory->ram, sizeof(tic_ram));
+
+    u8* blip = (u8*)buffer + sizeof(tic_snapshot);
+    memcpy(blip, core->blip.left, core->blip.state);
+    memcpy(blip + core->blip.state, core->blip.right, core->blip.state);
+
+    // process pointers mean nothing in another session, they are relinked on restore
+    ZEROMEM(snapshot->state.tick);
+    ZEROMEM(snapshot->state.callback);
+
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+    {
+        const tic_track_row* row = core->state.music.commands[i].delay.row;
+
+        snapshot->state.sfx.channels[i].pos = NULL;
+        snapshot->state.music.channels[i].pos = NULL;
+        snapshot->state.music.commands[i].delay.row = NULL;
+        snapshot->header.delay[i] = row ? (s32)(row - rows) : -1;
+    }
+}
+
+bool tic_core_restore(tic_mem* memory, const void* buffer, u32 size)
+{
+    tic_core* core = (tic_core*)memory;
+    tic_snapshot_header header;
+
+    if(size < sizeof(tic_snapshot))
+        return false;
+
+    // only the header is copied out, the state and RAM are restored straight from the buffer
+    memcpy(&header, buffer, sizeof header);
+
+    bool valid = header.magic == SNAPSHOT_MAGIC
+        && header.version == SNAPSHOT_VERSION
+        && header.size == size
+        && (u64)size == sizeof(tic_snapshot) + (u64)header.blip * 2;
+
+    for(s32 i = 0; valid && i < TIC_SOUND_CHANNELS; i++)
+        valid = header.delay[i] >= -1 && header.delay[i] < MUSIC_PATTERNS * MUSIC_PATTERN_ROWS;
+
+    if(!valid)
+        return false;
+
+    // the script VM isn't part of the snapshot, keep the links to the running one
+    tic_tick tick = core->state.tick;
+    tic_blit_callback callback = core->state.callback;
+    bool scanline = core->state.defined.scanline;
+    bool border = core->state.defined.border;
+    bool initialized = core->state.initialized;
+
+    const u8* data = buffer;
+    memcpy(&core->state, data + offsetof(tic_snapshot, state), sizeof(tic_core_state_data));
+    memcpy(memory->ram, data + offsetof(tic_snapshot, ram), sizeof(tic_ram));
+    memory->input.data = header.input;
+
+    // buffers of another sample rate or blip_buf don't fit, the running ones are kept then
+    if(header.blip && header.blip == core->blip.state)
+    {
+        memcpy(core->blip.left, data + sizeof(tic_snapshot), header.blip);
+        memcpy(core->blip.right, data + sizeof(tic_snapshot) + header.blip, header.blip);
+    }
+
+    core->state.tick = tick;
+    core->state.callback = callback;
+    core->state.defined.scanline = scanline;
+    core->state.defined.border = border;
+    core->state.initialized = initialized;
+
+    const tic_track_row* rows = memory->ram->music.patterns.data[0].rows;
+
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+    {
+        core->state.sfx.channels[i].pos = &memory->ram->sfxpos[i];
+        core->state.music.channels[i].pos = &core->state.music.sfxpos[i];
+        core->state.music.commands[i].delay.row = header.delay[i] < 0 ? NULL : rows + header.delay[i];
+    }
+
+    tic_core_invalidate(memory, 0, TIC80_FULLHEIGHT);
+
+    return true;
+}
+
 void tic_core_close(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
 
     core->state.initialized = false;
 
+    closeFrame(core);
     tic_close_current_vm(core);
+    tic_core_profile_close(core);
+    FFT_Free(&core->fft);
 
     blip_delete(core->blip.left);
     blip_delete(core->blip.right);
@@ -541,13 +773,23 @@ void tic_core_close(tic_mem* memory)
     free(memory->product.screen);
 #endif
     free(memory->product.samples.buffer);
+    free(memory->base_ram);
     free(core);
 }
 
 void tic_core_tick_start(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
-    tic_core_sound_tick_start(memory);
+
+    openFrame(core);
+    tic_core_profile_next(core);
+
+    {
+        u64 start = tic_core_profile_begin(core);
+        tic_core_sound_tick_start(memory);
+        tic_core_profile_end(core, tic_profile_sound, start);
+    }
+
     tic_core_tick_io(memory);
 
     // SECURITY: preserve the system keyboard/game controller input state
@@ -614,89 +856,160 @@ static inline void updpal(tic_mem* tic, tic_blitpal* pal0, tic_blitpal* pal1)
     *pal1 = tic_tool_palette_blit(&vbank1(core)->palette, core->screen_format);
 }
 
-static inline void updbdr(tic_mem* tic, s32 row, u32* ptr, tic_blit_callback clb, tic_blitpal* pal0, tic_blitpal* pal1)
+static inline void updbdr(tic_mem* tic, s32 row, tic_blit_callback clb, tic_blitpal* pal0, tic_blitpal* pal1)
 {
     tic_core* core = (tic_core*)tic;
 
-    if(clb.border) clb.border(tic, row, clb.data);
+    core->profile.depth = 0;
 
-    if(clb.scanline)
+    if(clb.border)
     {
-        if(row == 0) clb.scanline(tic, 0, clb.data);
-        else if(row > TIC80_MARGIN_TOP && row < (TIC80_HEIGHT + TIC80_MARGIN_TOP))
-            clb.scanline(tic, row - TIC80_MARGIN_TOP, clb.data);
+        u64 start = tic_core_profile_begin(core);
+        clb.border(tic, row, clb.data);
+        tic_core_profile_end(core, tic_profile_border, start);
+    }
+
+    if(clb.scanline && (row == 0 || (row > TIC80_MARGIN_TOP && row < (TIC80_HEIGHT + TIC80_MARGIN_TOP))))
+    {
+        u64 start = tic_core_profile_begin(core);
+        clb.scanline(tic, row == 0 ? 0 : row - TIC80_MARGIN_TOP, clb.data);
+        tic_core_profile_end(core, tic_profile_scanline, start);
     }
 
     if(clb.border || clb.scanline)
         updpal(tic, pal0, pal1);
+}
 
-    memset4(ptr, pal0->data[vbank0(core)->vars.border], TIC80_FULLWIDTH);
+// rotates the screen row left by the offset, returns the source row if there is nothing to rotate
+static inline const u8* offsetRow(u8* buf, const u8* src, s32 offset)
+{
+    enum { RowSize = TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE };
+
+    offset = tic_modulo(offset, TIC80_WIDTH);
+
+    if(offset == 0)
+        return src;
+
+    s32 start = offset >> 1;
+
+    if(offset & 1)
+    {
+        for(s32 i = 0, j = start; i != RowSize; ++i)
+        {
+            s32 next = j + 1 == RowSize ? 0 : j + 1;
+            buf[i] = (src[j] >> 4) | (src[next] << 4);
+            j = next;
+        }
+    }
+    else
+    {
+        memcpy(buf, src + start, RowSize - start);
+        memcpy(buf + RowSize - start, src, start);
+    }
+
+    return buf;
 }
 
-static inline u32 blitpix(tic_mem* tic, s32 offset0, s32 offset1, const tic_blitpal* pal0, const tic_blitpal* pal1)
+static inline bool checkRow(const u32* mask, s32 row)
 {
-    tic_core* core = (tic_core*)tic;
-    u32 pix = tic_tool_peek4(vbank1(core)->screen.data, offset1);
+    return (mask[row >> 5] >> (row & 31)) & 1;
+}
 
-    return pix != vbank1(core)->vars.clear
-        ? pal1->data[pix]
-        : pal0->data[tic_tool_peek4(vbank0(core)->screen.data, offset0)];
+static inline void setRow(u32* mask, s32 row, bool value)
+{
+    if(value)
+        mask[row >> 5] |= 1u << (row & 31);
+    else
+        mask[row >> 5] &= ~(1u << (row & 31));
 }
 
 void tic_core_blit_ex(tic_mem* tic, tic_blit_callback clb)
 {
     tic_core* core = (tic_core*)tic;
 
+    enum { RowSize = TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE };
+    enum { OffsetY = TIC80_HEIGHT - TIC80_MARGIN_TOP };
+
+    tic_blit_row blitrow = tic_core_blit_row();
+    u64 start = tic_core_profile_begin(core);
+
     tic_blitpal pal0, pal1;
     updpal(tic, &pal0, &pal1);
 
-    s32 row = 0;
-    u32* rowPtr = tic->product.screen;
+    ZEROMEM(tic->product.dirty);
 
-#define UPDBDR() updbdr(tic, row, rowPtr, clb, &pal0, &pal1)
+    for(s32 row = 0; row != TIC80_FULLHEIGHT; ++row)
+    {
+        updbdr(tic, row, clb, &pal0, &pal1);
 
-    for(; row != TIC80_MARGIN_TOP; ++row, rowPtr += TIC80_FULLWIDTH)
-        UPDBDR();
+        // border and scanline callbacks can switch banks, so resolve them per row
+        const tic_vram* banks[TIC_PALETTES] = {vbank0(core), vbank1(core)};
+        bool screen = row >= TIC80_MARGIN_TOP && row < TIC80_FULLHEIGHT - TIC80_MARGIN_BOTTOM;
 
-    for(; row != TIC80_FULLHEIGHT - TIC80_MARGIN_BOTTOM; ++row)
-    {
-        UPDBDR();
-        rowPtr += TIC80_MARGIN_LEFT;
+        tic_blit_row_data data;
+        ZEROMEM(data);
+        data.border = pal0.data[banks[0]->vars.border];
 
-        if(*(u16*)&vbank0(core)->vars.offset == 0 && *(u16*)&vbank1(core)->vars.offset == 0)
+        if(screen)
         {
-            // render line without XY offsets
-            for(s32 x = (row - TIC80_MARGIN_TOP) * TIC80_WIDTH, end = x + TIC80_WIDTH; x != end; ++x)
-                *rowPtr++ = blitpix(tic, x, x, &pal0, &pal1);
+            data.pal[0] = pal0;
+            data.pal[1] = pal1;
+            data.clear = banks[1]->vars.clear;
+
+            for(s32 i = 0; i != COUNT_OF(banks); ++i)
+            {
+                s32 offset = (row + banks[i]->vars.offset.y + OffsetY) % TIC80_HEIGHT * RowSize;
+                memcpy(data.screen[i], banks[i]->screen.data + offset, RowSize);
+                data.offset[i] = banks[i]->vars.offset.x;
+            }
         }
-        else
+
+        // skip the row if it would be converted to the same pixels
+        tic_blit_row_data* cache = &core->blit.rows[row];
+        if(!checkRow(core->blit.invalid, row) && MEMCMP(*cache, data))
+            continue;
+
+        *cache = data;
+        setRow(core->blit.invalid, row, false);
+        setRow(tic->product.dirty, row, true);
+
+        u32* rowPtr = tic->product.screen + row * TIC80_FULLWIDTH;
+
+        if(screen)
         {
-            // render line with XY offsets
-            enum{OffsetY = TIC80_HEIGHT - TIC80_MARGIN_TOP};
-            s32 start0 = (row + vbank0(core)->vars.offset.y + OffsetY) % TIC80_HEIGHT * TIC80_WIDTH;
-            s32 start1 = (row + vbank1(core)->vars.offset.y + OffsetY) % TIC80_HEIGHT * TIC80_WIDTH;
-            s32 offsetX0 = vbank0(core)->vars.offset.x;
-            s32 offsetX1 = vbank1(core)->vars.offset.x;
-
-            for(s32 x = TIC80_WIDTH; x != 2 * TIC80_WIDTH; ++x)
-                *rowPtr++ = blitpix(tic, (x + offsetX0) % TIC80_WIDTH + start0,
-                    (x + offsetX1) % TIC80_WIDTH + start1, &pal0, &pal1);
+            u8 buf0[RowSize], buf1[RowSize];
+
+            memset4(rowPtr, data.border, TIC80_MARGIN_LEFT);
+            blitrow(rowPtr + TIC80_MARGIN_LEFT,
+                offsetRow(buf0, data.screen[0], data.offset[0]),
+                offsetRow(buf1, data.screen[1], data.offset[1]),
+                data.clear, &data.pal[0], &data.pal[1]);
+            memset4(rowPtr + TIC80_MARGIN_LEFT + TIC80_WIDTH, data.border, TIC80_MARGIN_RIGHT);
         }
-
-        rowPtr += TIC80_MARGIN_RIGHT;
+        else memset4(rowPtr, data.border, TIC80_FULLWIDTH);
     }
 
-    for(; row != TIC80_FULLHEIGHT; ++row, rowPtr += TIC80_FULLWIDTH)
-        UPDBDR();
+    tic_core_profile_end(core, tic_profile_blit, start);
+}
+
+void tic_core_invalidate(tic_mem* tic, s32 top, s32 bottom)
+{
+    tic_core* core = (tic_core*)tic;
 
-#undef  UPDBDR
+    // rows were changed outside of the blit, mark them updated and redraw them next time
+    for(s32 row = MAX(top, 0), end = MIN(bottom, TIC80_FULLHEIGHT); row < end; ++row)
+    {
+        setRow(core->blit.invalid, row, true);
+        setRow(tic->product.dirty, row, true);
+    }
 }
 
 static inline void scanline(tic_mem* memory, s32 row, void* data)
 {
     tic_core* core = (tic_core*)memory;
 
-    if (core->state.initialized)
+    // once interrupted the rest of the frame runs without the script
+    if (core->state.initialized && !tic_core_interrupted(core))
         core->state.callback.scanline(memory, row, data);
 }
 
@@ -704,13 +1017,21 @@ static inline void border(tic_mem* memory, s32 row, void* data)
 {
     tic_core* core = (tic_core*)memory;
 
-    if (core->state.initialized)
+    if (core->state.initialized && !tic_core_interrupted(core))
         core->state.callback.border(memory, row, data);
 }
 
 void tic_core_blit(tic_mem* tic)
 {
-    tic_core_blit_ex(tic, (tic_blit_callback){scanline, border, NULL});
+    tic_core* core = (tic_core*)tic;
+
+    tic_core_blit_ex(tic, (tic_blit_callback)
+    {
+        core->state.defined.scanline ? scanline : NULL,
+        core->state.defined.border ? border : NULL,
+        NULL
+    });
+    closeFrame(core);
 }
 
 tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format)
@@ -734,6 +1055,8 @@ tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format)
 #else
     product->screen = malloc(TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof product->screen[0]);
 #endif
+    memset(core->blit.invalid, 0xff, sizeof core->blit.invalid);
+
     product->samples.count = samplerate * TIC80_SAMPLE_CHANNELS / TIC80_FRAMERATE;
     product->samples.buffer = malloc(product->samples.count * TIC80_SAMPLESIZE);
 
@@ -743,6 +1066,8 @@ tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format)
     blip_set_rates(core->blip.left, CLOCKRATE, samplerate);
     blip_set_rates(core->blip.right, CLOCKRATE, samplerate);
 
+    core->blip.state = blipStateSize(core->blip.left, samplerate / 10, samplerate);
+
     {
 #define API_FUNC_DEF(name, ...) core->api.name = tic_api_ ## name;
         TIC_API_LIST(API_FUNC_DEF)
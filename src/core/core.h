@@ -25,6 +25,7 @@
 #include "api.h"
 #include "tools.h"
 #include "script.h"
+#include "fftdata.h"
 
 #define CLOCKRATE (255<<13)
 #define TIC_DEFAULT_COLOR 15
@@ -34,7 +35,7 @@ typedef struct
 {
     s32 time;       /* clock time of next delta */
     s32 phase;      /* position within waveform */
-    s32 amp;        /* current amplitude in delta buffer */
+    s32 amp[2];     /* current amplitude in left/right delta buffer */
 }tic_sound_register_data;
 
 typedef struct
@@ -116,11 +117,8 @@ typedef struct
 
     struct
     {
-        struct sound_register_data
-        {
-            tic_sound_register_data data[TIC_SOUND_CHANNELS];
-            tic_sound_register_data pcm;
-        } left, right;
+        tic_sound_register_data data[TIC_SOUND_CHANNELS];
+        tic_sound_register_data pcm;
     } registers;
 
     struct sound_ring_buf
@@ -149,9 +147,25 @@ typedef struct
         s32 speed;
     } music;
 
+    // offline rendering, see tic_core_render_sound
+    struct tic_render_state
+    {
+        bool active;
+        // ticks left for an sfx, -1 plays the music until it stops
+        s32 ticks;
+        u8 mute;
+    } render;
+
     tic_tick tick;
     tic_blit_callback callback;
 
+    // VMs clear these when the cart doesn't define SCN/BDR, the blit skips the calls then
+    struct
+    {
+        bool scanline;
+        bool border;
+    } defined;
+
     u32 synced;
 
     struct
@@ -168,6 +182,46 @@ typedef struct
     bool initialized;
 } tic_core_state_data;
 
+// everything a screen row of the blit depends on,
+// the row is converted again only if any of it changed
+typedef struct
+{
+    tic_blitpal pal[TIC_PALETTES];
+    u8 screen[TIC_PALETTES][TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE];
+    u32 border;
+    s8 offset[TIC_PALETTES];
+    u8 clear;
+    u8 reserved;
+} tic_blit_row_data;
+
+typedef struct
+{
+    u64 start;
+    u64 time;
+    u32 zone;
+} tic_profile_event;
+
+#define TIC_FILL_QUEUE_SIZE 400
+
+// Queue frame for floodFill.
+// Filled horizontal segment of scanline y for xl <= x <= xr.
+// Parent segment was on line y – dy. dy = 1 or –1.
+typedef struct
+{
+    s32 y;
+    s32 xl;
+    s32 xr;
+    s32 dy;
+} tic_fill_segment;
+
+// unpacked map() tile, `block` is the ptr_size block of the bank it was unpacked from
+typedef struct
+{
+    u8 pixels[TIC_SPRITESIZE * TIC_SPRITESIZE];
+    u8 block;
+    bool valid;
+} tic_tile_cache_item;
+
 typedef struct
 {
     tic_mem memory; // it should be first
@@ -176,10 +230,21 @@ typedef struct
     void* currentVM;
     const tic_script* currentScript;
 
+    // token of the running frame with the interrupt state in the low bits, 0 between frames,
+    // tic_core_interrupt() changes it from any thread, VMs that can poll it stop the script
+    struct
+    {
+        tic_atomic state;
+        u32 count;
+    } frame;
+
     struct
     {
         struct blip_t* left;
         struct blip_t* right;
+
+        // bytes of a buffer state in the snapshots, 0 if blip_buf doesn't have the known layout
+        u32 state;
     } blip;
 
     s32 samplerate;
@@ -199,6 +264,68 @@ typedef struct
         } time;
     } pause;
 
+    struct
+    {
+        tic_blit_row_data rows[TIC80_FULLHEIGHT];
+        u32 invalid[TIC80_DIRTY_SIZE];
+    } blit;
+
+    // scratch buffers of the drawing functions, nothing in the core is process global
+    // so separate instances can be ticked from separate threads
+    struct
+    {
+        double zbuffer[TIC80_WIDTH * TIC80_HEIGHT];
+
+        struct
+        {
+            s16 left[TIC80_HEIGHT];
+            s16 right[TIC80_HEIGHT];
+#if defined BUILD_DEPRECATED
+            s32 uleft[TIC80_HEIGHT];
+            s32 vleft[TIC80_HEIGHT];
+#endif
+        } sides;
+
+        struct
+        {
+            tic_fill_segment seg[TIC_FILL_QUEUE_SIZE];
+            size_t ini; // index of empty next in
+            size_t outi; // index of next out
+        } fill;
+
+        // tiles unpacked by map(), checked against a copy of the bank on every call,
+        // so writes to the tiles from any path (poke, memcpy, sync, wasm memory) are noticed
+        struct
+        {
+            u8 bank[sizeof(tic_tiles)];
+            u8 segment;
+            bool ready;
+            tic_tile_cache_item items[TIC_BANK_SPRITES];
+        } tiles;
+    } draw;
+
+    tic_fft fft;
+
+    struct
+    {
+        u64 (*counter)();
+        u64 (*freq)();
+
+        u64 start;
+        u64 time[tic_profile_count];
+        u32 calls[tic_profile_count];
+        s32 depth;
+
+        tic_profile_frame frame;
+
+        struct
+        {
+            tic_profile_event* items;
+            s32 count;
+            bool record;
+        } trace;
+    } profile;
+
     struct
     {
     #define API_FUNC_DEF(name, _, __, ___, ____, _____, ret, ...) ret (*name)(__VA_ARGS__);
@@ -212,6 +339,19 @@ typedef struct
 
 } tic_core;
 
+// converts two 4bpp screen rows (vbank0 and vbank1) to TIC80_WIDTH pixels
+typedef void(*tic_blit_row)(u32* dst, const u8* src0, const u8* src1, u8 clear, const tic_blitpal* pal0, const tic_blitpal* pal1);
+
+tic_blit_row tic_core_blit_row();
+
+static inline u64 tic_core_profile_begin(tic_core* core)
+{
+    return core->profile.counter ? core->profile.counter() : 0;
+}
+
+void tic_core_profile_end(tic_core* core, tic_profile_zone zone, u64 start);
+void tic_core_profile_next(tic_core* core);
+void tic_core_profile_close(tic_core* core);
 void tic_core_tick_io(tic_mem* memory);
 void tic_core_sound_tick_start(tic_mem* memory);
 void tic_core_sound_tick_end(tic_mem* memory);
@@ -223,10 +363,24 @@ void tic_core_sound_tick_end(tic_mem* memory);
     core->api.vbank(&CORE->memory, BANK),                                     \
     CORE->memory.ram->vram.vars.cursor = CORE->state.vbank.mem.vars.cursor
 
-#define OVR(CORE)                                   \
-    s32 MACROVAR(_bank_) = CORE->state.vbank.id;    \
-    OVR_COMPAT(CORE, 1);                            \
-    core->api.cls(&CORE->memory, 0);                  \
-    SCOPE(OVR_COMPAT(CORE, MACROVAR(_bank_)))
+#define OVR(CORE)                                                       \
+    s32 MACROVAR(_bank_) = CORE->state.vbank.id;                        \
+    u64 MACROVAR(_start_) = tic_core_profile_begin(CORE);               \
+    OVR_COMPAT(CORE, 1);                                                \
+    core->api.cls(&CORE->memory, 0);                                    \
+    SCOPE(OVR_COMPAT(CORE, MACROVAR(_bank_)),                           \
+        tic_core_profile_end(CORE, tic_profile_overline, MACROVAR(_start_)))
 
 #endif
+
+enum
+{
+    tic_frame_interrupting = 1 << 0,
+    tic_frame_interrupted = 1 << 1,
+    tic_frame_flags = tic_frame_interrupting | tic_frame_interrupted,
+};
+
+static inline bool tic_core_interrupted(tic_core* core)
+{
+    return tic_atomic_load(&core->frame.state) & tic_frame_flags;
+}
@@ -47,9 +47,8 @@ static tic_tilesheet getTileSheetFromSegment(tic_mem* memory, u8 segment)
     return tic_tilesheet_get(segment, src);
 }
 
-static u8* getPalette(tic_mem* tic, u8* colors, u8 count)
+static u8* getPalette(tic_mem* tic, u8* colors, u8 count, u8* mapping)
 {
-    static u8 mapping[TIC_PALETTE_SIZE];
     for (s32 i = 0; i < TIC_PALETTE_SIZE; i++) mapping[i] = tic_tool_peek4(tic->ram->vram.mapping, i);
     for (s32 i = 0; i < count; i++) {
         if (colors[i] < TIC_PALETTE_SIZE)
@@ -67,24 +66,45 @@ static inline u8 mapColor(tic_mem* tic, u8 color)
 
 static inline void setPixel(tic_core* core, s32 x, s32 y, u8 color)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
-
     if (x < core->state.clip.l || y < core->state.clip.t || x >= core->state.clip.r || y >= core->state.clip.b) return;
 
-    tic_api_poke4((tic_mem*)core, y * TIC80_WIDTH + x, color);
+    tic_tool_poke4(core->memory.ram->vram.screen.data, y * TIC80_WIDTH + x, color);
 }
 
 static inline void setPixelFast(tic_core* core, s32 x, s32 y, u8 color)
 {
     // does not do any CLIP checking, the caller needs to do that first
-    tic_api_poke4((tic_mem*)core, y * TIC80_WIDTH + x, color);
+    tic_tool_poke4(core->memory.ram->vram.screen.data, y * TIC80_WIDTH + x, color);
 }
 
 static inline u8 getPixel(tic_core* core, s32 x, s32 y)
 {
     return x < 0 || y < 0 || x >= TIC80_WIDTH || y >= TIC80_HEIGHT
         ? 0
-        : tic_api_peek4((tic_mem*)core, y * TIC80_WIDTH + x);
+        : tic_tool_peek4(core->memory.ram->vram.screen.data, y * TIC80_WIDTH + x);
+}
+
+// fills pixels [start, end) of the screen with the color,
+// odd edges are written as nibbles and the middle part with memset
+static inline void fillScreenSpan(u8* screen, s32 start, s32 end, u8 color)
+{
+    if (start >= end) return;
+
+    if (start & 1)
+        tic_tool_poke4(screen, start++, color);
+
+    if (end & 1)
+        tic_tool_poke4(screen, --end, color);
+
+    if (start < end)
+        memset(screen + (start >> 1), (color & 0xf) | (color << TIC_PALETTE_BPP), (end - start) >> 1);
+}
+
+static inline void drawSpan(tic_core* core, s32 y, s32 xl, s32 xr, u8 color)
+{
+    // does not do any CLIP checking, the caller needs to do that first
+    s32 start = y * TIC80_WIDTH;
+    fillScreenSpan(core->memory.ram->vram.screen.data, start + xl, start + xr, color);
 }
 
 #define EARLY_CLIP(x, y, width, height) \
@@ -97,16 +117,12 @@ static inline u8 getPixel(tic_core* core, s32 x, s32 y)
 
 static void drawHLine(tic_core* core, s32 x, s32 y, s32 width, u8 color)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
-
     if (y < core->state.clip.t || core->state.clip.b <= y) return;
 
     s32 xl = MAX(x, core->state.clip.l);
     s32 xr = MIN(x + width, core->state.clip.r);
-    s32 start = y * TIC80_WIDTH;
 
-    for(s32 i = start + xl, end = start + xr; i < end; ++i)
-        tic_api_poke4((tic_mem*)core, i, color);
+    drawSpan(core, y, xl, xr, color);
 }
 
 static void drawVLine(tic_core* core, s32 x, s32 y, s32 height, u8 color)
@@ -124,8 +140,15 @@ static void drawVLine(tic_core* core, s32 x, s32 y, s32 height, u8 color)
 
 static void drawRect(tic_core* core, s32 x, s32 y, s32 width, s32 height, u8 color)
 {
-    for (s32 i = y; i < y + height; ++i)
-        drawHLine(core, x, i, width, color);
+    s32 xl = MAX(x, core->state.clip.l);
+    s32 xr = MIN(x + width, core->state.clip.r);
+    s32 yt = MAX(y, core->state.clip.t);
+    s32 yb = MIN(y + height, core->state.clip.b);
+
+    if (xl >= xr) return;
+
+    for (s32 i = yt; i < yb; ++i)
+        drawSpan(core, i, xl, xr, color);
 }
 
 static void drawRectBorder(tic_core* core, s32 x, s32 y, s32 width, s32 height, u8 color)
@@ -137,25 +160,53 @@ static void drawRectBorder(tic_core* core, s32 x, s32 y, s32 width, s32 height,
     drawVLine(core, x + width - 1, y, height, color);
 }
 
+// writes a row of mapped colors skipping the transparent ones,
+// opaque pixel pairs go to the screen as whole bytes
+static inline void drawTileRow(tic_core* core, s32 x, s32 y, const u8* row, s32 count)
+{
+    // does not do any CLIP checking, the caller needs to do that first
+    u8* screen = core->memory.ram->vram.screen.data;
+    s32 pixel = y * TIC80_WIDTH + x;
+    s32 i = 0;
+
+    if (pixel & 1)
+    {
+        if (row[i] != TRANSPARENT_COLOR) tic_tool_poke4(screen, pixel, row[i]);
+        i++, pixel++;
+    }
+
+    for (; i + 1 < count; i += 2, pixel += 2)
+    {
+        u8 a = row[i], b = row[i + 1];
+
+        if (a != TRANSPARENT_COLOR && b != TRANSPARENT_COLOR)
+            screen[pixel >> 1] = (a & 0xf) | (b << TIC_PALETTE_BPP);
+        else
+        {
+            if (a != TRANSPARENT_COLOR) tic_tool_poke4(screen, pixel, a);
+            if (b != TRANSPARENT_COLOR) tic_tool_poke4(screen, pixel + 1, b);
+        }
+    }
+
+    if (i < count && row[i] != TRANSPARENT_COLOR)
+        tic_tool_poke4(screen, pixel, row[i]);
+}
+
 #define DRAW_TILE_BODY(X, Y) do {\
     for(s32 py=sy; py < ey; py++, y++) \
     { \
-        s32 xx = x; \
-        for(s32 px=sx; px < ex; px++, xx++) \
-        { \
-            u8 color = mapping[tic_tilesheet_gettilepix(tile, (X), (Y))];\
-            if(color != TRANSPARENT_COLOR) setPixelFast(core, xx, y, color); \
-        } \
+        u8 row[TIC_SPRITESIZE]; \
+        for(s32 px=sx; px < ex; px++) \
+            row[px - sx] = mapping[pixels[(Y) * TIC_SPRITESIZE + (X)]]; \
+        drawTileRow(core, x, y, row, ex - sx); \
     } \
     } while(0)
 
 #define REVERT(X) (TIC_SPRITESIZE - 1 - (X))
 
-static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
+// draws unpacked tile pixels, see tic_tilesheet_gettilepixels
+static void drawTilePixels(tic_core* core, const u8* pixels, const u8* mapping, s32 x, s32 y, s32 scale, tic_flip flip, tic_rotate rotate)
 {
-    const tic_vram* vram = &core->memory.ram->vram;
-    u8* mapping = getPalette(&core->memory, colors, count);
-
     rotate &= 3;
     u32 orientation = flip & 3;
 
@@ -171,6 +222,7 @@ static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors
         sy = core->state.clip.t - y; if (sy < 0) sy = 0;
         ex = core->state.clip.r - x; if (ex > TIC_SPRITESIZE) ex = TIC_SPRITESIZE;
         ey = core->state.clip.b - y; if (ey > TIC_SPRITESIZE) ey = TIC_SPRITESIZE;
+        if (sx >= ex) return;
         y += sy;
         x += sx;
         switch (orientation) {
@@ -198,7 +250,7 @@ static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors
             if (orientation & 4) {
                 s32 tmp = ix; ix = iy; iy = tmp;
             }
-            u8 color = mapping[tic_tilesheet_gettilepix(tile, ix, iy)];
+            u8 color = mapping[pixels[iy * TIC_SPRITESIZE + ix]];
             if (color != TRANSPARENT_COLOR) drawRect(core, xx, y, scale, scale, color);
         }
     }
@@ -207,6 +259,72 @@ static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors
 #undef DRAW_TILE_BODY
 #undef REVERT
 
+static void drawTile(tic_core* core, tic_tileptr* tile, s32 x, s32 y, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
+{
+    u8 palette[TIC_PALETTE_SIZE];
+    u8* mapping = getPalette(&core->memory, colors, count, palette);
+
+    u8 pixels[TIC_SPRITESIZE * TIC_SPRITESIZE];
+    tic_tilesheet_gettilepixels(tile, pixels);
+
+    drawTilePixels(core, pixels, mapping, x, y, scale, flip, rotate);
+}
+
+// returns the bank map() takes its tiles from, with its size
+static const u8* getTileBank(const tic_tilesheet* sheet, s32* size)
+{
+    *size = TIC_BANK_SPRITES * (s32)sheet->segment->ptr_size;
+    return sheet->ptr + sheet->segment->bank_orig * *size;
+}
+
+// drops the cached tiles whose bank blocks were changed since the last map() call
+static void updateTileCache(tic_core* core, const tic_tilesheet* sheet, u8 segment)
+{
+    s32 size;
+    const u8* bank = getTileBank(sheet, &size);
+    const s32 block = (s32)sheet->segment->ptr_size;
+
+    if (!core->draw.tiles.ready || core->draw.tiles.segment != segment)
+    {
+        for (s32 i = 0; i < COUNT_OF(core->draw.tiles.items); i++)
+            core->draw.tiles.items[i].valid = false;
+
+        core->draw.tiles.segment = segment;
+        core->draw.tiles.ready = true;
+    }
+    else if (memcmp(core->draw.tiles.bank, bank, size) != 0)
+    {
+        for (s32 i = 0; i < COUNT_OF(core->draw.tiles.items); i++)
+        {
+            tic_tile_cache_item* item = &core->draw.tiles.items[i];
+
+            if (item->valid && memcmp(core->draw.tiles.bank + item->block * block, bank + item->block * block, block) != 0)
+                item->valid = false;
+        }
+    }
+    else return;
+
+    memcpy(core->draw.tiles.bank, bank, size);
+}
+
+static const u8* getCachedTile(tic_core* core, const tic_tilesheet* sheet, s32 index)
+{
+    tic_tile_cache_item* item = &core->draw.tiles.items[index & (TIC_BANK_SPRITES - 1)];
+
+    if (!item->valid)
+    {
+        s32 size;
+        const u8* bank = getTileBank(sheet, &size);
+        tic_tileptr tile = tic_tilesheet_gettile(sheet, index, true);
+
+        tic_tilesheet_gettilepixels(&tile, item->pixels);
+        item->block = (u8)((tile.ptr - bank) / (s32)sheet->segment->ptr_size);
+        item->valid = true;
+    }
+
+    return item->pixels;
+}
+
 static void drawSprite(tic_core* core, s32 index, s32 x, s32 y, s32 w, s32 h, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
 {
     const tic_vram* vram = &core->memory.ram->vram;
@@ -274,7 +392,14 @@ static void drawMap(tic_core* core, const tic_map* src, s32 x, s32 y, s32 width,
 {
     const s32 size = TIC_SPRITESIZE * scale;
 
-    tic_tilesheet sheet = getTileSheetFromSegment(&core->memory, core->memory.ram->vram.blit.segment);
+    u8 segment = core->memory.ram->vram.blit.segment;
+    tic_tilesheet sheet = getTileSheetFromSegment(&core->memory, segment);
+
+    u8 palette[TIC_PALETTE_SIZE];
+    u8* mapping = getPalette(&core->memory, colors, count, palette);
+
+    // tile writes made by the remap callback show up on the next map() call
+    updateTileCache(core, &sheet, segment);
 
     for (s32 j = y, jj = sy; j < y + height; j++, jj += size)
         for (s32 i = x, ii = sx; i < x + width; i++, ii += size)
@@ -286,10 +411,14 @@ static void drawMap(tic_core* core, const tic_map* src, s32 x, s32 y, s32 width,
             RemapResult retile = { *(src->data + index), tic_no_flip, tic_no_rotate };
 
             if (remap)
+            {
                 remap(data, mi, mj, &retile);
+                mapping = getPalette(&core->memory, colors, count, palette);
+            }
+
+            if (EARLY_CLIP(ii, jj, size, size)) continue;
 
-            tic_tileptr tile = tic_tilesheet_gettile(&sheet, retile.index, true);
-            drawTile(core, &tile, ii, jj, colors, count, scale, retile.flip, retile.rotate);
+            drawTilePixels(core, getCachedTile(core, &sheet, retile.index), mapping, ii, jj, scale, retile.flip, retile.rotate);
         }
 }
 
@@ -301,15 +430,18 @@ static s32 drawChar(tic_core* core, tic_tileptr* font_char, s32 x, s32 y, s32 sc
 
     s32 j = 0, start = 0, end = Size;
 
+    u8 pixels[Size * Size];
+    tic_tilesheet_gettilepixels(font_char, pixels);
+
     if (!fixed) {
         for (s32 i = 0; i < Size; i++) {
             for (j = 0; j < Size; j++)
-                if (mapping[tic_tilesheet_gettilepix(font_char, i, j)] != TRANSPARENT_COLOR) break;
+                if (mapping[pixels[j * Size + i]] != TRANSPARENT_COLOR) break;
             if (j < Size) break; else start++;
         }
         for (s32 i = Size - 1; i >= start; i--) {
             for (j = 0; j < Size; j++)
-                if (mapping[tic_tilesheet_gettilepix(font_char, i, j)] != TRANSPARENT_COLOR) break;
+                if (mapping[pixels[j * Size + i]] != TRANSPARENT_COLOR) break;
             if (j < Size) break; else end--;
         }
     }
@@ -323,7 +455,7 @@ static s32 drawChar(tic_core* core, tic_tileptr* font_char, s32 x, s32 y, s32 sc
     {
         for (s32 j = 0, row = rowStart, ys = y; j < Size; j++, row += rowStep, ys += scale)
         {
-            u8 color = tic_tilesheet_gettilepix(font_char, col, row);
+            u8 color = pixels[row * Size + col];
             if (mapping[color] != TRANSPARENT_COLOR)
                 drawRect(core, xs, ys, scale, scale, mapping[color]);
         }
@@ -380,8 +512,6 @@ void tic_api_rect(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 color
     drawRect(core, x, y, width, height, mapColor(memory, color));
 }
 
-static double ZBuffer[TIC80_WIDTH * TIC80_HEIGHT];
-
 void tic_api_cls(tic_mem* tic, u8 color)
 {
     tic_core* core = (tic_core*)tic;
@@ -394,22 +524,24 @@ void tic_api_cls(tic_mem* tic, u8 color)
     if (MEMCMP(core->state.clip, EmptyClip))
     {
         memset(&vram->screen, (color & 0xf) | (color << TIC_PALETTE_BPP), sizeof(tic_screen));
-        ZEROMEM(ZBuffer);
+        ZEROMEM(core->draw.zbuffer);
     }
     else
     {
         for(s32 y = core->state.clip.t, start = y * TIC80_WIDTH; y < core->state.clip.b; ++y, start += TIC80_WIDTH)
+        {
+            drawSpan(core, y, core->state.clip.l, core->state.clip.r, color);
+
             for(s32 x = core->state.clip.l, pixel = start + x; x < core->state.clip.r; ++x, ++pixel)
-            {
-                tic_api_poke4(tic, pixel, color);
-                ZBuffer[pixel] = 0;
-            }
+                core->draw.zbuffer[pixel] = 0;
+        }
     }
 }
 
 s32 tic_api_font(tic_mem* memory, const char* text, s32 x, s32 y, u8* trans_colors, u8 trans_count, s32 w, s32 h, bool fixed, s32 scale, bool alt)
 {
-    u8* mapping = getPalette(memory, trans_colors, trans_count);
+    u8 palette[TIC_PALETTE_SIZE];
+    u8* mapping = getPalette(memory, trans_colors, trans_count, palette);
 
     // Compatibility : flip top and bottom of the spritesheet
     // to preserve tic_api_font's default target
@@ -440,24 +572,29 @@ void tic_api_spr(tic_mem* memory, s32 index, s32 x, s32 y, s32 w, s32 h, u8* tra
 
 static inline u8* getFlag(tic_mem* memory, s32 index, u8 flag)
 {
-    static u8 stub = 0;
     if (index >= TIC_FLAGS || flag >= BITS_IN_BYTE)
-        return &stub;
+        return NULL;
 
     return memory->ram->flags.data + index;
 }
 
 bool tic_api_fget(tic_mem* memory, s32 index, u8 flag)
 {
-    return *getFlag(memory, index, flag) & (1 << flag);
+    const u8* flags = getFlag(memory, index, flag);
+    return flags && (*flags & (1 << flag));
 }
 
 void tic_api_fset(tic_mem* memory, s32 index, u8 flag, bool value)
 {
+    u8* flags = getFlag(memory, index, flag);
+
+    if (!flags)
+        return;
+
     if (value)
-        *getFlag(memory, index, flag) |= (1 << flag);
+        *flags |= (1 << flag);
     else
-        *getFlag(memory, index, flag) &= ~(1 << flag);
+        *flags &= ~(1 << flag);
 }
 
 u8 tic_api_pix(tic_mem* memory, s32 x, s32 y, u8 color, bool get)
@@ -477,24 +614,18 @@ void tic_api_rectb(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 colo
     drawRectBorder(core, x, y, width, height, mapColor(memory, color));
 }
 
-static struct
-{
-    s16 Left[TIC80_HEIGHT];
-    s16 Right[TIC80_HEIGHT];
-} SidesBuffer;
-
-static void initSidesBuffer()
+static void initSidesBuffer(tic_core* core)
 {
-    for (s32 i = 0; i < COUNT_OF(SidesBuffer.Left); i++)
-        SidesBuffer.Left[i] = TIC80_WIDTH, SidesBuffer.Right[i] = -1;
+    for (s32 i = 0; i < COUNT_OF(core->draw.sides.left); i++)
+        core->draw.sides.left[i] = TIC80_WIDTH, core->draw.sides.right[i] = -1;
 }
 
-static void setSidePixel(s32 x, s32 y)
+static void setSidePixel(tic_core* core, s32 x, s32 y)
 {
     if (y >= 0 && y < TIC80_HEIGHT)
     {
-        if (x < SidesBuffer.Left[y]) SidesBuffer.Left[y] = x;
-        if (x > SidesBuffer.Right[y]) SidesBuffer.Right[y] = x;
+        if (x < core->draw.sides.left[y]) core->draw.sides.left[y] = x;
+        if (x > core->draw.sides.right[y]) core->draw.sides.right[y] = x;
     }
 }
 
@@ -539,31 +670,26 @@ static void setElliPixel(tic_mem* tic, s32 x, s32 y, u8 color)
 
 static void setElliSide(tic_mem* tic, s32 x, s32 y, u8 color)
 {
-    setSidePixel(x, y);
+    setSidePixel((tic_core*)tic, x, y);
 }
 
 static void drawSidesBuffer(tic_mem* memory, s32 y0, s32 y1, u8 color)
 {
-    tic_vram* vram = &memory->ram->vram;
-
     tic_core* core = (tic_core*)memory;
     s32 yt = MAX(core->state.clip.t, y0);
     s32 yb = MIN(core->state.clip.b, y1 + 1);
-    u8 final_color = mapColor(&core->memory, color);
     for (s32 y = yt; y < yb; y++)
     {
-        s32 xl = MAX(SidesBuffer.Left[y], core->state.clip.l);
-        s32 xr = MIN(SidesBuffer.Right[y] + 1, core->state.clip.r);
-        s32 start = y * TIC80_WIDTH;
+        s32 xl = MAX(core->draw.sides.left[y], core->state.clip.l);
+        s32 xr = MIN(core->draw.sides.right[y] + 1, core->state.clip.r);
 
-        for(s32 i = start + xl, end = start + xr; i < end; ++i)
-            tic_api_poke4(memory, i, color);
+        drawSpan(core, y, xl, xr, color);
     }
 }
 
 void tic_api_circ(tic_mem* memory, s32 x, s32 y, s32 r, u8 color)
 {
-    initSidesBuffer();
+    initSidesBuffer((tic_core*)memory);
     drawEllipse(memory, x - r, y - r, x + r, y + r, 0, setElliSide);
     drawSidesBuffer(memory, y - r, y + r + 1, mapColor(memory, color));
 }
@@ -575,7 +701,7 @@ void tic_api_circb(tic_mem* memory, s32 x, s32 y, s32 r, u8 color)
 
 void tic_api_elli(tic_mem* memory, s32 x, s32 y, s32 a, s32 b, u8 color)
 {
-    initSidesBuffer();
+    initSidesBuffer((tic_core*)memory);
     drawEllipse(memory, x - a, y - b, x + a, y + b, 0, setElliSide);
     drawSidesBuffer(memory, y - b, y + b + 1, mapColor(memory, color));
 }
@@ -613,50 +739,31 @@ static void drawLine(tic_mem* tic, float x0, float y0, float x1, float y1, u8 co
     setPixel((tic_core*)tic, x1, y1, color);
 }
 
-// Queue frame for floodFill.
-// Filled horizontal segment of scanline y for xl <= x <= xr.
-// Parent segment was on line y – dy. dy = 1 or –1.
-typedef struct
-{
-    s32 y;
-    s32 xl;
-    s32 xr;
-    s32 dy;
-} FillSegment;
-
-#define FILLQUEUESIZE 400
-static struct
-{
-    FillSegment seg[FILLQUEUESIZE];
-    size_t ini; // index of empty next in
-    size_t outi; // index of next out
-} fillQueue;
-
 static inline void fillEnqueue(tic_core* tic, s32 y, s32 xl, s32 xr, s32 dy)
 {
-    size_t nextini = (fillQueue.ini + 1) % FILLQUEUESIZE;
-    if (nextini == fillQueue.outi)
+    size_t nextini = (tic->draw.fill.ini + 1) % TIC_FILL_QUEUE_SIZE;
+    if (nextini == tic->draw.fill.outi)
         return; // queue full
     if (y + dy < tic->state.clip.t || y + dy >= tic->state.clip.b)
         return;
-    FillSegment* qseg = &fillQueue.seg[fillQueue.ini];
+    tic_fill_segment* qseg = &tic->draw.fill.seg[tic->draw.fill.ini];
     qseg->y = y;
     qseg->xl = xl;
     qseg->xr = xr;
     qseg->dy = dy;
-    fillQueue.ini = nextini;
+    tic->draw.fill.ini = nextini;
 }
 
-static inline bool fillDequeue(s32* y, s32* xl, s32* xr, s32* dy)
+static inline bool fillDequeue(tic_core* tic, s32* y, s32* xl, s32* xr, s32* dy)
 {
-    if (fillQueue.ini == fillQueue.outi)
+    if (tic->draw.fill.ini == tic->draw.fill.outi)
         return false; // queue empty
-    FillSegment* qseg = &fillQueue.seg[fillQueue.outi];
+    tic_fill_segment* qseg = &tic->draw.fill.seg[tic->draw.fill.outi];
     *y = qseg->y + qseg->dy;
     *xl = qseg->xl;
     *xr = qseg->xr;
     *dy = qseg->dy;
-    fillQueue.outi = (fillQueue.outi + 1) % FILLQUEUESIZE;
+    tic->draw.fill.outi = (tic->draw.fill.outi + 1) % TIC_FILL_QUEUE_SIZE;
     return true;
 }
 
@@ -674,11 +781,11 @@ static void floodFill(tic_core* tic, s32 x, s32 y, u8 color, u8 border)
     u8 ov = getPixel(tic, x, y);
     if (ov == color || ov == border)
         return;
-    fillQueue.ini = fillQueue.outi = 0;
+    tic->draw.fill.ini = tic->draw.fill.outi = 0;
     fillEnqueue(tic, y, x, x, 1); // needed in some cases
     fillEnqueue(tic, y + 1, x, x, -1); // seed segment
     s32 l, x1, x2, dy;
-    while (fillDequeue(&y, &x1, &x2, &dy))
+    while (fillDequeue(tic, &y, &x1, &x2, &dy))
     {
         // segment of scan line y-dy for x1<=x<=x2 was previously filled,
         // now explore adjacent pixels in scan line y
@@ -737,6 +844,7 @@ static inline double edgeFn(const Vec2* a, const Vec2* b, const Vec2* c)
     return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
 }
 
+// NULL shader draws the triangle with the flat color pointed by data
 static void drawTri(tic_mem* tic, const Vec2* v0, const Vec2* v1, const Vec2* v2, PixelShader shader, void* data)
 {
     ShaderAttr a = {data, v0, v1, v2};
@@ -778,18 +886,39 @@ static void drawTri(tic_mem* tic, const Vec2* v0, const Vec2* v1, const Vec2* v2
         s.d[i] = edgeFn(a.v[c], a.v[n], &p) / area;
     }
 
+#define TRI_INSIDE(W) ((W).x > -DBL_EPSILON && (W).y > -DBL_EPSILON && (W).z > -DBL_EPSILON)
+
+    u8* screen = tic->ram->vram.screen.data;
+
     for(s32 y = min.y, start = min.y * TIC80_WIDTH + min.x; y < max.y; ++y, start += TIC80_WIDTH)
     {
         for(s32 i = 0; i != COUNT_OF(a.w.d); ++i)
             a.w.d[i] = s.d[i];
 
-        for(s32 x = min.x, pixel = start; x < max.x; ++x, ++pixel)
+        if(!shader)
         {
-            if(a.w.x > -DBL_EPSILON && a.w.y > -DBL_EPSILON && a.w.z > -DBL_EPSILON)
+            // flat color: the triangle covers one continuous run of the row
+            s32 x = min.x, pixel = start, first = -1;
+
+            for(; x < max.x; ++x, ++pixel)
+            {
+                if(TRI_INSIDE(a.w)) { if(first < 0) first = pixel; }
+                else if(first >= 0) break;
+
+                for(s32 i = 0; i != COUNT_OF(a.w.d); ++i)
+                    a.w.d[i] += d[i].x;
+            }
+
+            if(first >= 0)
+                fillScreenSpan(screen, first, pixel, *(u8*)data);
+        }
+        else for(s32 x = min.x, pixel = start; x < max.x; ++x, ++pixel)
+        {
+            if(TRI_INSIDE(a.w))
             {
                 u8 color = shader(&a, pixel);
                 if(color != TRANSPARENT_COLOR)
-                    tic_api_poke4(tic, pixel, color);
+                    tic_tool_poke4(screen, pixel, color);
             }
 
             for(s32 i = 0; i != COUNT_OF(a.w.d); ++i)
@@ -799,9 +928,9 @@ static void drawTri(tic_mem* tic, const Vec2* v0, const Vec2* v1, const Vec2* v2
         for(s32 i = 0; i != COUNT_OF(s.d); ++i)
             s.d[i] += d[i].y;
     }
-}
 
-static tic_color triColorShader(const ShaderAttr* a, s32 pixel){return *(u8*)a->data;}
+#undef TRI_INSIDE
+}
 
 void tic_api_tri(tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color)
 {
@@ -810,7 +939,7 @@ void tic_api_tri(tic_mem* tic, float x1, float y1, float x2, float y2, float x3,
         &(Vec2){x1, y1},
         &(Vec2){x2, y2},
         &(Vec2){x3, y3},
-        triColorShader, &color);
+        NULL, &color);
 }
 
 void tic_api_trib(tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color)
@@ -834,6 +963,7 @@ typedef struct
 {
     tic_tilesheet sheet;
     u8* mapping;
+    double* zbuffer;
     const u8* map;
     const tic_vram* vram;
     bool depth;
@@ -852,7 +982,7 @@ static inline bool shaderStart(const ShaderAttr* a, Vec3* vars, s32 pixel)
             vars->z += a->w.d[i] * t->d.z;
         }
 
-        if(ZBuffer[pixel] < vars->z);
+        if(data->zbuffer[pixel] < vars->z);
         else return false;
     }
 
@@ -876,7 +1006,7 @@ static inline tic_color shaderEnd(const ShaderAttr* a, const Vec3* vars, s32 pix
     TexData* data = a->data;
 
     if(data->depth && color != TRANSPARENT_COLOR)
-        ZBuffer[pixel] = vars->z;
+        data->zbuffer[pixel] = vars->z;
 
     return color;
 }
@@ -943,10 +1073,13 @@ void tic_api_ttri(tic_mem* tic,
     if(z1 < FLT_EPSILON || z2 < FLT_EPSILON || z3 < FLT_EPSILON)
         depth = false;
 
+    u8 palette[TIC_PALETTE_SIZE];
+
     TexData texData =
     {
         .sheet = getTileSheetFromSegment(tic, tic->ram->vram.blit.segment),
-        .mapping = getPalette(tic, colors, count),
+        .mapping = getPalette(tic, colors, count, palette),
+        .zbuffer = ((tic_core*)tic)->draw.zbuffer,
         .map = tic->ram->map.data,
         .vram = &((tic_core*)tic)->state.vbank.mem,
         .depth = depth,
@@ -1012,6 +1145,52 @@ void tic_api_paint(tic_mem* memory, s32 x, s32 y, u8 color, u8 bordercolor)
     floodFill((tic_core*)memory, x, y, mapColor(memory, color), bordercolor);
 }
 
+s32 tic_api_drawlist(tic_mem* memory, const s32* list, s32 size)
+{
+    static const u8 Args[] =
+    {
+        [tic_draw_pix]      = 3,
+        [tic_draw_line]     = 5,
+        [tic_draw_rect]     = 5,
+        [tic_draw_rectb]    = 5,
+        [tic_draw_circ]     = 4,
+        [tic_draw_spr]      = 9,
+    };
+
+    const s32* ptr = list;
+    const s32* end = list + size;
+
+    while(ptr < end)
+    {
+        u32 op = *ptr;
+
+        if(op >= COUNT_OF(Args) || end - ptr <= Args[op])
+            break;
+
+        const s32* a = ptr + 1;
+
+        switch(op)
+        {
+        case tic_draw_pix:      tic_api_pix(memory, a[0], a[1], a[2], false); break;
+        case tic_draw_line:     tic_api_line(memory, a[0], a[1], a[2], a[3], a[4]); break;
+        case tic_draw_rect:     tic_api_rect(memory, a[0], a[1], a[2], a[3], a[4]); break;
+        case tic_draw_rectb:    tic_api_rectb(memory, a[0], a[1], a[2], a[3], a[4]); break;
+        case tic_draw_circ:     tic_api_circ(memory, a[0], a[1], a[2], a[3]); break;
+        case tic_draw_spr:
+            {
+                u8 colorkey = a[3];
+                tic_api_spr(memory, a[0], a[1], a[2], a[7], a[8], &colorkey, 1, a[4], a[5], a[6]);
+            }
+            break;
+        }
+
+        ptr += Args[op] + 1;
+    }
+
+    // the number of consumed values, lets bindings feed the list in chunks
+    return (s32)(ptr - list);
+}
+
 #if defined(BUILD_DEPRECATED)
 #include "draw_dep.c"
 #endif
@@ -25,28 +25,20 @@ typedef struct
     float x, y, u, v;
 } TexVertDep;
 
-static struct
-{
-    s16 Left[TIC80_HEIGHT];
-    s16 Right[TIC80_HEIGHT];
-    s32 ULeft[TIC80_HEIGHT];
-    s32 VLeft[TIC80_HEIGHT];
-} SidesBufferDep;
-
-static void setSideTexPixel(s32 x, s32 y, float u, float v)
+static void setSideTexPixel(tic_core* core, s32 x, s32 y, float u, float v)
 {
     s32 yy = y;
     if (yy >= 0 && yy < TIC80_HEIGHT)
     {
-        if (x < SidesBufferDep.Left[yy])
+        if (x < core->draw.sides.left[yy])
         {
-            SidesBufferDep.Left[yy] = x;
-            SidesBufferDep.ULeft[yy] = (s32)(u * 65536.0f);
-            SidesBufferDep.VLeft[yy] = (s32)(v * 65536.0f);
+            core->draw.sides.left[yy] = x;
+            core->draw.sides.uleft[yy] = (s32)(u * 65536.0f);
+            core->draw.sides.vleft[yy] = (s32)(v * 65536.0f);
         }
-        if (x > SidesBufferDep.Right[yy])
+        if (x > core->draw.sides.right[yy])
         {
-            SidesBufferDep.Right[yy] = x;
+            core->draw.sides.right[yy] = x;
         }
     }
 }
@@ -96,7 +88,7 @@ static void ticTexLine(tic_mem* memory, TexVertDep* v0, TexVertDep* v1)
 
     for (; y < botY; ++y)
     {
-        setSideTexPixel((s32)x, (s32)y, u, v);
+        setSideTexPixel((tic_core*)memory, (s32)x, (s32)y, u, v);
         x += step_x;
         u += step_u;
         v += step_v;
@@ -108,7 +100,8 @@ void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, flo
     tic_core* core = (tic_core*)memory;
     tic_vram* vram = &memory->ram->vram;
 
-    u8* mapping = getPalette(memory, colors, count);
+    u8 palette[TIC_PALETTE_SIZE];
+    u8* mapping = getPalette(memory, colors, count, palette);
     TexVertDep V0, V1, V2;
 
     const u8* map = memory->ram->map.data;
@@ -134,8 +127,8 @@ void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, flo
     s32 dudxs = (s32)(dudx * 65536.0f);
     s32 dvdxs = (s32)(dvdx * 65536.0f);
     //  fill the buffer 
-    for (s32 i = 0; i < COUNT_OF(SidesBuffer.Left); i++)
-        SidesBufferDep.Left[i] = TIC80_WIDTH, SidesBufferDep.Right[i] = -1;
+    for (s32 i = 0; i < COUNT_OF(core->draw.sides.left); i++)
+        core->draw.sides.left[i] = TIC80_WIDTH, core->draw.sides.right[i] = -1;
 
     //  parse each line and decide where in the buffer to store them ( left or right ) 
     ticTexLine(memory, &V0, &V1);
@@ -145,23 +138,23 @@ void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, flo
     for (s32 y = 0; y < TIC80_HEIGHT; y++)
     {
         //  if it's backwards skip it
-        s32 width = SidesBufferDep.Right[y] - SidesBufferDep.Left[y];
+        s32 width = core->draw.sides.right[y] - core->draw.sides.left[y];
         //  if it's off top or bottom , skip this line
         if ((y < core->state.clip.t) || (y > core->state.clip.b))
             width = 0;
         if (width > 0)
         {
-            s32 u = SidesBufferDep.ULeft[y];
-            s32 v = SidesBufferDep.VLeft[y];
-            s32 left = SidesBufferDep.Left[y];
-            s32 right = SidesBufferDep.Right[y];
+            s32 u = core->draw.sides.uleft[y];
+            s32 v = core->draw.sides.vleft[y];
+            s32 left = core->draw.sides.left[y];
+            s32 right = core->draw.sides.right[y];
             //  check right edge, and CLAMP it
             if (right > core->state.clip.r)
                 right = core->state.clip.r;
             //  check left edge and offset UV's if we are off the left 
             if (left < core->state.clip.l)
             {
-                s32 dist = core->state.clip.l - SidesBufferDep.Left[y];
+                s32 dist = core->state.clip.l - core->draw.sides.left[y];
                 u += dudxs * dist;
                 v += dvdxs * dist;
                 left = core->state.clip.l;
@@ -206,4 +199,4 @@ void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, flo
             }
         }
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
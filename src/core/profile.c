@@ -0,0 +1,265 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TIC_PROFILE_TRACE_SIZE (1 << 18)
+
+void tic_core_profile_end(tic_core* core, tic_profile_zone zone, u64 start)
+{
+    if(!core->profile.counter || !start)
+        return;
+
+    u64 time = core->profile.counter() - start;
+
+    core->profile.time[zone] += time;
+    core->profile.calls[zone]++;
+
+    if(core->profile.trace.record && core->profile.trace.count < TIC_PROFILE_TRACE_SIZE)
+        core->profile.trace.items[core->profile.trace.count++] = (tic_profile_event){start, time, zone};
+}
+
+// the cart calls the api through core->api, profiled versions time the outermost call only,
+// so the time of the api called from a map() remap callback is not counted twice
+
+static inline u64 apiBegin(tic_core* core)
+{
+    return core->profile.depth++ ? 0 : tic_core_profile_begin(core);
+}
+
+static inline void apiEnd(tic_core* core, tic_profile_zone zone, u64 start)
+{
+    if(--core->profile.depth)
+        core->profile.calls[zone]++;
+    else if(core->profile.counter && start)
+    {
+        core->profile.time[zone] += core->profile.counter() - start;
+        core->profile.calls[zone]++;
+    }
+}
+
+#define PROFILE_FUNC(zone, ret, name, params, ...)          \
+    static ret profile_##name params                        \
+    {                                                       \
+        tic_core* core = (tic_core*)tic;                    \
+        u64 start = apiBegin(core);                         \
+        ret result = tic_api_##name(__VA_ARGS__);           \
+        apiEnd(core, tic_profile_##zone, start);            \
+        return result;                                      \
+    }
+
+#define PROFILE_PROC(zone, name, params, ...)               \
+    static void profile_##name params                       \
+    {                                                       \
+        tic_core* core = (tic_core*)tic;                    \
+        u64 start = apiBegin(core);                         \
+        tic_api_##name(__VA_ARGS__);                        \
+        apiEnd(core, tic_profile_##zone, start);            \
+    }
+
+PROFILE_FUNC(draw, s32, print, (tic_mem* tic, const char* text, s32 x, s32 y, u8 color, bool fixed, s32 scale, bool alt), tic, text, x, y, color, fixed, scale, alt)
+PROFILE_PROC(draw, cls, (tic_mem* tic, u8 color), tic, color)
+PROFILE_FUNC(draw, u8, pix, (tic_mem* tic, s32 x, s32 y, u8 color, bool get), tic, x, y, color, get)
+PROFILE_PROC(draw, line, (tic_mem* tic, float x1, float y1, float x2, float y2, u8 color), tic, x1, y1, x2, y2, color)
+PROFILE_PROC(draw, rect, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, u8 color), tic, x, y, width, height, color)
+PROFILE_PROC(draw, rectb, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, u8 color), tic, x, y, width, height, color)
+PROFILE_PROC(draw, spr, (tic_mem* tic, s32 index, s32 x, s32 y, s32 w, s32 h, u8* trans_colors, u8 trans_count, s32 scale, tic_flip flip, tic_rotate rotate), tic, index, x, y, w, h, trans_colors, trans_count, scale, flip, rotate)
+PROFILE_FUNC(input, u32, btn, (tic_mem* tic, s32 id), tic, id)
+PROFILE_FUNC(input, u32, btnp, (tic_mem* tic, s32 id, s32 hold, s32 period), tic, id, hold, period)
+PROFILE_PROC(audio, sfx, (tic_mem* tic, s32 index, s32 note, s32 octave, s32 duration, s32 channel, s32 left, s32 right, s32 speed), tic, index, note, octave, duration, channel, left, right, speed)
+PROFILE_PROC(draw, map, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* trans_colors, u8 trans_count, s32 scale, RemapFunc remap, void* data), tic, x, y, width, height, sx, sy, trans_colors, trans_count, scale, remap, data)
+PROFILE_FUNC(memory, u8, mget, (tic_mem* tic, s32 x, s32 y), tic, x, y)
+PROFILE_PROC(memory, mset, (tic_mem* tic, s32 x, s32 y, u8 value), tic, x, y, value)
+PROFILE_FUNC(memory, u8, peek, (tic_mem* tic, s32 address, s32 bits), tic, address, bits)
+PROFILE_PROC(memory, poke, (tic_mem* tic, s32 address, u8 value, s32 bits), tic, address, value, bits)
+PROFILE_FUNC(memory, u8, peek1, (tic_mem* tic, s32 address), tic, address)
+PROFILE_PROC(memory, poke1, (tic_mem* tic, s32 address, u8 value), tic, address, value)
+PROFILE_FUNC(memory, u8, peek2, (tic_mem* tic, s32 address), tic, address)
+PROFILE_PROC(memory, poke2, (tic_mem* tic, s32 address, u8 value), tic, address, value)
+PROFILE_FUNC(memory, u8, peek4, (tic_mem* tic, s32 address), tic, address)
+PROFILE_PROC(memory, poke4, (tic_mem* tic, s32 address, u8 value), tic, address, value)
+PROFILE_PROC(memory, memcpy, (tic_mem* tic, s32 dst, s32 src, s32 size), tic, dst, src, size)
+PROFILE_PROC(memory, memset, (tic_mem* tic, s32 dst, u8 val, s32 size), tic, dst, val, size)
+PROFILE_PROC(system, trace, (tic_mem* tic, const char* text, u8 color), tic, text, color)
+PROFILE_FUNC(memory, u32, pmem, (tic_mem* tic, s32 index, u32 value, bool get), tic, index, value, get)
+PROFILE_FUNC(system, double, time, (tic_mem* tic), tic)
+PROFILE_FUNC(system, s32, tstamp, (tic_mem* tic), tic)
+PROFILE_PROC(system, exit, (tic_mem* tic), tic)
+PROFILE_FUNC(draw, s32, font, (tic_mem* tic, const char* text, s32 x, s32 y, u8* trans_colors, u8 trans_count, s32 w, s32 h, bool fixed, s32 scale, bool alt), tic, text, x, y, trans_colors, trans_count, w, h, fixed, scale, alt)
+PROFILE_FUNC(input, tic_point, mouse, (tic_mem* tic), tic)
+PROFILE_PROC(draw, circ, (tic_mem* tic, s32 x, s32 y, s32 radius, u8 color), tic, x, y, radius, color)
+PROFILE_PROC(draw, circb, (tic_mem* tic, s32 x, s32 y, s32 radius, u8 color), tic, x, y, radius, color)
+PROFILE_PROC(draw, elli, (tic_mem* tic, s32 x, s32 y, s32 a, s32 b, u8 color), tic, x, y, a, b, color)
+PROFILE_PROC(draw, ellib, (tic_mem* tic, s32 x, s32 y, s32 a, s32 b, u8 color), tic, x, y, a, b, color)
+PROFILE_PROC(draw, paint, (tic_mem* tic, s32 x, s32 y, u8 color, u8 bordercolor), tic, x, y, color, bordercolor)
+PROFILE_PROC(draw, tri, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color), tic, x1, y1, x2, y2, x3, y3, color)
+PROFILE_PROC(draw, trib, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, u8 color), tic, x1, y1, x2, y2, x3, y3, color)
+PROFILE_PROC(draw, ttri, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, tic_texture_src texsrc, u8* colors, s32 count, float z1, float z2, float z3, bool depth), tic, x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, texsrc, colors, count, z1, z2, z3, depth)
+PROFILE_PROC(draw, clip, (tic_mem* tic, s32 x, s32 y, s32 width, s32 height), tic, x, y, width, height)
+PROFILE_PROC(audio, music, (tic_mem* tic, s32 track, s32 frame, s32 row, bool loop, bool sustain, s32 tempo, s32 speed), tic, track, frame, row, loop, sustain, tempo, speed)
+PROFILE_PROC(memory, sync, (tic_mem* tic, u32 mask, s32 bank, bool toCart), tic, mask, bank, toCart)
+PROFILE_FUNC(draw, s32, vbank, (tic_mem* tic, s32 bank), tic, bank)
+PROFILE_PROC(system, reset, (tic_mem* tic), tic)
+PROFILE_FUNC(input, bool, key, (tic_mem* tic, tic_key key), tic, key)
+PROFILE_FUNC(input, bool, keyp, (tic_mem* tic, tic_key key, s32 hold, s32 period), tic, key, hold, period)
+PROFILE_FUNC(memory, bool, fget, (tic_mem* tic, s32 index, u8 flag), tic, index, flag)
+PROFILE_PROC(memory, fset, (tic_mem* tic, s32 index, u8 flag, bool value), tic, index, flag, value)
+PROFILE_FUNC(audio, double, fft, (tic_mem* tic, s32 startFreq, s32 endFreq), tic, startFreq, endFreq)
+PROFILE_FUNC(audio, double, ffts, (tic_mem* tic, s32 startFreq, s32 endFreq), tic, startFreq, endFreq)
+PROFILE_FUNC(draw, s32, drawlist, (tic_mem* tic, const s32* list, s32 size), tic, list, size)
+
+#if defined BUILD_DEPRECATED
+void tic_api_textri(tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count);
+PROFILE_PROC(draw, textri, (tic_mem* tic, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count), tic, x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map, colors, count)
+#endif
+
+#undef PROFILE_FUNC
+#undef PROFILE_PROC
+
+static void setApi(tic_core* core, bool profile)
+{
+#define API_FUNC_DEF(name, ...) core->api.name = profile ? profile_ ## name : tic_api_ ## name;
+    TIC_API_LIST(API_FUNC_DEF)
+#undef  API_FUNC_DEF
+
+#if defined BUILD_DEPRECATED
+    core->api.textri = profile ? profile_textri : tic_api_textri;
+#endif
+}
+
+void tic_core_profile(tic_mem* tic, u64 (*counter)(), u64 (*freq)())
+{
+    tic_core* core = (tic_core*)tic;
+
+    core->profile.counter = freq ? counter : NULL;
+    core->profile.freq = freq;
+    core->profile.start = tic_core_profile_begin(core);
+
+    ZEROMEM(core->profile.time);
+    ZEROMEM(core->profile.calls);
+    ZEROMEM(core->profile.frame);
+
+    setApi(core, core->profile.counter != NULL);
+}
+
+void tic_core_profile_next(tic_core* core)
+{
+    if(!core->profile.counter)
+        return;
+
+    double ms = 1000.0 / core->profile.freq();
+
+    for(s32 i = 0; i < tic_profile_count; i++)
+    {
+        core->profile.frame.time[i] = core->profile.time[i] * ms;
+        core->profile.frame.calls[i] = core->profile.calls[i];
+
+        // api families are aggregated per frame, store them as counters
+        if(i >= tic_profile_api && core->profile.trace.record && core->profile.trace.count < TIC_PROFILE_TRACE_SIZE)
+            core->profile.trace.items[core->profile.trace.count++] = (tic_profile_event){core->profile.start, core->profile.time[i], i};
+    }
+
+    ZEROMEM(core->profile.time);
+    ZEROMEM(core->profile.calls);
+
+    core->profile.start = core->profile.counter();
+}
+
+const tic_profile_frame* tic_core_profile_frame(tic_mem* tic)
+{
+    tic_core* core = (tic_core*)tic;
+    return &core->profile.frame;
+}
+
+void tic_core_profile_trace(tic_mem* tic, bool record)
+{
+    tic_core* core = (tic_core*)tic;
+
+    if(record)
+    {
+        if(!core->profile.trace.items)
+            core->profile.trace.items = malloc(TIC_PROFILE_TRACE_SIZE * sizeof(tic_profile_event));
+
+        core->profile.trace.count = 0;
+    }
+
+    core->profile.trace.record = record && core->profile.trace.items;
+}
+
+char* tic_core_profile_json(tic_mem* tic, s32* size)
+{
+    tic_core* core = (tic_core*)tic;
+
+    static const char* Names[] =
+    {
+#define TIC_PROFILE_DEF(_, name) name,
+        TIC_PROFILE_LIST(TIC_PROFILE_DEF)
+#undef TIC_PROFILE_DEF
+    };
+
+    enum { EventSize = 128 };
+
+    const tic_profile_event* items = core->profile.trace.items;
+    s32 count = items ? core->profile.trace.count : 0;
+
+    char* json = malloc(count * EventSize + EventSize);
+    char* ptr = json;
+
+    if(!json)
+        return NULL;
+
+    ptr += sprintf(ptr, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    if(count)
+    {
+        double us = core->profile.freq ? 1000000.0 / core->profile.freq() : 0;
+        u64 origin = items[0].start;
+
+        for(s32 i = 0; i < count; i++)
+        {
+            const tic_profile_event* e = items + i;
+            const char* sep = i ? "," : "";
+            double ts = (double)(s64)(e->start - origin) * us;
+
+            ptr += e->zone >= tic_profile_api
+                ? sprintf(ptr, "%s\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"ms\":%.4f}}",
+                    sep, Names[e->zone], ts, e->time * us / 1000.0)
+                : sprintf(ptr, "%s\n{\"name\":\"%s\",\"cat\":\"core\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                    sep, Names[e->zone], ts, e->time * us);
+        }
+    }
+
+    ptr += sprintf(ptr, "\n]}\n");
+
+    *size = (s32)(ptr - json);
+
+    return json;
+}
+
+void tic_core_profile_close(tic_core* core)
+{
+    FREE(core->profile.trace.items);
+    core->profile.trace.items = NULL;
+}
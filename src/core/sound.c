@@ -80,11 +80,16 @@ static inline s32 param2val(const tic_track_row* row)
     return (row->param1 << 4) | row->param2;
 }
 
-static void update_amp(blip_buffer_t* blip, tic_sound_register_data* data, s32 new_amp)
+static inline void update_amp(blip_buffer_t* blip, s32 time, s32* amp, s32 new_amp)
 {
-    s32 delta = new_amp - data->amp;
-    data->amp += delta;
-    blip_add_delta(blip, data->time, delta);
+    s32 delta = new_amp - *amp;
+
+    // flat parts of the wave don't need a delta
+    if (delta)
+    {
+        *amp = new_amp;
+        blip_add_delta(blip, time, delta);
+    }
 }
 
 static inline s32 freq2period(s32 freq)
@@ -106,27 +111,42 @@ static inline s32 getAmp(s32 volume, s32 amp)
     return amp * volume / MAX_VOLUME / (TIC_SOUND_CHANNELS + 1);
 }
 
-static void runPcm(blip_buffer_t* blip, const tic_pcm* pcm, tic_sound_register_data* data)
+static void runPcm(blip_buffer_t* blip[], const tic_pcm* pcm, tic_sound_register_data* data)
 {
     enum{Period = ENDTIME / TIC_PCM_SIZE};
 
     for (data->time = 0; data->time < ENDTIME; data->time += Period, data->phase = (data->phase + 1) % TIC_PCM_SIZE)
     {
-        update_amp(blip, data, getAmp(MAX_VOLUME, pcm->data[data->phase] * SHRT_MAX / UCHAR_MAX));
+        s32 amp = getAmp(MAX_VOLUME, pcm->data[data->phase] * SHRT_MAX / UCHAR_MAX);
+
+        update_amp(blip[0], data->time, &data->amp[0], amp);
+        update_amp(blip[1], data->time, &data->amp[1], amp);
     }
 }
 
-static void runEnvelope(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, u8 stereo_volume)
+static void runEnvelope(blip_buffer_t* blip[], const tic_sound_register* reg, tic_sound_register_data* data, const u8* stereo_volume)
 {
     s32 period = freq2period(tic_sound_register_get_freq(reg) * ENVELOPE_FREQ_SCALE);
 
+    // the phase is still a noise LFSR value if the channel just switched from noise
+    data->phase %= WAVE_VALUES;
+
+    // left and right only differ in volume, so both sides share one walk over the waveform
+    s32 amps[2][MAX_VOLUME + 1];
+    for (s32 side = 0; side < COUNT_OF(amps); side++)
+        for (s32 value = 0; value <= MAX_VOLUME; value++)
+            amps[side][value] = getAmp(reg->volume, value * SHRT_MAX / MAX_VOLUME * stereo_volume[side] / MAX_VOLUME);
+
     for (; data->time < ENDTIME; data->time += period, data->phase = (data->phase + 1) % WAVE_VALUES)
     {
-        update_amp(blip, data, getAmp(reg->volume, tic_tool_peek4(reg->waveform.data, data->phase) * SHRT_MAX / MAX_VOLUME * stereo_volume / MAX_VOLUME));
+        u8 value = tic_tool_peek4(reg->waveform.data, data->phase);
+
+        update_amp(blip[0], data->time, &data->amp[0], amps[0][value]);
+        update_amp(blip[1], data->time, &data->amp[1], amps[1][value]);
     }
 }
 
-static void runNoise(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, u8 stereo_volume)
+static void runNoise(blip_buffer_t* blip[], const tic_sound_register* reg, tic_sound_register_data* data, const u8* stereo_volume)
 {
     // phase is noise LFSR, which must never be zero
     if (data->phase == 0)
@@ -135,9 +155,15 @@ static void runNoise(blip_buffer_t* blip, const tic_sound_register* reg, tic_sou
     s32 period = freq2period(tic_sound_register_get_freq(reg));
     s32 fb = *reg->waveform.data ? 0x14 : 0x12000;
 
+    s32 left = getAmp(reg->volume, stereo_volume[0] * SHRT_MAX / MAX_VOLUME);
+    s32 right = getAmp(reg->volume, stereo_volume[1] * SHRT_MAX / MAX_VOLUME);
+
     for (; data->time < ENDTIME; data->time += period, data->phase = ((data->phase & 1) * fb) ^ (data->phase >> 1))
     {
-        update_amp(blip, data, getAmp(reg->volume, (data->phase & 1) ? stereo_volume * SHRT_MAX / MAX_VOLUME : 0));
+        bool on = data->phase & 1;
+
+        update_amp(blip[0], data->time, &data->amp[0], on ? left : 0);
+        update_amp(blip[1], data->time, &data->amp[1], on ? right : 0);
     }
 }
 
@@ -516,16 +542,22 @@ static inline const struct sound_ring_buf *sound_ringbuf(tic_core* core)
     return &core->state.sound_ringbuf[(core->state.sound_ringbuf_tail + TIC_SOUND_RINGBUF_LEN - 1) % TIC_SOUND_RINGBUF_LEN];
 }
 
-static void stereo_synthesize(tic_core* core, struct sound_register_data *regdata, blip_buffer_t* blip, u8 stereoRight)
+static void synthesize(tic_core* core)
 {
+    // synthesize sound using the register values found from the tail of the ring buffer
     const struct sound_ring_buf *ringbuf = sound_ringbuf(core);
+    blip_buffer_t* blip[] = {core->blip.left, core->blip.right};
 
     for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
     {
-        u8 stereo_volume = tic_tool_peek4(&ringbuf->stereo, stereoRight + i * 2);
+        const u8 stereo_volume[] =
+        {
+            tic_tool_peek4(&ringbuf->stereo, i * 2),
+            tic_tool_peek4(&ringbuf->stereo, i * 2 + 1),
+        };
 
         const tic_sound_register* reg = &ringbuf->registers[i];
-        tic_sound_register_data* data = &regdata->data[i];
+        tic_sound_register_data* data = &core->state.registers.data[i];
 
         tic_tool_noise(&reg->waveform)
             ? runNoise(blip, reg, data, stereo_volume)
@@ -534,9 +566,18 @@ static void stereo_synthesize(tic_core* core, struct sound_register_data *regdat
         data->time -= ENDTIME;
     }
 
-    runPcm(blip, &ringbuf->pcm, &regdata->pcm);
+    runPcm(blip, &ringbuf->pcm, &core->state.registers.pcm);
+
+    blip_end_frame(core->blip.left, ENDTIME);
+    blip_end_frame(core->blip.right, ENDTIME);
 
-    blip_end_frame(blip, ENDTIME);
+    // if the head has advanced, we can advance the tail too. Otherwise, we just
+    // keep synthesizing audio using the last known register values, so at least we don't get crackles
+    if (core->state.sound_ringbuf_tail != core->state.sound_ringbuf_head) {
+        // note: head and tail are not synchronized, tick and synth have to run on the same thread,
+        // frontends hand the samples to their audio thread instead (see audiofifo.h for SDL)
+        core->state.sound_ringbuf_tail = (core->state.sound_ringbuf_tail + 1) % TIC_SOUND_RINGBUF_LEN;
+    }
 }
 
 void tic_core_synth_sound(tic_mem* memory)
@@ -544,20 +585,10 @@ void tic_core_synth_sound(tic_mem* memory)
     tic_core *core = (tic_core*)memory;
     tic80 *product = &core->memory.product;
 
-    // synthesize sound using the register values found from the tail of the ring buffer
-    stereo_synthesize(core, &core->state.registers.left, core->blip.left, 0);
-    stereo_synthesize(core, &core->state.registers.right, core->blip.right, 1);
+    synthesize(core);
 
     blip_read_samples(core->blip.left, product->samples.buffer, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
     blip_read_samples(core->blip.right, product->samples.buffer + 1, core->samplerate / TIC80_FRAMERATE, TIC80_SAMPLE_CHANNELS);
-
-    // if the head has advanced, we can advance the tail too. Otherwise, we just
-    // keep synthesizing audio using the last known register values, so at least we don't get crackles
-    if (core->state.sound_ringbuf_tail != core->state.sound_ringbuf_head) {
-        // note: we assume storing a 32 bit integer is atomic, that should hold on pretty much any modern processor
-        // assuming it is aligned in memory (which it should be)
-        core->state.sound_ringbuf_tail = (core->state.sound_ringbuf_tail + 1) % TIC_SOUND_RINGBUF_LEN;
-    }
 }
 
 void tic_core_sound_tick_start(tic_mem* memory)
@@ -591,8 +622,106 @@ void tic_core_sound_tick_end(tic_mem* memory)
     ringbuf->pcm = memory->ram->pcm;
 
     if (core->state.sound_ringbuf_head != (core->state.sound_ringbuf_tail + TIC_SOUND_RINGBUF_LEN - 2) % TIC_SOUND_RINGBUF_LEN) {
-        // note: we assume storing a 32 bit integer is atomic, that should hold on pretty much any modern processor
-        // assuming it is aligned in memory (which it should be)
         core->state.sound_ringbuf_head = (core->state.sound_ringbuf_head + 1) % TIC_SOUND_RINGBUF_LEN;
     }
 }
+
+void tic_core_render_music(tic_mem* memory, s32 track, bool sustain, u8 mute)
+{
+    tic_core* core = (tic_core*)memory;
+
+    if(track < 0 || track >= MUSIC_TRACKS)
+    {
+        core->state.render.active = false;
+        return;
+    }
+
+    tic_api_music(memory, track, -1, -1, false, sustain, -1, -1);
+    core->state.render = (struct tic_render_state){.active = true, .ticks = -1, .mute = mute};
+}
+
+void tic_core_render_sfx(tic_mem* memory, s32 index)
+{
+    tic_core* core = (tic_core*)memory;
+
+    if(index < 0 || index >= SFX_COUNT)
+    {
+        core->state.render.active = false;
+        return;
+    }
+
+    const tic_sample* effect = &memory->ram->sfx.samples.data[index];
+
+    enum{Channel = 0};
+    tic_api_sfx(memory, -1, 0, 0, -1, Channel, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+    tic_api_sfx(memory, index, effect->note, effect->octave, -1, Channel, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+
+    // the whole sample is played once, the same length as the sfx editor shows
+    s32 ticks = 0;
+    while(tic_tool_sfx_pos(effect->speed, ticks) < SFX_TICKS)
+        ticks++;
+
+    core->state.render = (struct tic_render_state){.active = true, .ticks = ticks};
+}
+
+static bool renderTick(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+    struct tic_render_state* render = &core->state.render;
+
+    if(!render->active)
+        return false;
+
+    bool music = render->ticks < 0;
+
+    if(music ? memory->ram->music_state.flag.music_status != tic_music_play : render->ticks == 0)
+    {
+        if(music)
+            tic_api_music(memory, -1, -1, -1, false, false, -1, -1);
+        else
+            tic_api_sfx(memory, -1, 0, 0, -1, 0, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+
+        render->active = false;
+        return false;
+    }
+
+    if(!music)
+        render->ticks--;
+
+    tic_core_sound_tick_start(memory);
+
+    for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+        if(render->mute & (1 << i))
+            memory->ram->registers[i].volume = 0;
+
+    tic_core_sound_tick_end(memory);
+    synthesize(core);
+
+    return true;
+}
+
+s32 tic_core_render_sound(tic_mem* memory, s16* buffer, s32 frames)
+{
+    tic_core* core = (tic_core*)memory;
+    s32 done = 0;
+
+    while(done < frames)
+    {
+        s32 count = MIN(blip_samples_avail(core->blip.left), frames - done);
+
+        if(count == 0)
+        {
+            if(renderTick(memory))
+                continue;
+
+            break;
+        }
+
+        s16* out = buffer + done * TIC80_SAMPLE_CHANNELS;
+        blip_read_samples(core->blip.left, out, count, TIC80_SAMPLE_CHANNELS);
+        blip_read_samples(core->blip.right, out + 1, count, TIC80_SAMPLE_CHANNELS);
+        done += count;
+    }
+
+    return done;
+}
@@ -1,5 +1,6 @@
 
 #include "api.h"
+#include "core/core.h"
 #ifndef TIC80_FFT_UNSUPPORTED
 // #define MA_DEBUG_OUTPUT
 #define MINIAUDIO_IMPLEMENTATION
@@ -16,10 +17,16 @@
 //////////////////////////////////////////////////////////////////////////
 
 #ifndef TIC80_FFT_UNSUPPORTED
-kiss_fftr_cfg fftcfg;
+#define FFT_PEAK_MIN_VALUE 0.01f
+#define FFT_PEAK_SMOOTHING 0.995f
+#define FFT_SMOOTHING_FACTOR 0.6f
+
 ma_context context;
 ma_device captureDevice;
-float sampleBuf[FFT_SIZE * 2];
+// the capture callback writes the samples on the device thread,
+// every instance reads them from its own tick thread under the lock
+static float sampleBuf[FFT_SIZE * 2];
+static ma_spinlock sampleLock;
 
 void miniaudioLogCallback(void* userData, ma_uint32 level, const char* message)
 {
@@ -51,6 +58,7 @@ void OnReceiveFrames(ma_device* pDevice, void* pOutput, const void* pInput, ma_u
 
     // Just rotate the buffer; copy existing, append new
     const float* samples = (const float*)pInput;
+    ma_spinlock_lock(&sampleLock);
     float* p = sampleBuf;
     for (int i = 0; i < FFT_SIZE * 2 - frameCount; i++)
     {
@@ -60,6 +68,7 @@ void OnReceiveFrames(ma_device* pDevice, void* pOutput, const void* pInput, ma_u
     {
         *(p++) = (samples[i * 2] + samples[i * 2 + 1]) / 2.0f;
     }
+    ma_spinlock_unlock(&sampleLock);
 }
 
 void print_device_id(ma_device_id id, ma_backend backend)
@@ -186,8 +195,6 @@ bool FFT_Open(bool CapturePlaybackDevices, const char* CaptureDeviceSearchString
 
     memset(sampleBuf, 0, sizeof(float) * FFT_SIZE * 2);
 
-    fftcfg = kiss_fftr_alloc(FFT_SIZE * 2, false, NULL, NULL);
-
     ma_context_config context_config = ma_context_config_init();
     ma_log log;
     ma_log_init(NULL, &log);
@@ -300,7 +307,6 @@ bool FFT_Open(bool CapturePlaybackDevices, const char* CaptureDeviceSearchString
 
     FFT_DebugLog(FFT_LOG_INFO, "Capturing %s\n", captureDevice.capture.name);
 
-    fftEnabled = true;
     return true;
 #endif
 }
@@ -314,57 +320,73 @@ void FFT_Close()
     ma_device_stop(&captureDevice);
     ma_device_uninit(&captureDevice);
     ma_context_uninit(&context);
-    kiss_fft_free(fftcfg);
-    fftEnabled = false;
 #endif
 }
 
 //////////////////////////////////////////////////////////////////////////
 
-void FFT_GetFFT(float* _samples)
+void FFT_GetFFT(tic_fft* fft)
 {
 #ifdef TIC80_FFT_UNSUPPORTED
     return;
 #else
 
+    if (!fft->cfg)
+    {
+        fft->cfg = kiss_fftr_alloc(FFT_SIZE * 2, false, NULL, NULL);
+        fft->amplification = 1.0f;
+    }
+
+    float samples[FFT_SIZE * 2];
+    ma_spinlock_lock(&sampleLock);
+    memcpy(samples, sampleBuf, sizeof samples);
+    ma_spinlock_unlock(&sampleLock);
+
     kiss_fft_cpx out[FFT_SIZE + 1];
-    kiss_fftr(fftcfg, sampleBuf, out);
+    kiss_fftr(fft->cfg, samples, out);
 
-    float peakValue = fPeakMinValue;
+    float peakValue = FFT_PEAK_MIN_VALUE;
     for (int i = 0; i < FFT_SIZE; i++)
     {
         float val = 2.0f * sqrtf(out[i].r * out[i].r + out[i].i * out[i].i);
         if (val > peakValue) peakValue = val;
-        _samples[i] = val * fAmplification;
+        fft->data[i] = val * fft->amplification;
     }
-    if (peakValue > fPeakSmoothValue)
+    if (peakValue > fft->peakSmoothValue)
     {
-        fPeakSmoothValue = peakValue;
+        fft->peakSmoothValue = peakValue;
     }
-    if (peakValue < fPeakSmoothValue)
+    if (peakValue < fft->peakSmoothValue)
     {
-        fPeakSmoothValue = fPeakSmoothValue * fPeakSmoothing + peakValue * (1 - fPeakSmoothing);
+        fft->peakSmoothValue = fft->peakSmoothValue * FFT_PEAK_SMOOTHING + peakValue * (1 - FFT_PEAK_SMOOTHING);
     }
-    fAmplification = 1.0f / fPeakSmoothValue;
+    fft->amplification = 1.0f / fft->peakSmoothValue;
 
-    float fFFTSmoothingFactor = 0.6f;
     for (int i = 0; i < FFT_SIZE; i++)
     {
-        fftSmoothingData[i] = fftSmoothingData[i] * fFFTSmoothingFactor + (1 - fFFTSmoothingFactor) * _samples[i];
+        fft->smoothing[i] = fft->smoothing[i] * FFT_SMOOTHING_FACTOR + (1 - FFT_SMOOTHING_FACTOR) * fft->data[i];
     }
 
     return;
 #endif
 }
 
+void FFT_Free(tic_fft* fft)
+{
+#ifndef TIC80_FFT_UNSUPPORTED
+    kiss_fft_free(fft->cfg);
+#endif
+    memset(fft, 0, sizeof(tic_fft));
+}
+
 //////////////////////////////////////////////////////////////////////////
 
-double fft(s32 startFreq, s32 endFreq, bool smoothing)
+static double fft(const tic_fft* state, s32 startFreq, s32 endFreq, bool smoothing)
 {
 #ifdef TIC80_FFT_UNSUPPORTED
     return 0.0;
 #else
-    if (!fftEnabled)
+    if (!state->enabled)
     {
         FFT_DebugLog(FFT_LOG_TRACE, "FFT: fft not enabled\n");
         return 0.0;
@@ -377,7 +399,7 @@ double fft(s32 startFreq, s32 endFreq, bool smoothing)
             FFT_DebugLog(FFT_LOG_TRACE, "FFT: freq out of bounds at %d\n", startFreq);
             return 0.0;
         }
-        return smoothing ? fftSmoothingData[startFreq] : fftData[startFreq];
+        return smoothing ? state->smoothing[startFreq] : state->data[startFreq];
     }
     else
     {
@@ -414,7 +436,7 @@ double fft(s32 startFreq, s32 endFreq, bool smoothing)
         double sum = 0.0;
         for (int i = startFreq; i <= endFreq; i++)
         {
-            sum += smoothing ? fftSmoothingData[i] : fftData[i];
+            sum += smoothing ? state->smoothing[i] : state->data[i];
         }
         return sum;
     }
@@ -426,7 +448,7 @@ double tic_api_fft(tic_mem* memory, s32 startFreq, s32 endFreq)
 #ifdef TIC80_FFT_UNSUPPORTED
     return 0.0;
 #else
-    return fft(startFreq, endFreq, false);
+    return fft(&((tic_core*)memory)->fft, startFreq, endFreq, false);
 #endif
 }
 
@@ -435,6 +457,6 @@ double tic_api_ffts(tic_mem* memory, s32 startFreq, s32 endFreq)
 #ifdef TIC80_FFT_UNSUPPORTED
     return 0.0;
 #else
-    return fft(startFreq, endFreq, true);
+    return fft(&((tic_core*)memory)->fft, startFreq, endFreq, true);
 #endif
 }
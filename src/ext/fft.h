@@ -1,11 +1,13 @@
 #pragma once
 #include <stdbool.h>
+#include "../fftdata.h"
 
 //////////////////////////////////////////////////////////////////////////
 
 bool FFT_Open(bool CapturePlaybackDevices, const char* CaptureDeviceSearchString);
 void FFT_EnumerateDevices();
-void FFT_GetFFT(float* _samples);
+void FFT_GetFFT(tic_fft* fft);
+void FFT_Free(tic_fft* fft);
 void FFT_Close();
 
 //////////////////////////////////////////////////////////////////////////
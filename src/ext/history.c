@@ -26,169 +26,390 @@
 #include <stdio.h>
 #include <string.h>
 
+// deltas are XOR of the old and the new state over the changed range, packed as
+// [zeros count][literals count][literals...] runs and kept in a ring arena,
+// the oldest ones are dropped when the arena reaches the budget
+
+#define MIN_ZERO_RUN 4
+#define MIN_ARENA_SIZE (16 * 1024)
+#define MAX_MARKS 8
+
 typedef struct
 {
-    u8* buffer;
+    u32 offset; // in the arena
+    u32 size;
+
     u32 start;
     u32 end;
-} Data;
+} Item;
 
-typedef struct Item Item;
+typedef struct
+{
+    u32 start;
+    u32 end;
+} Range;
 
-struct Item
+struct History
 {
-    Item* next;
-    Item* prev;
+    u32 size;
+    u8* state;
+    void* data;
+
+    struct
+    {
+        Item* items;
+        u32 count;
+        u32 capacity;
 
-    Data data;
+        // applied deltas, the rest are redo
+        u32 pos;
+    } list;
+
+    struct
+    {
+        u8* buffer;
+        u32 size;
+        u32 budget;
+    } arena;
+
+    // sorted and apart, one more for the range being added
+    struct
+    {
+        Range items[MAX_MARKS + 1];
+        u32 count;
+    } marks;
+
+    // the editor reports its changes with history_mark
+    bool marked;
 };
 
-static void list_delete(Item* list, Item* from)
+History* history_create(void* data, u32 size)
 {
-    Item* it = from;
+    History* history = (History*)calloc(1, sizeof(History));
+    history->data = data;
+    history->size = size;
+
+    history->state = malloc(size);
+    memcpy(history->state, data, history->size);
 
-    while(it)
+    history->arena.budget = HISTORY_DEFAULT_BUDGET;
+
+    return history;
+}
+
+void history_delete(History* history)
+{
+    if(history)
     {
-        Item* next = it->next;
+        free(history->state);
+        free(history->list.items);
+        free(history->arena.buffer);
+        free(history);
+    }
+}
 
-        if(it->data.buffer) free(it->data.buffer);
-        
-        free(it);
+void history_budget(History* history, u32 size)
+{
+    history->arena.budget = size;
+}
 
-        it = next;
+void history_mark(History* history, u32 start, u32 end)
+{
+    if(end > history->size) end = history->size;
+
+    history->marked = true;
+
+    if(start < end)
+    {
+        Range* items = history->marks.items;
+        u32 count = history->marks.count;
+
+        // the new range swallows the ranges it touches
+        u32 first = 0;
+        while(first < count && items[first].end < start) first++;
+
+        u32 last = first;
+        for(; last < count && items[last].start <= end; last++)
+        {
+            if(items[last].start < start) start = items[last].start;
+            if(items[last].end > end) end = items[last].end;
+        }
+
+        memmove(items + first + 1, items + last, (count - last) * sizeof(Range));
+        items[first] = (Range){start, end};
+        count += first + 1 - last;
+
+        // too many, the closest ones are joined
+        if(count > MAX_MARKS)
+        {
+            u32 closest = 0;
+            for(u32 i = 1; i < count - 1; i++)
+                if(items[i + 1].start - items[i].end < items[closest + 1].start - items[closest].end)
+                    closest = i;
+
+            items[closest].end = items[closest + 1].end;
+            memmove(items + closest + 1, items + closest + 2, (count - closest - 2) * sizeof(Range));
+            count--;
+        }
+
+        history->marks.count = count;
     }
 }
 
-static Item* list_insert(Item* list, Data* data)
+static u8* writeVarint(u8* ptr, u32 value)
 {
-    Item* item = (Item*)malloc(sizeof(Item));
-    item->next = NULL;
-    item->prev = NULL;
-    item->data = *data;
+    for(; value >= 0x80; value >>= 7)
+        *ptr++ = (u8)(value | 0x80);
 
-    if(list)
+    *ptr++ = (u8)value;
+    return ptr;
+}
+
+static const u8* readVarint(const u8* ptr, u32* value)
+{
+    *value = 0;
+
+    for(s32 shift = 0;; shift += 7)
     {
-        list_delete(list, list->next);
+        u8 byte = *ptr++;
+        *value |= (u32)(byte & 0x7f) << shift;
 
-        list->next = item;
-        item->prev = list;
+        if(!(byte & 0x80)) break;
     }
 
-    return item;
+    return ptr;
 }
 
-static Item* list_first(Item* list)
+static u32 varintSize(u32 value)
 {
-    Item* it = list;
-    while(it->prev) it = it->prev;
+    u32 size = 1;
+    for(; value >= 0x80; value >>= 7) size++;
 
-    return it;
+    return size;
 }
 
-struct History
+// packs the XOR delta of the range, returns the packed size, only counts it if out is NULL,
+// the zeros are counted from the end of the previous run, so the ranges of a delta follow each other
+static u32 packDelta(const u8* state, const u8* data, u32* pos, u32 start, u32 end, u8* out)
 {
-    Item* list;
+    u32 size = 0;
 
-    u32 size;
-    u8* state;
+    for(u32 i = start; i < end;)
+    {
+        while(i < end && state[i] == data[i]) i++;
+        u32 zeros = i - *pos;
 
-    void* data;
-};
+        // literals go on until a run of zeros long enough to be worth a new header
+        u32 from = i, last = i;
+        for(u32 run = 0; i < end && run < MIN_ZERO_RUN; i++)
+            if(state[i] == data[i]) run++;
+            else run = 0, last = i + 1;
 
-History* history_create(void* data, u32 size)
-{
-    History* history = (History*)malloc(sizeof(History));
-    history->data = data;
+        i = last;
+        u32 count = last - from;
 
-    history->list = NULL;
-    history->size = size;
+        if(out)
+        {
+            u8* ptr = writeVarint(writeVarint(out + size, zeros), count);
 
-    history->state = malloc(size);
-    memcpy(history->state, data, history->size);
+            for(u32 k = from; k < last; k++)
+                *ptr++ = state[k] ^ data[k];
+        }
 
-    // empty diff
-    history->list = list_insert(history->list, &(Data){NULL, 0, 0});
+        size += varintSize(zeros) + varintSize(count) + count;
+        *pos = last;
+    }
 
-    return history;
+    return size;
 }
 
-void history_delete(History* history)
+static u32 packRanges(History* history, const Range* ranges, u32 count, u8* out)
 {
-    if(history)
+    u32 size = 0, pos = ranges[0].start;
+
+    for(const Range* it = ranges, *end = it + count; it != end; ++it)
+        size += packDelta(history->state, history->data, &pos, it->start, it->end, out ? out + size : NULL);
+
+    return size;
+}
+
+static void applyDelta(History* history, const Item* item)
+{
+    const u8* ptr = history->arena.buffer + item->offset;
+    u8* state = history->state;
+
+    for(u32 i = item->start; i < item->end;)
     {
-        free(history->state);
+        u32 zeros, count;
+        ptr = readVarint(readVarint(ptr, &zeros), &count);
 
-        list_delete(history->list, list_first(history->list));
+        i += zeros;
 
-        free(history);
+        for(const u8* end = ptr + count; ptr != end; ptr++)
+            state[i++] ^= *ptr;
     }
 }
 
-static void history_diff(History* history, Data* data)
+static void dropOldest(History* history)
 {
-    for (u32 i = data->start, k = 0; i < data->end; ++i, ++k)
-        history->state[i] ^= data->buffer[k];
+    memmove(history->list.items, history->list.items + 1, --history->list.count * sizeof(Item));
+    history->list.pos--;
 }
 
-static u32 trim_left(u8* data, u32 size)
+static bool growArena(History* history, u32 size)
 {
-    for(u32 i = 0; i < size; i++)
-        if(data[i]) return i;
+    u32 capacity = history->arena.size ? history->arena.size * 2 : MIN_ARENA_SIZE;
 
-    return size;
+    if(capacity < size) capacity = size;
+    if(capacity > history->arena.budget) capacity = history->arena.budget;
+
+    u8* buffer = capacity > history->arena.size ? realloc(history->arena.buffer, capacity) : NULL;
+
+    if(buffer)
+    {
+        history->arena.buffer = buffer;
+        history->arena.size = capacity;
+    }
+
+    return buffer != NULL;
 }
 
-static u32 trim_right(u8* data, u32 size)
+// finds room for a delta after the newest one, grows the arena until the budget
+// and then drops the oldest deltas, returns the offset or -1 if it doesn't fit at all
+static s64 allocDelta(History* history, u32 size)
 {
-    for(u32 i = 0; i < size; i++)
-        if(data[size - i - 1]) return size - i;
+    if(size > history->arena.budget)
+        return -1;
+
+    while(true)
+    {
+        const Item* items = history->list.items;
+        u32 count = history->list.count;
+        u32 capacity = history->arena.size;
+
+        if(count == 0)
+        {
+            if(size <= capacity) return 0;
+            if(!growArena(history, size)) return -1;
+            continue;
+        }
 
-    return 0;
+        u32 first = items[0].offset;
+        u32 head = items[count - 1].offset + items[count - 1].size;
+
+        if(items[count - 1].offset >= first)
+        {
+            if(capacity - head >= size) return head;
+
+            // the arena can grow only while the deltas don't wrap around
+            if(capacity < history->arena.budget && growArena(history, head + size))
+                continue;
+
+            if(first >= size) return 0;
+        }
+        else if(first - head >= size) return head;
+
+        dropOldest(history);
+    }
 }
 
 bool history_add(History* history)
 {
-    if (memcmp(history->state, history->data, history->size) == 0) return false;
+    Range ranges[MAX_MARKS];
+    u32 count = 0;
+
+    const u8* data = history->data;
+    u8* state = history->state;
 
-    history_diff(history, &(Data){history->data, 0, history->size});
+    if(history->marks.count == 0)
+        history->marks.items[history->marks.count++] = (Range){0, history->size};
 
+    for(u32 i = 0; i < history->marks.count; i++)
     {
-        Data data;
-        data.start = trim_left(history->state, history->size);
-        data.end = trim_right(history->state, history->size);
-        u32 size = data.end - data.start;
-        data.buffer = malloc(size);
+        u32 start = history->marks.items[i].start;
+        u32 end = history->marks.items[i].end;
 
-        memcpy(data.buffer, (u8*)history->state + data.start, size);
+        while(start < end && state[start] == data[start]) start++;
+        while(end > start && state[end - 1] == data[end - 1]) end--;
 
-        history->list = list_insert(history->list, &data);
+        if(start < end)
+            ranges[count++] = (Range){start, end};
     }
 
-    memcpy(history->state, history->data, history->size);
+    history->marks.count = 0;
+
+    if(count == 0) return false;
+
+    // new change drops the redo deltas
+    history->list.count = history->list.pos;
+
+    u32 size = packRanges(history, ranges, count, NULL);
+    s64 offset = allocDelta(history, size);
+
+    if(offset >= 0)
+    {
+        if(history->list.count == history->list.capacity)
+        {
+            history->list.capacity = history->list.capacity ? history->list.capacity * 2 : 64;
+            history->list.items = realloc(history->list.items, history->list.capacity * sizeof(Item));
+        }
+
+        packRanges(history, ranges, count, history->arena.buffer + offset);
+        history->list.items[history->list.count++] = (Item){(u32)offset, size, ranges[0].start, ranges[count - 1].end};
+    }
+    else
+    {
+        // the delta is over the budget, the history starts over from here
+        history->list.count = 0;
+    }
+
+    history->list.pos = history->list.count;
+
+    for(u32 i = 0; i < count; i++)
+        memcpy(state + ranges[i].start, data + ranges[i].start, ranges[i].end - ranges[i].start);
 
     return true;
 }
 
-void history_undo(History* history)
+// copies the state back over the data, an editor marking its changes gets back only the applied
+// delta range and its pending marks, the other editors get back the whole buffer
+static void restoreData(History* history, const Item* item)
 {
-    if(history->list->prev)
-    {
-        history_diff(history, &history->list->data);
+    u8* data = history->data;
+    const u8* state = history->state;
 
-        history->list = history->list->prev;
+    if(history->marked)
+    {
+        if(item)
+            memcpy(data + item->start, state + item->start, item->end - item->start);
+
+        for(u32 i = 0; i < history->marks.count; i++)
+        {
+            const Range* range = &history->marks.items[i];
+            memcpy(data + range->start, state + range->start, range->end - range->start);
+        }
     }
+    else memcpy(data, state, history->size);
 
-    memcpy(history->data, history->state, history->size);
+    history->marks.count = 0;
+}
+
+void history_undo(History* history)
+{
+    const Item* item = NULL;
+
+    if(history->list.pos)
+        applyDelta(history, item = &history->list.items[--history->list.pos]);
+
+    restoreData(history, item);
 }
 
 void history_redo(History* history)
 {
-    if(history->list->next)
-    {
-        history->list = history->list->next;
+    const Item* item = NULL;
 
-        history_diff(history, &history->list->data);
-    }
+    if(history->list.pos < history->list.count)
+        applyDelta(history, item = &history->list.items[history->list.pos++]);
 
-    memcpy(history->data, history->state, history->size);
+    restoreData(history, item);
 }
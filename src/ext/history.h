@@ -26,7 +26,16 @@
 
 typedef struct History History;
 
+#define HISTORY_DEFAULT_BUDGET (8 * 1024 * 1024)
+
 History* history_create(void* data, u32 size);
+// byte range changed since the last history_add, without it history_add compares
+// the whole buffer, so an editor reporting ranges has to report all its changes,
+// a few distant ranges are kept apart, so the bytes between them aren't compared,
+// undo and redo then restore only the ranges they change and the pending marks
+void history_mark(History* history, u32 start, u32 end);
+// memory limit for the undo deltas, the oldest ones are dropped above it
+void history_budget(History* history, u32 size);
 bool history_add(History* history);
 void history_undo(History* history);
 void history_redo(History* history);
@@ -1,16 +1,21 @@
 #pragma once
 #include <stdbool.h>
 #define FFT_SIZE 1024
-extern float fPeakMinValue;
-extern float fPeakSmoothing;
-extern float fPeakSmoothValue;
-extern float fAmplification;
-extern float fftData[FFT_SIZE];
-extern float fftSmoothingData[FFT_SIZE];
-extern float fftNormalizedData[FFT_SIZE];
-extern float fftNormalizedMaxData[FFT_SIZE];
 
-extern bool fftEnabled;
+// the capture device is shared, the spectrum and its smoothing are per core
+typedef struct
+{
+    float data[FFT_SIZE];
+    float smoothing[FFT_SIZE];
+    float peakSmoothValue;
+    float amplification;
+
+    // kiss_fftr config, it has a scratch buffer so it can't be shared between threads
+    void* cfg;
+
+    // set by the host once the capture device is open, see tic_core_fft()
+    bool enabled;
+} tic_fft;
 
 typedef enum
 {
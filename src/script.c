@@ -173,10 +173,12 @@ const tic_script** tic_scripts()
 
 const tic_script* tic_get_script(tic_mem* memory)
 {
+    char tag[TIC_METATAG_SIZE];
+
     FOREACH_LANG(script)
     {
         if(script->id == memory->cart.lang
-            || strcmp(tic_tool_metatag(memory->cart.code.data, "script", script->singleComment), script->name) == 0)
+            || strcmp(tic_tool_metatag(memory->cart.code.data, "script", script->singleComment, tag, sizeof tag), script->name) == 0)
             return script;
     }
 
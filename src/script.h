@@ -38,6 +38,10 @@ struct tic_script
         tic_tick tick;
         tic_boot boot;
         tic_blit_callback callback;
+
+        // optional, for VMs that don't poll tic_core_interrupted() and have to be poked
+        // to stop, called by tic_core_interrupt(), possibly from another thread
+        void(*interrupt)(tic_mem* memory);
     };
 
     const tic_outline_item* (*getOutline)(const char* code, s32* size);
@@ -24,6 +24,7 @@
 #include "fs.h"
 #include "cart.h"
 #include "ext/json.h"
+#include "ext/history.h"
 
 #if defined(__EMSCRIPTEN__)
 #define DEFAULT_VSYNC 0
@@ -47,10 +48,17 @@ static void readConfig(Config* config)
         config->data.uiScale = json_int("UI_SCALE", 0);
         config->data.soft = json_bool("SOFTWARE_RENDERING", 0);
         config->data.trim = json_bool("TRIM_ON_SAVE", 0);
+        config->data.undoBudget = json_int("UNDO_BUDGET", 0);
+        config->data.frameTimeout = MAX(json_int("FRAME_TIMEOUT", 0), 0);
 
         if(config->data.uiScale <= 0)
             config->data.uiScale = 1;
 
+        if(config->data.undoBudget <= 0)
+            config->data.undoBudget = HISTORY_DEFAULT_BUDGET / (1024 * 1024);
+
+        config->data.undoBudget = MIN(config->data.undoBudget, 1024);
+
         config->data.theme.gamepad.touch.alpha = json_int("GAMEPAD_TOUCH_ALPHA", 0);
 
         s32 theme = json_object("CODE_THEME", 0);
@@ -53,14 +53,151 @@ enum
 #undef  CODE_COLOR_DEF
 };
 
+// the text and its states are gap buffers of TIC_CODE_SIZE cells with the gap where
+// the last edit was, so typing only fills the gap and the text after it stays in place,
+// the last cell is the null terminator and the gap cells are cleared
+static inline s32 getGapSize(Code* code)
+{
+    return TIC_CODE_SIZE - 1 - code->text.size;
+}
+
+// maps a text position to its cell in the buffers
+static inline s32 getOffset(Code* code, s32 pos)
+{
+    return pos < code->text.gap ? pos : pos + getGapSize(code);
+}
+
+static inline char getChar(Code* code, s32 pos)
+{
+    return pos >= 0 && pos < code->text.size ? code->text.data[getOffset(code, pos)] : '\0';
+}
+
+static inline CodeState* getState(Code* code, s32 pos)
+{
+    return code->state + getOffset(code, pos);
+}
+
 static void packState(Code* code)
 {
-    const char* src = code->src;
+    const char* src = code->text.data;
+    const CodeState* cursor = getState(code, code->cursor.position);
+
     for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
     {
-        s->cursor = src == code->cursor.position;
+        s->cursor = s == cursor;
         s->sym = *src++;
     }
+
+    code->historyCursor = code->cursor.position;
+    code->historyEdited = false;
+}
+
+// reports changed states to the history, so it doesn't compare the whole buffer
+static void markState(Code* code, s32 start, s32 end)
+{
+    history_mark(code->history, start * sizeof(CodeState), end * sizeof(CodeState));
+}
+
+// marks the states of the text range on both sides of the gap, the gap itself doesn't change
+static void markText(Code* code, s32 start, s32 end)
+{
+    s32 gap = code->text.gap;
+
+    if(start < gap)
+        markState(code, start, MIN(end, gap));
+
+    if(end > gap)
+        markState(code, getOffset(code, MAX(start, gap)), getOffset(code, end));
+}
+
+// moves the text between the gap and the position to the other side of the gap
+static void moveGap(Code* code, s32 pos)
+{
+    s32 gap = code->text.gap;
+    s32 size = getGapSize(code);
+
+    if(pos != gap && size)
+    {
+        char* data = code->text.data;
+        CodeState* state = code->state;
+
+        s32 start = MIN(pos, gap);
+        s32 count = MAX(pos, gap) - start;
+
+        // the cells left behind join the gap
+        s32 clear = MIN(count, size);
+        s32 cleared = pos < gap ? start : start + count + size - clear;
+
+        if(pos < gap)
+        {
+            memmove(data + start + size, data + start, count);
+            memmove(state + start + size, state + start, count * sizeof(CodeState));
+        }
+        else
+        {
+            memmove(data + start, data + start + size, count);
+            memmove(state + start, state + start + size, count * sizeof(CodeState));
+        }
+
+        memset(data + cleared, 0, clear);
+        memset(state + cleared, 0, clear * sizeof(CodeState));
+
+        // the moved cells on both sides, the cells between them stay in the gap
+        markState(code, start, start + count);
+        markState(code, start + size, start + size + count);
+    }
+
+    code->text.gap = pos;
+}
+
+// moves the gap to the end, the text is a null terminated string until the next edit
+static char* getText(Code* code)
+{
+    moveGap(code, code->text.size);
+    return code->text.data;
+}
+
+// copies the text range to the buffer and terminates it, the gap can be inside the range
+static void copyText(Code* code, char* dst, s32 start, s32 end)
+{
+    s32 gap = CLAMP(code->text.gap, start, end);
+
+    memcpy(dst, code->text.data + start, gap - start);
+    memcpy(dst + gap - start, code->text.data + getOffset(code, gap), end - gap);
+    dst[end - start] = '\0';
+}
+
+// changes the symbol in place, outside of the edit primitives
+static void setChar(Code* code, s32 pos, char sym)
+{
+    s32 offset = getOffset(code, pos);
+
+    code->text.data[offset] = code->state[offset].sym = sym;
+    markState(code, offset, offset + 1);
+    code->historyEdited = true;
+}
+
+// the edit primitives keep the symbols packed, only the cursor bit has to move, returns true if it moved
+static bool packCursor(Code* code)
+{
+    s32 cursor = code->cursor.position;
+    bool moved = cursor != code->historyCursor;
+
+    if(moved)
+    {
+        if(code->historyCursor >= 0)
+        {
+            getState(code, code->historyCursor)->cursor = 0;
+            markText(code, code->historyCursor, code->historyCursor + 1);
+        }
+
+        getState(code, cursor)->cursor = 1;
+        markText(code, cursor, cursor + 1);
+
+        code->historyCursor = cursor;
+    }
+
+    return moved;
 }
 
 //if pos_undo is true, we set the position to the first character
@@ -70,33 +207,51 @@ static void packState(Code* code)
 //(this occurs when there are no undo's or redo's left to apply)
 static void unpackState(Code* code, bool pos_undo)
 {
-    char* src = code->src;
+    const CodeState* state = code->state;
 
-    char* first_change = NULL;
-    char* stored_pos = NULL;
+    // the text after the gap ends with the terminator in the last cell and the gap is cleared
+    s32 tail = TIC_CODE_SIZE - 1;
+    while(tail > 0 && state[tail - 1].sym) tail--;
 
-    for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
-    {
+    s32 gap = 0;
+    while(gap < tail && state[gap].sym) gap++;
 
-        if (first_change == NULL && *src != s->sym)
-            first_change = src;
+    s32 size = gap + TIC_CODE_SIZE - 1 - tail;
 
-        if(s->cursor)
-            stored_pos = src;
+    s32 first_change = 0;
+    while(first_change < MIN(size, code->text.size)
+        && getChar(code, first_change) == state[first_change < gap ? first_change : first_change + tail - gap].sym)
+        first_change++;
 
-        *src++ = s->sym;
+    bool changed = first_change < MAX(size, code->text.size);
+
+    s32 stored_pos = -1;
+    for(s32 i = 0; i < TIC_CODE_SIZE; i++)
+    {
+        if(state[i].cursor)
+            stored_pos = i < gap ? i : i - (tail - gap);
+
+        code->text.data[i] = state[i].sym;
     }
 
-    if (first_change != NULL) {
+    code->text.gap = gap;
+    code->text.size = size;
+    code->historyCursor = stored_pos;
+    code->historyEdited = false;
+
+    if (changed) {
 
         //we actually will want to go the one before the first change, as if
         //we were about to make the change
         //ternary to make sure we don't go one before the beginning
-        if (pos_undo)
-            code->cursor.position = first_change == code->src ? code->src : (first_change - 1);
+        if (pos_undo || stored_pos < 0)
+            code->cursor.position = first_change == 0 ? 0 : (first_change - 1);
 
         else code->cursor.position = stored_pos;
     }
+
+    code->cursor.position = MIN(code->cursor.position, size);
+    code->cursor.selection = MIN(code->cursor.selection, size);
 }
 
 static void history(Code* code)
@@ -105,8 +260,12 @@ static void history(Code* code)
     //in the undo/redo history only when we leave it
     if (checkStudioViMode(code->studio, VI_INSERT))
         return;
-    packState(code);
-    history_add(code->history);
+    // the lexer moves the gap without editing, that alone isn't worth an undo step
+    if(packCursor(code) || code->historyEdited)
+    {
+        history_add(code->history);
+        code->historyEdited = false;
+    }
 }
 
 tic_color getCodeColor(Code* code)
@@ -115,7 +274,7 @@ tic_color getCodeColor(Code* code)
 
     if(bb)
     {
-        s32 size = strlen(code->src) - bb->limit.lower;
+        s32 size = code->text.size - bb->limit.lower;
 
         if(size <= 0) return tic_color_light_green;
 
@@ -140,7 +299,7 @@ static void drawStatus(Code* code)
         tic_api_rect(code->tic, 0, TIC80_HEIGHT - Height, TIC80_WIDTH, Height, getCodeColor(code));
         if(!bb->battle.hidetime)
         {
-            sprintf(code->status.size, "%i/%i", (u32)strlen(code->src), bb->limit.current);
+            sprintf(code->status.size, "%i/%i", code->text.size, bb->limit.current);
 
             char buf[sizeof "00:00"];
             s32 sec = bb->battle.left / 1000;
@@ -160,47 +319,131 @@ static void drawStatus(Code* code)
         StatusY, getConfig(code->studio)->theme.code.BG, true, 1, false);
 }
 
-static char* getPosByLine(char* ptr, s32 line)
+// the line index keeps the lines after the gap counted back from the text end,
+// so an edit only moves the gap to its position and doesn't shift the rest
+static inline s32* getLinesBack(Code* code)
+{
+    return code->text.index.items + TIC_CODE_SIZE - (code->text.lines - code->text.index.gap);
+}
+
+static s32 getLineStart(Code* code, s32 line)
 {
-    s32 y = 0;
-    while(*ptr)
+    if(line <= 0)
+        return 0;
+
+    s32 index = line - 1;
+    const s32 gap = code->text.index.gap;
+
+    return index < gap
+        ? code->text.index.items[index]
+        : code->text.size - getLinesBack(code)[index - gap];
+}
+
+static s32 getLineIndex(Code* code, s32 pos)
+{
+    s32 low = 0, high = code->text.lines;
+
+    while(low < high)
     {
-        if(y == line) break;
-        if(*ptr++ == '\n') y++;
+        s32 mid = (low + high + 1) / 2;
+
+        if(getLineStart(code, mid) <= pos)
+            low = mid;
+        else high = mid - 1;
     }
 
-    return ptr;
+    return low;
 }
 
-static char* getNextLineByPos(Code* code, char* pos)
+// moves the gap so that the lines starting at or before the offset are in front of it
+static void moveLinesGap(Code* code, s32 offset)
 {
-    while(*pos && *pos++ != '\n');
-    return pos;
+    s32* items = code->text.index.items;
+    s32* gap = &code->text.index.gap;
+
+    while(*gap > 0 && items[*gap - 1] > offset)
+    {
+        (*gap)--;
+        getLinesBack(code)[0] = code->text.size - items[*gap];
+    }
+
+    while(*gap < code->text.lines && code->text.size - getLinesBack(code)[0] <= offset)
+    {
+        items[*gap] = code->text.size - getLinesBack(code)[0];
+        (*gap)++;
+    }
+}
+
+static void indexLines(Code* code)
+{
+    code->text.lines = 0;
+
+    for(s32 pos = 0; pos < code->text.size; pos++)
+        if(getChar(code, pos) == '\n')
+            code->text.index.items[code->text.lines++] = pos + 1;
+
+    code->text.index.gap = code->text.lines;
+}
+
+static void deleteLines(Code* code, s32 offset, s32 size)
+{
+    moveLinesGap(code, offset);
+
+    // drop the lines starting inside the deleted text, the rest keep their distance to the end
+    while(code->text.index.gap < code->text.lines
+        && code->text.size - getLinesBack(code)[0] <= offset + size)
+        code->text.lines--;
+
+    code->text.size -= size;
 }
 
-static inline CodeState* getState(Code* code, const char* pos)
+static void insertLines(Code* code, s32 offset, const char* text, s32 size)
 {
-    return code->state + (pos - code->src);
+    moveLinesGap(code, offset);
+
+    code->text.size += size;
+
+    for(s32 i = 0; i < size; i++)
+        if(text[i] == '\n')
+        {
+            code->text.index.items[code->text.index.gap++] = offset + i + 1;
+            code->text.lines++;
+        }
 }
 
-static void toggleBookmark(Code* code, char* codePos)
+static s32 getPosByLine(Code* code, s32 line)
 {
-    CodeState* start = getState(code, codePos);
-    const CodeState* end = getState(code, getNextLineByPos(code, codePos));
+    return line > code->text.lines ? code->text.size : getLineStart(code, line);
+}
+
+static s32 getNextLineByPos(Code* code, s32 pos)
+{
+    while(pos < code->text.size && getChar(code, pos++) != '\n');
+    return pos;
+}
+
+static void parseSyntaxColor(Code*);
+static inline const CodeState* getSyntax(Code*, s32);
+
+static void toggleBookmark(Code* code, s32 start)
+{
+    // the empty last line keeps its bookmark on the terminator
+    s32 end = MAX(getNextLineByPos(code, start), start + 1);
 
     bool bookmarked = false;
-    CodeState* ptr = start;
-    while(ptr < end)
-        if(ptr++->bookmark)
+    for(s32 pos = start; pos < end; pos++)
+        if(getState(code, pos)->bookmark)
             bookmarked = true;
 
     if(bookmarked)
     {
-        CodeState* ptr = start;
-        while(ptr < end)
-            ptr++->bookmark = 0;
+        for(s32 pos = start; pos < end; pos++)
+            getState(code, pos)->bookmark = 0;
     }
-    else start->bookmark = 1;
+    else getState(code, start)->bookmark = 1;
+
+    markText(code, start, end);
+    code->historyEdited = true;
 
     history(code);
 }
@@ -225,22 +468,21 @@ static void drawBookmarks(Code* code)
         drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + line * STUDIO_TEXT_HEIGHT - 1, tic_color_dark_grey);
 
         if(checkMouseClick(code->studio, &rect, tic_mouse_left))
-            toggleBookmark(code, getPosByLine(code->src, line + code->scroll.y));
+            toggleBookmark(code, getPosByLine(code, line + code->scroll.y));
     }
 
-    const char* pointer = code->src;
-    const CodeState* syntaxPointer = code->state;
-    s32 y = -code->scroll.y;
-
-    while(*pointer)
+    // only the visible lines, the rest is under the toolbar and the status bar
+    for(s32 y = 0, line = code->scroll.y; y <= TEXT_BUFFER_HEIGHT && line <= code->text.lines; y++, line++)
     {
-        if(syntaxPointer++->bookmark)
+        for(s32 pos = getPosByLine(code, line), end = getPosByLine(code, line + 1); pos < end; pos++)
         {
-            drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT, tic_color_black);
-            drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT - 1, tic_color_yellow);
+            if(getState(code, pos)->bookmark)
+            {
+                drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT, tic_color_black);
+                drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT - 1, tic_color_yellow);
+                break;
+            }
         }
-
-        if(*pointer++ == '\n')y++;
     }
 }
 
@@ -305,15 +547,16 @@ static void drawCode(Code* code, bool withCursor)
 
     s32 xStart = rect.x - code->scroll.x * getFontWidth(code);
     s32 x = xStart;
-    s32 y = rect.y - code->scroll.y * STUDIO_TEXT_HEIGHT;
-    const char* pointer = code->src;
+    s32 y = rect.y;
+    s32 pos = getPosByLine(code, code->scroll.y);
 
     u8 selectColor = getConfig(code->studio)->theme.code.select;
 
     const u8* colors = (const u8*)&getConfig(code->studio)->theme.code;
-    const CodeState* syntaxPointer = code->state;
 
-    struct { char* start; char* end; } selection =
+    parseSyntaxColor(code);
+
+    struct { s32 start; s32 end; } selection =
     {
         MIN(code->cursor.selection, code->cursor.position),
         MAX(code->cursor.selection, code->cursor.position)
@@ -322,14 +565,15 @@ static void drawCode(Code* code, bool withCursor)
     struct { s32 x; s32 y; char symbol; } cursor = {-1, -1, 0};
     struct { s32 x; s32 y; char symbol; u8 color; } matchedDelim = {-1, -1, 0, 0};
 
-    while(*pointer)
+    while(pos < code->text.size && y < TIC80_HEIGHT)
     {
-        char symbol = *pointer;
+        char symbol = getChar(code, pos);
+        const CodeState* syntaxPointer = getState(code, pos);
         s32 x_offset = getFontWidth(code);
 
         if(x >= -getFontWidth(code) && x < TIC80_WIDTH && y >= -TIC_FONT_HEIGHT && y < TIC80_HEIGHT )
         {
-            if(code->cursor.selection && pointer >= selection.start && pointer < selection.end)
+            if(code->cursor.selection >= 0 && pos >= selection.start && pos < selection.end)
             {
                 if(code->shadowText)
                     tic_api_rect(code->tic, x, y, getFontWidth(code)+1, TIC_FONT_HEIGHT+1, tic_color_black);
@@ -357,10 +601,10 @@ static void drawCode(Code* code, bool withCursor)
             }
         }
 
-        if(code->cursor.position == pointer)
+        if(code->cursor.position == pos)
             cursor.x = x, cursor.y = y, cursor.symbol = symbol;
 
-        if(code->matchedDelim == pointer)
+        if(code->matchedDelim == pos)
         {
             matchedDelim.x = x, matchedDelim.y = y, matchedDelim.symbol = symbol,
                 matchedDelim.color = colors[syntaxPointer->syntax];
@@ -373,13 +617,12 @@ static void drawCode(Code* code, bool withCursor)
         }
         else x += x_offset;
 
-        pointer++;
-        syntaxPointer++;
+        pos++;
     }
 
     drawBookmarks(code);
 
-    if(code->cursor.position == pointer)
+    if(code->cursor.position == pos)
         cursor.x = x, cursor.y = y;
 
     if(withCursor && cursor.x >= BOOKMARK_WIDTH && cursor.y >= 0)
@@ -393,24 +636,8 @@ static void drawCode(Code* code, bool withCursor)
 
 static void getCursorPosition(Code* code, s32* x, s32* y)
 {
-    *x = 0;
-    *y = 0;
-
-    const char* pointer = code->src;
-
-    while(*pointer)
-    {
-        if(code->cursor.position == pointer) return;
-
-        if(*pointer == '\n')
-        {
-            *x = 0;
-            (*y)++;
-        }
-        else (*x)++;
-
-        pointer++;
-    }
+    *y = getLineIndex(code, code->cursor.position);
+    *x = code->cursor.position - getPosByLine(code, *y);
 }
 
 void codeGetPos(Code* code, s32* x, s32* y)
@@ -419,7 +646,6 @@ void codeGetPos(Code* code, s32* x, s32* y)
 }
 
 static void setCursorPosition(Code* code, s32 x, s32 y);
-static void parseSyntaxColor(Code*);
 
 void codeSetPos(Code* code, s32 x, s32 y)
 {
@@ -428,16 +654,9 @@ void codeSetPos(Code* code, s32 x, s32 y)
     code->cursor.delay = 0;
 }
 
-static s32 getLinesCount(Code* code)
+static inline s32 getLinesCount(Code* code)
 {
-    char* text = code->src;
-    s32 count = 0;
-
-    while(*text)
-        if(*text++ == '\n')
-            count++;
-
-    return count;
+    return code->text.lines;
 }
 
 static void removeInvalidChars(char* code)
@@ -462,31 +681,30 @@ const char matchingDelim(const char current)
     return match;
 }
 
-const char* findMatchedDelim(Code* code, const char* current)
+s32 findMatchedDelim(Code* code, s32 current)
 {
-    const char* start = code->src;
     // delimiters inside comments and strings don't get to be matched!
-    if(code->state[current - start].syntax == SyntaxType_COMMENT ||
-       code->state[current - start].syntax == SyntaxType_STRING) return 0;
+    if(getSyntax(code, current)->syntax == SyntaxType_COMMENT ||
+       getSyntax(code, current)->syntax == SyntaxType_STRING) return -1;
 
-    char initial = *current;
+    char initial = getChar(code, current);
     char seeking = matchingDelim(initial);
-    if(seeking == 0) return NULL;
+    if(seeking == 0) return -1;
 
     s8 dir = (initial == '(' || initial == '[' || initial == '{') ? 1 : -1;
 
-    while(*current && (start < current))
+    while(getChar(code, current) && (0 < current))
     {
         current += dir;
         // skip over anything inside a comment or string
-        if(code->state[current - start].syntax == SyntaxType_COMMENT ||
-           code->state[current - start].syntax == SyntaxType_STRING) continue;
-        if(*current == seeking) return current;
-        if(*current == initial) current = findMatchedDelim(code, current);
-        if(!current) break;
+        if(getSyntax(code, current)->syntax == SyntaxType_COMMENT ||
+           getSyntax(code, current)->syntax == SyntaxType_STRING) continue;
+        if(getChar(code, current) == seeking) return current;
+        if(getChar(code, current) == initial) current = findMatchedDelim(code, current);
+        if(current < 0) break;
     }
 
-    return NULL;
+    return -1;
 }
 
 static void updateEditor(Code* code)
@@ -511,7 +729,7 @@ static void updateEditor(Code* code)
 
     sprintf(code->status.line, "line %i/%i col %i", line + 1, getLinesCount(code) + 1, column + 1);
     {
-        s32 codeLen = strlen(code->src);
+        s32 codeLen = code->text.size;
         sprintf(code->status.size, "size %i/%i", codeLen, MAX_CODE);
         code->status.color = codeLen > MAX_CODE ? tic_color_red : tic_color_white;
     }
@@ -545,281 +763,338 @@ static void setCodeState(CodeState* state, u8 color, s32 start, s32 size)
         s->syntax = color;
 }
 
-static void parseCode(const tic_script* config, const char* start, CodeState* state)
+enum
+{
+    LexCode,
+    LexBlockComment,
+    LexBlockComment2,
+    LexBlockString,
+    LexString, // + index of the quote in the string delimiters
+};
+
+static inline const char* getStringQuotes(const tic_script* config)
+{
+    return config->stdStringStartEnd ? config->stdStringStartEnd : "\"'";
+}
+
+static inline bool isToken(const char* ptr, const char* token)
 {
-    const char* ptr = start;
+    // stops at the text end, the last line can end the buffer
+    return token && strncmp(ptr, token, strlen(token)) == 0;
+}
 
-    const char* blockCommentStart = NULL;
-    const char* blockCommentStart2 = NULL;
-    const char* blockStringStart = NULL;
-    const char* blockStdStringStart = NULL;
-    const char* singleCommentStart = NULL;
-    const char* wordStart = NULL;
-    const char* numberStart = NULL;
+// returns the position after the token or NULL if the line doesn't have it
+static const char* findToken(const char* ptr, const char* end, const char* token)
+{
+    s32 size = (s32)strlen(token);
 
-start:
-    while(true)
-    {
-        char c = ptr[0];
+    for(end -= size; ptr <= end; ptr++)
+        if(memcmp(ptr, token, size) == 0)
+            return ptr + size;
 
-        if(blockCommentStart)
-        {
-            const char* end = strstr(ptr, config->blockCommentEnd);
+    return NULL;
+}
 
-            ptr = end ? end + strlen(config->blockCommentEnd) : blockCommentStart + strlen(blockCommentStart);
-            setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart - start), (s32)(ptr - blockCommentStart));
-            blockCommentStart = NULL;
+static const char* findQuoteEnd(const char* ptr, const char* end, char quote)
+{
+    for(; ptr < end; ptr++)
+        if(*ptr == quote && !(ptr[-1] == '\\' && ptr[-2] != '\\'))
+            return ptr + 1;
 
-            // !TODO: stupid MS compiler doesn't see 'continue' here in release, so lets use 'goto' instead, investigate why
-            goto start;
-        }
-        else if(blockCommentStart2)
-        {
-            const char* end = strstr(ptr, config->blockCommentEnd2);
+    return NULL;
+}
 
-            ptr = end ? end + strlen(config->blockCommentEnd2) : blockCommentStart2 + strlen(blockCommentStart2);
-            setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart2 - start), (s32)(ptr - blockCommentStart2));
-            blockCommentStart2 = NULL;
-            goto start;
-        }
-        else if(blockStringStart)
+static void parseWord(const tic_script* config, const char* word, s32 len, CodeState* state)
+{
+    for(s32 i = 0; i < config->keywordsCount; i++)
+        if(len == strlen(config->keywords[i]) && memcmp(word, config->keywords[i], len) == 0)
         {
-            const char* end = strstr(ptr, config->blockStringEnd);
-
-            ptr = end ? end + strlen(config->blockStringEnd) : blockStringStart + strlen(blockStringStart);
-            setCodeState(state, SyntaxType_STRING, (s32)(blockStringStart - start), (s32)(ptr - blockStringStart));
-            blockStringStart = NULL;
-            continue;
+            setCodeState(state, SyntaxType_KEYWORD, 0, len);
+            return;
         }
-        else if(blockStdStringStart)
-        {
-            const char* blockStart = blockStdStringStart+1;
 
-            while(true)
-            {
-                const char* pos = strchr(blockStart, *blockStdStringStart);
+    static const char* const ApiKeywords[] = {
+#define TIC_CALLBACK_DEF(name, ...) #name,
+        TIC_CALLBACK_LIST(TIC_CALLBACK_DEF)
+#undef  TIC_CALLBACK_DEF
 
-                if(pos)
-                {
-                    if(*(pos-1) == '\\' && *(pos-2) != '\\') blockStart = pos + 1;
-                    else
-                    {
-                        ptr = pos + 1;
-                        break;
-                    }
-                }
-                else
-                {
-                    ptr = blockStdStringStart + strlen(blockStdStringStart);
-                    break;
-                }
-            }
+#define API_KEYWORD_DEF(name, ...) #name,
+        TIC_API_LIST(API_KEYWORD_DEF)
+#undef  API_KEYWORD_DEF
+    };
+    const char* const* keywords = config->api_keywordsCount > 0 ? config->api_keywords : ApiKeywords;
+    const s32 apiCount = config->api_keywordsCount > 0 ? config->api_keywordsCount : COUNT_OF(ApiKeywords);
 
-            setCodeState(state, SyntaxType_STRING, (s32)(blockStdStringStart - start), (s32)(ptr - blockStdStringStart));
-            blockStdStringStart = NULL;
-            continue;
-        }
-        else if(singleCommentStart)
+    for(s32 i = 0; i < apiCount; i++)
+        if(len == strlen(keywords[i]) && memcmp(word, keywords[i], len) == 0)
         {
-            while(!islineend(*ptr))ptr++;
-
-            setCodeState(state, SyntaxType_COMMENT, (s32)(singleCommentStart - start), (s32)(ptr - singleCommentStart));
-            singleCommentStart = NULL;
-            continue;
+            setCodeState(state, SyntaxType_API, 0, len);
+            return;
         }
-        else if(wordStart)
-        {
-            while(!islineend(*ptr) && config_isalnum_(config, *ptr)) ptr++;
+}
 
-            s32 len = (s32)(ptr - wordStart);
-            bool keyword = false;
-            {
-                for(s32 i = 0; i < config->keywordsCount; i++)
-                    if(len == strlen(config->keywords[i]) && memcmp(wordStart, config->keywords[i], len) == 0)
-                    {
-                        setCodeState(state, SyntaxType_KEYWORD, (s32)(wordStart - start),len);
-                        keyword = true;
-                        break;
-                    }
-            }
+// colors one line starting in the given lexer state and returns the state at the start of the next line,
+// block comments and strings carry over line breaks, everything else ends with the line
+static u8 parseLine(const tic_script* config, const char* line, CodeState* state, u8 mode, const char** next)
+{
+    const char* end = line;
+    while(!islineend(*end)) end++;
 
-            if(!keyword)
-            {
-                static const char* const ApiKeywords[] = {
-#define             TIC_CALLBACK_DEF(name, ...) #name,
-                    TIC_CALLBACK_LIST(TIC_CALLBACK_DEF)
-#undef              TIC_CALLBACK_DEF
-
-#define             API_KEYWORD_DEF(name, ...) #name,
-                    TIC_API_LIST(API_KEYWORD_DEF)
-#undef              API_KEYWORD_DEF
-                };
-                const char* const* keywords = config->api_keywordsCount > 0 ? config->api_keywords : ApiKeywords;
-                const s32 apiCount = config->api_keywordsCount > 0 ? config->api_keywordsCount : COUNT_OF(ApiKeywords);
-
-                for(s32 i = 0; i < apiCount; i++)
-                    if(len == strlen(keywords[i]) && memcmp(wordStart, keywords[i], len) == 0)
-                    {
-                        setCodeState(state, SyntaxType_API, (s32)(wordStart - start), len);
-                        break;
-                    }
-            }
+    // unterminated blocks take the line break too
+    const char* stop = *end ? end + 1 : end;
 
-            wordStart = NULL;
-            continue;
-        }
-        else if(numberStart)
-        {
-            while(!islineend(*ptr))
-            {
-                char c = *ptr;
+    setCodeState(state, SyntaxType_FG, 0, (s32)(stop - line));
 
-                if(isdigit(c)) ptr++;
-                else if(numberStart[0] == '0'
-                    && (numberStart[1] == 'x' || numberStart[1] == 'X')
-                    && isxdigit(numberStart[2]))
-                {
-                    if((ptr - numberStart < 2) || isxdigit(c)) ptr++;
-                    else break;
-                }
-                else if(c == '.' || c == 'e' || c == 'E')
-                {
-                    if(isdigit(ptr[1])) ptr++;
-                    else break;
-                }
-                else break;
-            }
+    const char* ptr = line;
+    const char* token = line;
 
-            setCodeState(state, SyntaxType_NUMBER, (s32)(numberStart - start), (s32)(ptr - numberStart));
-            numberStart = NULL;
-            continue;
-        }
-        else
+    while(config)
+    {
+        if(mode == LexCode)
         {
-            if(config->blockCommentStart && memcmp(ptr, config->blockCommentStart, strlen(config->blockCommentStart)) == 0)
+            if(ptr == end) break;
+
+            token = ptr;
+            char c = *ptr;
+
+            if(isToken(ptr, config->blockCommentStart))
             {
-                blockCommentStart = ptr;
+                mode = LexBlockComment;
                 ptr += strlen(config->blockCommentStart);
-                continue;
             }
-            if(config->blockCommentStart2 && memcmp(ptr, config->blockCommentStart2, strlen(config->blockCommentStart2)) == 0)
+            else if(isToken(ptr, config->blockCommentStart2))
             {
-                blockCommentStart2 = ptr;
+                mode = LexBlockComment2;
                 ptr += strlen(config->blockCommentStart2);
-                continue;
             }
-            else if(config->blockStringStart && memcmp(ptr, config->blockStringStart, strlen(config->blockStringStart)) == 0)
+            else if(isToken(ptr, config->blockStringStart))
             {
-                blockStringStart = ptr;
+                mode = LexBlockString;
                 ptr += strlen(config->blockStringStart);
-                continue;
             }
-            else if ((config->stdStringStartEnd == NULL && (c == '"' || c == '\''))
-                     || (config->stdStringStartEnd != NULL && c != 0 && strchr(config->stdStringStartEnd, c)))
+            else if(strchr(getStringQuotes(config), c))
             {
-                blockStdStringStart = ptr;
+                mode = LexString + (u8)(strchr(getStringQuotes(config), c) - getStringQuotes(config));
                 ptr++;
-                continue;
             }
-            else if(config->singleComment && memcmp(ptr, config->singleComment, strlen(config->singleComment)) == 0)
+            else if(isToken(ptr, config->singleComment))
             {
-                singleCommentStart = ptr;
-                ptr += strlen(config->singleComment);
-                continue;
+                setCodeState(state, SyntaxType_COMMENT, (s32)(ptr - line), (s32)(end - ptr));
+                break;
             }
             else if(isalpha_(c))
             {
-                wordStart = ptr;
                 ptr++;
-                continue;
+                while(ptr < end && config_isalnum_(config, *ptr)) ptr++;
+
+                parseWord(config, token, (s32)(ptr - token), state + (token - line));
             }
             else if(isdigit(c) || (c == '.' && isdigit(ptr[1])))
             {
-                numberStart = ptr;
                 ptr++;
-                continue;
+                while(ptr < end)
+                {
+                    char c = *ptr;
+
+                    if(isdigit(c)) ptr++;
+                    else if(token[0] == '0'
+                        && (token[1] == 'x' || token[1] == 'X')
+                        && isxdigit(token[2]))
+                    {
+                        if((ptr - token < 2) || isxdigit(c)) ptr++;
+                        else break;
+                    }
+                    else if(c == '.' || c == 'e' || c == 'E')
+                    {
+                        if(isdigit(ptr[1])) ptr++;
+                        else break;
+                    }
+                    else break;
+                }
+
+                setCodeState(state, SyntaxType_NUMBER, (s32)(token - line), (s32)(ptr - token));
+            }
+            else
+            {
+                if(ispunct(c)) state[ptr - line].syntax = SyntaxType_SIGN;
+                ptr++;
             }
-            else if(ispunct(c)) state[ptr - start].syntax = SyntaxType_SIGN;
         }
+        else
+        {
+            const char* close = NULL;
+            u8 color = SyntaxType_COMMENT;
 
-        if(!c) break;
+            switch(mode)
+            {
+            case LexBlockComment:   close = findToken(ptr, end, config->blockCommentEnd); break;
+            case LexBlockComment2:  close = findToken(ptr, end, config->blockCommentEnd2); break;
+            case LexBlockString:    close = findToken(ptr, end, config->blockStringEnd); color = SyntaxType_STRING; break;
+            default:                close = findQuoteEnd(ptr, end, getStringQuotes(config)[mode - LexString]); color = SyntaxType_STRING; break;
+            }
 
-        ptr++;
+            if(!close)
+            {
+                setCodeState(state, color, (s32)(token - line), (s32)(stop - token));
+                break;
+            }
+
+            setCodeState(state, color, (s32)(token - line), (s32)(close - token));
+            ptr = close;
+            mode = LexCode;
+        }
     }
+
+    *next = *end ? end + 1 : NULL;
+
+    return config ? mode : LexCode;
 }
 
-static void parseSyntaxColor(Code* code)
+// colors the line at the position and moves the position to the next line or -1 after the last one,
+// the gap is moved out of the line first, so the lexer gets it in one piece
+static u8 parseLineAt(Code* code, const tic_script* config, s32* pos, u8 mode)
 {
-    for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
-        s->syntax = SyntaxType_FG;
+    s32 start = *pos;
+    s32 end = start;
+    while(end < code->text.size && getChar(code, end) != '\n') end++;
 
-    tic_mem* tic = code->tic;
+    s32 last = end < code->text.size ? end + 1 : end;
+    s32 gap = code->text.gap;
 
-    const tic_script* config = tic_get_script(tic);
+    if(gap > start && gap < last)
+        moveGap(code, gap - start < last - gap ? start : last);
+
+    const char* line = code->text.data + getOffset(code, start);
+    const char* next = NULL;
 
-    if(config)
+    CodeState* state = getState(code, start);
+    state->lexer = mode;
+    mode = parseLine(config, line, state, mode, &next);
+
+    *pos = next ? start + (s32)(next - line) : -1;
+
+    return mode;
+}
+
+// parses lines from the first unparsed one until the parsed part covers the position
+static void parseSyntax(Code* code, s32 pos)
+{
+    const tic_script* config = tic_get_script(code->tic);
+    s32 line = code->syntax.parsed;
+    u8 mode = code->syntax.mode;
+
+    if(code->syntax.parsed > code->text.size)
+        return;
+
+    while(line >= 0 && line <= pos)
+        mode = parseLineAt(code, config, &line, mode);
+
+    code->syntax.parsed = line >= 0 ? line : code->text.size + 1;
+    code->syntax.mode = mode;
+}
+
+// recolors the lines touched by an edit at the position until the lexer state
+// after a line matches the one stored before the edit, the rest is parsed lazily
+static void reparseSyntax(Code* code, s32 pos, s32 edited)
+{
+    const tic_script* config = tic_get_script(code->tic);
+    s32 parsed = code->syntax.parsed;
+
+    // the previous line break is before the edit, so the line state is still there
+    s32 line = pos > 0 ? getPosByLine(code, getLineIndex(code, pos - 1)) : 0;
+
+    u8 mode = line > 0 ? getState(code, line)->lexer : LexCode;
+
+    while(line >= 0)
+    {
+        mode = parseLineAt(code, config, &line, mode);
+
+        if(line >= 0 && line > edited)
+        {
+            if(line < parsed && getState(code, line)->lexer == mode)
+                return;
+
+            break;
+        }
+    }
+
+    code->syntax.parsed = line >= 0 ? line : code->text.size + 1;
+    code->syntax.mode = mode;
+}
+
+// updates the parsed bound after 'removed' chars at the position are replaced with 'inserted' ones
+static void editSyntax(Code* code, s32 pos, s32 removed, s32 inserted)
+{
+    s32* parsed = &code->syntax.parsed;
+
+    if(pos < *parsed)
     {
-        parseCode(config, code->src, code->state);
+        *parsed = *parsed >= pos + removed
+            ? *parsed + inserted - removed
+            : pos + inserted;
+
+        reparseSyntax(code, pos, pos + inserted);
     }
 }
 
-static char* getLineByPos(Code* code, char* pos)
+static inline const CodeState* getSyntax(Code* code, s32 pos)
 {
-    char* text = code->src;
-    char* line = text;
+    if(pos >= code->syntax.parsed)
+        parseSyntax(code, pos);
 
-    while(text < pos)
-        if(*text++ == '\n')
-            line = text;
+    return getState(code, pos);
+}
 
-    return line;
+static void resetSyntax(Code* code)
+{
+    code->syntax.parsed = 0;
+    code->syntax.mode = LexCode;
 }
 
-static char* getLine(Code* code)
+static void parseSyntaxColor(Code* code)
 {
-    return getLineByPos(code, code->cursor.position);
+    parseSyntax(code, getPosByLine(code, code->scroll.y + TEXT_BUFFER_HEIGHT));
 }
 
-static char* getPrevLineByPos(Code* code, char* pos)
+static s32 getLineByPos(Code* code, s32 pos)
 {
-    char* text = code->src;
-    char* prevLine = text;
-    char* line = text;
+    return getPosByLine(code, getLineIndex(code, pos));
+}
 
-    while(text < pos)
-        if(*text++ == '\n')
-        {
-            prevLine = line;
-            line = text;
-        }
+static s32 getLine(Code* code)
+{
+    return getLineByPos(code, code->cursor.position);
+}
 
-    return prevLine;
+static s32 getPrevLineByPos(Code* code, s32 pos)
+{
+    return getPosByLine(code, getLineIndex(code, pos) - 1);
 }
 
-static char* getPrevLine(Code* code)
+static s32 getPrevLine(Code* code)
 {
     return getPrevLineByPos(code, code->cursor.position);
 }
 
-static char* getNextLine(Code* code)
+static s32 getNextLine(Code* code)
 {
     return getNextLineByPos(code, code->cursor.position);
 }
 
-static s32 getLineSize(const char* line)
+static s32 getLineSize(Code* code, s32 line)
 {
     s32 size = 0;
-    while(*line != '\n' && *line++) size++;
+    while(!islineend(getChar(code, line++))) size++;
 
     return size;
 }
 
 static void updateColumn(Code* code)
 {
-    code->cursor.column = (s32)(code->cursor.position - getLine(code));
+    code->cursor.column = code->cursor.position - getLine(code);
 }
 
-static void updateCursorPosition(Code* code, char* position)
+static void updateCursorPosition(Code* code, s32 position)
 {
     code->cursor.position = position;
     updateColumn(code);
@@ -828,43 +1103,16 @@ static void updateCursorPosition(Code* code, char* position)
 
 static void setCursorPosition(Code* code, s32 cx, s32 cy)
 {
-    s32 x = 0;
-    s32 y = 0;
-    char* pointer = code->src;
+    s32 line = getPosByLine(code, cy);
 
-    while(*pointer)
-    {
-        if(y == cy && x == cx)
-        {
-            updateCursorPosition(code, pointer);
-            return;
-        }
-
-        if(*pointer == '\n')
-        {
-            if(y == cy && cx > x)
-            {
-                updateCursorPosition(code, pointer);
-                return;
-            }
-
-            x = 0;
-            y++;
-        }
-        else x++;
-
-        pointer++;
-    }
-
-    updateCursorPosition(code, pointer);
+    updateCursorPosition(code, line + MIN(cx, getLineSize(code, line)));
 }
 
 static void startLine(Code* code)
 {
-    char* start = code->src;
-    while(code->cursor.position > start+1)
+    while(code->cursor.position > 1)
     {
-        if (islineend(*(code->cursor.position-1)))
+        if (islineend(getChar(code, code->cursor.position-1)))
             break;
         --code->cursor.position;
     }
@@ -873,9 +1121,9 @@ static void startLine(Code* code)
 
 static void endLine(Code* code)
 {
-    while(*code->cursor.position)
+    while(getChar(code, code->cursor.position))
     {
-        if (islineend(*code->cursor.position))
+        if (islineend(getChar(code, code->cursor.position)))
             break;
         code->cursor.position++;
     }
@@ -884,27 +1132,25 @@ static void endLine(Code* code)
 
 static void upLine(Code* code)
 {
-    char* prevLine = getPrevLine(code);
-    size_t prevSize = getLineSize(prevLine);
-    size_t size = code->cursor.column;
+    s32 prevLine = getPrevLine(code);
+    s32 prevSize = getLineSize(code, prevLine);
+    s32 size = code->cursor.column;
 
     code->cursor.position = prevLine + (prevSize > size ? size : prevSize);
 }
 
 static void downLine(Code* code)
 {
-    char* nextLine = getNextLine(code);
-    size_t nextSize = getLineSize(nextLine);
-    size_t size = code->cursor.column;
+    s32 nextLine = getNextLine(code);
+    s32 nextSize = getLineSize(code, nextLine);
+    s32 size = code->cursor.column;
 
     code->cursor.position = nextLine + (nextSize > size ? size : nextSize);
 }
 
 static void leftColumn(Code* code)
 {
-    char* start = code->src;
-
-    if(code->cursor.position > start)
+    if(code->cursor.position > 0)
     {
         code->cursor.position--;
         updateColumn(code);
@@ -913,7 +1159,7 @@ static void leftColumn(Code* code)
 
 static void rightColumn(Code* code)
 {
-    if(*code->cursor.position)
+    if(getChar(code, code->cursor.position))
     {
         code->cursor.position++;
         updateColumn(code);
@@ -922,20 +1168,19 @@ static void rightColumn(Code* code)
 
 typedef bool(*tic_code_predicate)(Code* code, char c);
 
-static char* leftPos(Code* code, char* pos, tic_code_predicate pred)
+static s32 leftPos(Code* code, s32 pos, tic_code_predicate pred)
 {
-    const char* start = code->src;
-    if(pos > start)
+    if(pos > 0)
     {
-        if(pred(code, *pos)) while(pos > start && pred(code, *(pos-1))) pos--;
-        else while(pos > start && !pred(code, *(pos-1))) pos--;
+        if(pred(code, getChar(code, pos))) while(pos > 0 && pred(code, getChar(code, pos-1))) pos--;
+        else while(pos > 0 && !pred(code, getChar(code, pos-1))) pos--;
         return pos;
     }
 
     return code->cursor.position;
 }
 
-static char* leftWordPos(Code* code)
+static s32 leftWordPos(Code* code)
 {
     return leftPos(code, code->cursor.position-1, isalnum_);
 }
@@ -946,67 +1191,65 @@ static void leftWord(Code* code)
     updateColumn(code);
 }
 
-static char* leftQuote(Code* code, char* pos)
+static s32 leftQuote(Code* code, s32 pos)
 {
-    char* start = code->src;
-    while (pos > start)
+    while (pos > 0)
     {
-        if (isdoublequote(*pos) && *(pos-1) != '\\')
+        if (isdoublequote(getChar(code, pos)) && getChar(code, pos-1) != '\\')
             return pos;
         --pos;
     }
-    return start;
+    return 0;
 }
 
-static char* rightQuote(Code* code, char* pos)
+static s32 rightQuote(Code* code, s32 pos)
 {
-    char* end = code->src + strlen(code->src);
+    s32 end = code->text.size;
     while (pos < end)
     {
-        if (isdoublequote(*pos) && *(pos-1) != '\\')
+        if (isdoublequote(getChar(code, pos)) && getChar(code, pos-1) != '\\')
             return pos;
         ++pos;
     }
     return end;
 }
 
-static char* leftSexp(Code* code, char* pos)
+static s32 leftSexp(Code* code, s32 pos)
 {
-    char* start = code->src;
     int nesting = 0;
 
-    while (pos >= start)
+    while (pos >= 0)
     {
-        if (isopenparen_(code, *pos))
+        if (isopenparen_(code, getChar(code, pos)))
         {
             if (nesting == 0)
                 return pos;
             else
                 --nesting;
         }
-        else if (iscloseparen_(code, *pos))
+        else if (iscloseparen_(code, getChar(code, pos)))
         {
             ++nesting;
         }
         --pos;
     }
-    return start; // fallback
+    return 0; // fallback
 }
 
-static char* rightPos(Code* code, char* pos, tic_code_predicate pred)
+static s32 rightPos(Code* code, s32 pos, tic_code_predicate pred)
 {
-    const char* end = code->src + strlen(code->src);
+    s32 end = code->text.size;
 
     if(pos < end)
     {
-        if(pred(code, *pos)) while(pos < end && pred(code, *pos)) pos++;
-        else while(pos < end && !pred(code, *pos)) pos++;
+        if(pred(code, getChar(code, pos))) while(pos < end && pred(code, getChar(code, pos))) pos++;
+        else while(pos < end && !pred(code, getChar(code, pos))) pos++;
     }
 
     return pos;
 }
 
-static char* rightWordPos(Code* code)
+static s32 rightWordPos(Code* code)
 {
     return rightPos(code, code->cursor.position, isalnum_);
 }
@@ -1017,21 +1260,21 @@ static void rightWord(Code* code)
     updateColumn(code);
 }
 
-static char* rightSexp(Code* code, char* pos)
+static s32 rightSexp(Code* code, s32 pos)
 {
-    char* end = code->src + strlen(code->src);
+    s32 end = code->text.size;
     int nesting = 0;
 
     while (pos < end)
     {
-        if (iscloseparen_(code, *pos))
+        if (iscloseparen_(code, getChar(code, pos)))
         {
             if (nesting == 0)
                 return pos;
             else
                 --nesting;
         }
-        else if (isopenparen_(code, *pos))
+        else if (isopenparen_(code, getChar(code, pos)))
         {
             ++nesting;
         }
@@ -1049,22 +1292,22 @@ static void goHome(Code* code)
 
 static void goEnd(Code* code)
 {
-    char* line = getLine(code);
-    code->cursor.position = line + getLineSize(line);
+    s32 line = getLine(code);
+    code->cursor.position = line + getLineSize(code, line);
 
     updateColumn(code);
 }
 
 static void goCodeHome(Code *code)
 {
-    code->cursor.position = code->src;
+    code->cursor.position = 0;
 
     updateColumn(code);
 }
 
 static void goCodeEnd(Code *code)
 {
-    code->cursor.position = code->src + strlen(code->src);
+    code->cursor.position = code->text.size;
 
     updateColumn(code);
 }
@@ -1104,48 +1347,94 @@ static void halfPageDown(Code* code)
     setCursorPosition(code, column, line < lines - half ? line + half : lines);
 }
 
-static void deleteCode(Code* code, char* start, char* end)
+// the callers move the cursor, the other positions just can't stay past the end
+static void clampPositions(Code* code)
 {
-    s32 size = (s32)strlen(end) + 1;
-    memmove(start, end, size);
+    s32* positions[] = {&code->cursor.selection, &code->cursor.mouseDownPosition,
+        &code->popup.prevPos, &code->popup.prevSel};
 
-    // delete code state
-    memmove(getState(code, start), getState(code, end), size * sizeof(CodeState));
+    for(s32 i = 0; i < COUNT_OF(positions); i++)
+        *positions[i] = MIN(*positions[i], code->text.size);
 }
 
-static void insertCodeSize(Code* code, char* dst, const char* src, s32 size)
+static void deleteCode(Code* code, s32 start, s32 end)
 {
-    s32 restSize = (s32)strlen(dst) + 1;
-    memmove(dst + size, dst, restSize);
-    memcpy(dst, src, size);
+    s32 size = end - start;
+
+    // an empty edit shouldn't move the gap, that would be an undo step
+    if(size <= 0)
+        return;
+
+    if(code->historyCursor >= start)
+        code->historyCursor = code->historyCursor >= end
+            ? code->historyCursor - size
+            : -1;
+
+    // the deleted text joins the gap
+    moveGap(code, start);
+
+    s32 offset = start + getGapSize(code);
+    memset(code->text.data + offset, 0, size);
+    memset(code->state + offset, 0, size * sizeof(CodeState));
+    markState(code, offset, offset + size);
+    code->historyEdited = true;
+
+    deleteLines(code, start, size);
+    clampPositions(code);
+
+    editSyntax(code, start, size, 0);
+}
+
+// the text can't be in the code buffer, it moves while the gap is filled
+static void insertCodeSize(Code* code, s32 pos, const char* text, s32 size)
+{
+    size = MIN(size, getGapSize(code));
+
+    if(size <= 0)
+        return;
+
+    moveGap(code, pos);
+
+    memcpy(code->text.data + pos, text, size);
 
-    // insert code state
     {
-        CodeState* pos = getState(code, dst);
-        memmove(pos + size, pos, restSize * sizeof(CodeState));
-        memset(pos, 0, size * sizeof(CodeState));
+        CodeState* state = code->state + pos;
+
+        for(s32 i = 0; i < size; i++)
+            state[i].sym = text[i];
     }
+
+    markState(code, pos, pos + size);
+    code->text.gap += size;
+    code->historyEdited = true;
+
+    if(code->historyCursor >= pos)
+        code->historyCursor += size;
+
+    insertLines(code, pos, text, size);
+
+    editSyntax(code, pos, 0, size);
 }
 
-static void insertCode(Code* code, char* dst, const char* src)
+static void insertCode(Code* code, s32 pos, const char* text)
 {
-    insertCodeSize(code, dst, src, strlen(src));
+    insertCodeSize(code, pos, text, strlen(text));
 }
 
 static bool replaceSelection(Code* code)
 {
-    char* pos = code->cursor.position;
-    char* sel = code->cursor.selection;
+    s32 pos = code->cursor.position;
+    s32 sel = code->cursor.selection;
 
-    if(sel && sel != pos)
+    if(sel >= 0 && sel != pos)
     {
-        char* start = MIN(sel, pos);
-        char* end = MAX(sel, pos);
+        s32 start = MIN(sel, pos);
+        s32 end = MAX(sel, pos);
 
         deleteCode(code, start, end);
 
         code->cursor.position = start;
-        code->cursor.selection = NULL;
+        code->cursor.selection = -1;
 
         history(code);
 
@@ -1170,21 +1459,20 @@ static inline bool shouldUseStructuredEdit(Code* code)
 }
 
 
-static bool structuredDeleteOverride(Code* code, char* pos)
+static bool structuredDeleteOverride(Code* code, s32 pos)
 {
     if (!shouldUseStructuredEdit(code))
         return false;
 
-    const char* end = code->src + strlen(code->src);
-    if (pos >= end-1)
+    if (pos >= code->text.size-1)
         return false;
 
-    const bool isopen = isopenparen_(code, *pos);
-    const bool isclose = iscloseparen_(code, *pos);
+    const bool isopen = isopenparen_(code, getChar(code, pos));
+    const bool isclose = iscloseparen_(code, getChar(code, pos));
     if (isopen || isclose)
     {
-        if (isopen && iscloseparen_(code, *(pos+1))
-            || isclose && isopenparen_(code, *(pos+1)))
+        if (isopen && iscloseparen_(code, getChar(code, pos+1))
+            || isclose && isopenparen_(code, getChar(code, pos+1)))
         {
             deleteCode(code, pos, pos+2);
             history(code);
@@ -1195,9 +1483,9 @@ static bool structuredDeleteOverride(Code* code, char* pos)
         return true;
     }
 
-    if (isdoublequote(*pos))
+    if (isdoublequote(getChar(code, pos)))
     {
-       const bool canRemoveDblQuote = isdoublequote(*(pos+1));
+       const bool canRemoveDblQuote = isdoublequote(getChar(code, pos+1));
        if (canRemoveDblQuote)
        {
            deleteCode(code, pos, pos+2);
@@ -1219,7 +1507,7 @@ static void deleteChar(Code* code)
         if (structuredDeleteOverride(code, code->cursor.position))
             return;
 
-        deleteCode(code, code->cursor.position, code->cursor.position + 1);
+        deleteCode(code, code->cursor.position, MIN(code->cursor.position + 1, code->text.size));
         history(code);
         parseSyntaxColor(code);
     }
@@ -1229,9 +1517,9 @@ static void deleteChar(Code* code)
 
 static void backspaceChar(Code* code)
 {
-    if(!replaceSelection(code) && code->cursor.position > code->src)
+    if(!replaceSelection(code) && code->cursor.position > 0)
     {
-        char* pos = --code->cursor.position;
+        s32 pos = --code->cursor.position;
 
         if (structuredDeleteOverride(code, pos))
             return;
@@ -1246,13 +1534,13 @@ static void backspaceChar(Code* code)
 
 static void deleteWord(Code* code)
 {
-    const char* end = code->src + strlen(code->src);
-    char* pos = code->cursor.position;
+    s32 end = code->text.size;
+    s32 pos = code->cursor.position;
 
     if(pos < end)
     {
-        if(isalnum_(code, *pos)) while(pos < end && isalnum_(code, *pos)) pos++;
-        else while(pos < end && !isalnum_(code, *pos)) pos++;
+        if(isalnum_(code, getChar(code, pos))) while(pos < end && isalnum_(code, getChar(code, pos))) pos++;
+        else while(pos < end && !isalnum_(code, getChar(code, pos))) pos++;
 
         deleteCode(code, code->cursor.position, pos);
 
@@ -1263,13 +1551,12 @@ static void deleteWord(Code* code)
 
 static void backspaceWord(Code* code)
 {
-    const char* start = code->src;
-    char* pos = code->cursor.position-1;
+    s32 pos = code->cursor.position-1;
 
-    if(pos > start)
+    if(pos > 0)
     {
-        if(isalnum_(code, *pos)) while(pos > start && isalnum_(code, *(pos-1))) pos--;
-        else while(pos > start && !isalnum_(code, *(pos-1))) pos--;
+        if(isalnum_(code, getChar(code, pos))) while(pos > 0 && isalnum_(code, getChar(code, pos-1))) pos--;
+        else while(pos > 0 && !isalnum_(code, getChar(code, pos-1))) pos--;
 
         deleteCode(code, pos, code->cursor.position);
 
@@ -1279,15 +1566,15 @@ static void backspaceWord(Code* code)
     }
 }
 
-char* findLineEnd(Code* code, char* pos)
+s32 findLineEnd(Code* code, s32 pos)
 {
-    char* lineend = pos+1;
-    const char* end = code->src + strlen(code->src);
+    s32 lineend = pos+1;
+    s32 end = code->text.size;
 
     while (lineend < end)
     {
-        if (islineend(*lineend)) break;
-        if (shouldUseStructuredEdit(code) && iscloseparen_(code, *lineend)) break;
+        if (islineend(getChar(code, lineend))) break;
+        if (shouldUseStructuredEdit(code) && iscloseparen_(code, getChar(code, lineend))) break;
         ++lineend;
     }
     return lineend;
@@ -1295,19 +1582,18 @@ char* findLineEnd(Code* code, char* pos)
 
 static void deleteLine(Code* code)
 {
-    char* linestart = code->cursor.position;
-    char* lineend = linestart+1;
-    const char* end = code->src + strlen(code->src);
+    s32 linestart = code->cursor.position;
+    s32 lineend = linestart+1;
 
     if (shouldUseStructuredEdit(code))
     {
-        if (islineend(*linestart) || islineend(*lineend))
+        if (islineend(getChar(code, linestart)) || islineend(getChar(code, lineend)))
             noop;
-        else if (isopenparen_(code, *linestart))
+        else if (isopenparen_(code, getChar(code, linestart)))
             lineend = rightSexp(code, linestart+1)+1;
-        else if (isdoublequote(*linestart))
+        else if (isdoublequote(getChar(code, linestart)))
         {
-            char* nextQuote = rightQuote(code, linestart+1);
+            s32 nextQuote = rightQuote(code, linestart+1);
             lineend = findLineEnd(code, linestart);
             if (nextQuote < lineend)
                 lineend = nextQuote+1;
@@ -1316,15 +1602,14 @@ static void deleteLine(Code* code)
         }
         else
         {
-            const char* start = code->src;
-            const char* sexpStart = leftSexp(code, linestart);
-            const char* strStart = leftQuote(code, linestart);
-            char* sexpEnd = rightSexp(code, linestart);
-            char* strEnd = rightQuote(code, linestart);
+            s32 sexpStart = leftSexp(code, linestart);
+            s32 strStart = leftQuote(code, linestart);
+            s32 sexpEnd = rightSexp(code, linestart);
+            s32 strEnd = rightQuote(code, linestart);
             const bool isInsideStr = strStart > sexpStart && strEnd < sexpEnd;
             if (isInsideStr)
                 lineend = strEnd;
-            else if (sexpStart != start)
+            else if (sexpStart != 0)
                 lineend = sexpEnd;
             else
                 lineend = findLineEnd(code, linestart);
@@ -1335,12 +1620,13 @@ static void deleteLine(Code* code)
         lineend = findLineEnd(code, linestart);
     }
 
+    lineend = MIN(lineend, code->text.size);
+
     const size_t linesize = lineend-linestart;
     char* clipboard = (char*)malloc(linesize+1);
     if(clipboard)
     {
-        memcpy(clipboard, linestart, linesize);
-        clipboard[linesize] = '\0';
+        copyText(code, clipboard, linestart, lineend);
         tic_sys_clipboard_set(clipboard);
         free(clipboard);
     }
@@ -1355,7 +1641,7 @@ static void deleteLine(Code* code)
 
 static void inputSymbolBase(Code* code, char sym)
 {
-    if (strlen(code->src) >= MAX_CODE)
+    if (code->text.size >= MAX_CODE)
         return;
 
     const bool useStructuredEdit = shouldUseStructuredEdit(code);
@@ -1387,18 +1673,18 @@ static void newLine(Code* code)
 {
     if(!replaceSelection(code))
     {
-        char* ptr = getLine(code);
-        size_t size = 0;
-        char firstChar = *ptr;
+        s32 ptr = getLine(code);
+        s32 size = 0;
+        char firstChar = getChar(code, ptr);
 
-        while(*ptr == '\t' || *ptr == ' ') ptr++, size++;
+        while(getChar(code, ptr) == '\t' || getChar(code, ptr) == ' ') ptr++, size++;
 
         if(ptr > code->cursor.position)
             size -= ptr - code->cursor.position;
 
         inputSymbol(code, '\n');
 
-        for(size_t i = 0; i < size; i++)
+        for(s32 i = 0; i < size; i++)
             inputSymbol(code, firstChar);
 
         updateEditor(code);
@@ -1407,24 +1693,24 @@ static void newLine(Code* code)
 
 static void selectAll(Code* code)
 {
-    code->cursor.selection = code->src;
-    code->cursor.position = code->cursor.selection + strlen(code->cursor.selection);
+    code->cursor.selection = 0;
+    code->cursor.position = code->text.size;
 }
 
 static void killSelection(Code* code)
 {
-    code->cursor.selection = NULL;
+    code->cursor.selection = -1;
 }
 
 static void copyToClipboard(Code* code, bool killSelection)
 {
-    char* pos = code->cursor.position;
-    char* sel = code->cursor.selection;
+    s32 pos = code->cursor.position;
+    s32 sel = code->cursor.selection;
 
-    char* start = NULL;
-    size_t size = 0;
+    s32 start = -1;
+    s32 size = 0;
 
-    if(sel && sel != pos)
+    if(sel >= 0 && sel != pos)
     {
         start = MIN(sel, pos);
         size = MAX(sel, pos) - start;
@@ -1439,19 +1725,18 @@ static void copyToClipboard(Code* code, bool killSelection)
 
     if(clipboard)
     {
-        memcpy(clipboard, start, size);
-        clipboard[size] = '\0';
+        copyText(code, clipboard, start, start + size);
         tic_sys_clipboard_set(clipboard);
         free(clipboard);
     }
 
     if (killSelection)
-        code->cursor.selection = NULL;
+        code->cursor.selection = -1;
 }
 
 static void cutToClipboard(Code* code, bool killSelection)
 {
-    if(code->cursor.selection == NULL || code->cursor.position == code->cursor.selection)
+    if(code->cursor.selection < 0 || code->cursor.position == code->cursor.selection)
     {
         code->cursor.position = getLine(code);
         code->cursor.selection = getNextLine(code);
@@ -1461,7 +1746,7 @@ static void cutToClipboard(Code* code, bool killSelection)
     replaceSelection(code);
 
     if (killSelection)
-        code->cursor.selection = NULL;
+        code->cursor.selection = -1;
 
     //no call to history because it gets called in replaceSelection
 }
@@ -1483,7 +1768,7 @@ static void copyFromClipboard(Code* code, bool killSelection)
 
                 // cut clipboard code if overall code > max code size
                 {
-                    size_t codeSize = strlen(code->src);
+                    size_t codeSize = code->text.size;
 
                     if(codeSize >= MAX_CODE)
                         return;
@@ -1499,7 +1784,7 @@ static void copyFromClipboard(Code* code, bool killSelection)
                 code->cursor.position += size;
 
                 if (killSelection)
-                    code->cursor.selection = NULL;
+                    code->cursor.selection = -1;
 
                 history(code);
                 parseSyntaxColor(code);
@@ -1512,6 +1797,9 @@ static void copyFromClipboard(Code* code, bool killSelection)
 
 static void update(Code* code)
 {
+    indexLines(code);
+    resetSyntax(code);
+
     updateColumn(code);
     updateEditor(code);
     parseSyntaxColor(code);
@@ -1551,7 +1839,7 @@ static bool useSpacesForTab(Code* code) {
 }
 
 
-static s32 insertTab(Code* code, char* line_start, char* pos) {
+static s32 insertTab(Code* code, s32 line_start, s32 pos) {
     if (useSpacesForTab(code)) {
         s32 tab_size = getConfig(code->studio)->options.tabSize;
         s32 count = 0;
@@ -1571,20 +1859,20 @@ static s32 insertTab(Code* code, char* line_start, char* pos) {
 }
 
 //has no effect if pos is not a valid tab character
-static s32 removeTab(Code* code, char* line_start, char* pos) {
+static s32 removeTab(Code* code, s32 line_start, s32 pos) {
     if (useSpacesForTab(code)) {
         s32 tab_size = getConfig(code->studio)->options.tabSize;
         s32 count = 0;
 
         while(count < tab_size) {
-            if (*pos != ' ')
+            if (getChar(code, pos) != ' ')
                 break;
             deleteCode(code, pos, pos+1);
             count++;
         }
 
         return count;
-    } else if (*pos == '\t' || *pos == ' ') {
+    } else if (getChar(code, pos) == '\t' || getChar(code, pos) == ' ') {
         deleteCode(code, pos, pos+1);
         return 1;
     }
@@ -1593,33 +1881,33 @@ static s32 removeTab(Code* code, char* line_start, char* pos) {
 
 static void doTab(Code* code, bool shift, bool crtl)
 {
-    char* cursor_position = code->cursor.position;
-    char* cursor_selection = code->cursor.selection;
+    s32 cursor_position = code->cursor.position;
+    s32 cursor_selection = code->cursor.selection;
 
-    bool has_selection = cursor_selection && cursor_selection != cursor_position;
+    bool has_selection = cursor_selection >= 0 && cursor_selection != cursor_position;
     bool modifier_key_pressed = shift || crtl;
 
     if(has_selection || modifier_key_pressed)
     {
-        char* start;
-        char* end;
+        s32 start;
+        s32 end;
 
         bool changed = false;
 
-        if(cursor_selection) {
+        if(cursor_selection >= 0) {
             start = MIN(cursor_selection, cursor_position);
             end = MAX(cursor_selection, cursor_position);
         } else {
             start = end = cursor_position;
         }
 
-        char* line = start = getLineByPos(code, start);
+        s32 line = start = getLineByPos(code, start);
 
-        while(line)
+        while(true)
         {
             if(shift)
             {
-                if(*line == '\t' || *line == ' ')
+                if(getChar(code, line) == '\t' || getChar(code, line) == ' ')
                 {
                     end -= removeTab(code, line, line);
                     changed = true;
@@ -1650,7 +1938,7 @@ static void doTab(Code* code, bool shift, bool crtl)
     }
     else
     {
-        char* line = getLineByPos(code, code->cursor.position);
+        s32 line = getLineByPos(code, code->cursor.position);
         code->cursor.position += insertTab(code, line, code->cursor.position);
         history(code);
         update(code);
@@ -1676,16 +1964,16 @@ static void newLineAutoClose(Code* code)
 
 static void setFindOrReplaceMode(Code* code)
 {
-    if(code->cursor.selection)
+    if(code->cursor.selection >= 0)
     {
-        const char* end = MAX(code->cursor.position, code->cursor.selection);
-        const char* start = MIN(code->cursor.position, code->cursor.selection);
-        size_t len = end - start;
+        s32 end = MAX(code->cursor.position, code->cursor.selection);
+        s32 start = MIN(code->cursor.position, code->cursor.selection);
+        s32 len = end - start;
 
         if(len > 0 && len < sizeof code->popup.text - 1)
         {
             memset(code->popup.text, 0, sizeof code->popup.text);
-            memcpy(code->popup.text, start, len);
+            copyText(code, code->popup.text, start, end);
         }
     }
 }
@@ -1747,17 +2035,16 @@ static void updateSidebarCode(Code* code)
 {
     tic_mem* tic = code->tic;
 
-    const tic_outline_item* item = code->sidebar.items + code->sidebar.index;
-
-    if(code->sidebar.size && item && item->pos)
+    if(code->sidebar.size)
     {
-        code->cursor.position = (char*)item->pos;
-        code->cursor.selection = (char*)item->pos + item->size;
+        const s32 pos = code->sidebar.items[code->sidebar.index].pos;
+        code->cursor.position = pos;
+        code->cursor.selection = pos + code->sidebar.items[code->sidebar.index].size;
     }
     else
     {
-        code->cursor.position = code->src;
-        code->cursor.selection = NULL;
+        code->cursor.position = 0;
+        code->cursor.selection = -1;
     }
 
     centerScroll(code);
@@ -1773,22 +2060,23 @@ static bool isFilterMatch(const char* buffer, s32 size, const char* filter)
     return *filter == 0;
 }
 
-static void drawFilterMatch(Code *code, s32 x, s32 y, const char* orig, s32 size, const char* filter)
+static void drawFilterMatch(Code *code, s32 x, s32 y, s32 pos, s32 size, const char* filter)
 {
     while(size--)
     {
-        bool match = tolower(*orig) == tolower(*filter);
+        char sym = getChar(code, pos);
+        bool match = tolower(sym) == tolower(*filter);
         u8 color = match ? tic_color_orange : tic_color_white;
 
         if(code->shadowText)
-            drawChar(code->tic, *orig, x+1, y+1, tic_color_black, code->altFont);
+            drawChar(code->tic, sym, x+1, y+1, tic_color_black, code->altFont);
 
-        drawChar(code->tic, *orig, x, y, color, code->altFont);
+        drawChar(code->tic, sym, x, y, color, code->altFont);
         x += getFontWidth(code);
         if(match)
             filter++;
 
-        orig++;
+        pos++;
     }
 }
 
@@ -1802,24 +2090,42 @@ static void initSidebarMode(Code* code)
 
     if(config->getOutline)
     {
+        // the outline points into the text, it has to stay in place until the items are stored
+        parseSyntax(code, code->text.size);
+        const char* text = getText(code);
+
         s32 size = 0;
-        const tic_outline_item* items = config->getOutline(code->src, &size);
+        const tic_outline_item* items = config->getOutline(text, &size);
 
         if(items)
         {
+            tic_outline_item* found = malloc(size * sizeof(tic_outline_item));
+            s32 count = 0;
+
             for(const tic_outline_item *it = items, *end = items + size; it != end ; ++it)
             {
-                if(code->state[it->pos - code->src].syntax == SyntaxType_COMMENT)
+                if(getState(code, (s32)(it->pos - text))->syntax == SyntaxType_COMMENT)
                     continue;
 
                 const char* filter = code->popup.text;
                 if(*filter && !isFilterMatch(it->pos, it->size, filter))
                     continue;
 
-                s32 last = code->sidebar.size++;
-                code->sidebar.items = realloc(code->sidebar.items, code->sidebar.size * sizeof(tic_outline_item));
-                code->sidebar.items[last] = *it;
+                found[count++] = *it;
             }
+
+            qsort(found, count, sizeof(tic_outline_item), funcCompare);
+
+            code->sidebar.size = count;
+            code->sidebar.items = realloc(code->sidebar.items, count * sizeof *code->sidebar.items);
+
+            for(s32 i = 0; i < count; i++)
+            {
+                code->sidebar.items[i].pos = (s32)(found[i].pos - text);
+                code->sidebar.items[i].size = found[i].size;
+            }
+
+            free(found);
         }
     }
 }
@@ -1830,23 +2136,16 @@ static void setBookmarkMode(Code* code)
     code->sidebar.scroll = 0;
     code->sidebar.size = 0;
 
-    const char* ptr = code->src;
-    const CodeState* state = code->state;
-
-    while(*ptr)
+    for(s32 pos = 0; pos < code->text.size; pos++)
     {
-        if(state->bookmark)
+        if(getState(code, pos)->bookmark)
         {
             s32 last = code->sidebar.size++;
-            code->sidebar.items = realloc(code->sidebar.items, code->sidebar.size * sizeof(tic_outline_item));
-            tic_outline_item* item = &code->sidebar.items[last];
+            code->sidebar.items = realloc(code->sidebar.items, code->sidebar.size * sizeof *code->sidebar.items);
 
-            item->pos = ptr;
-            item->size = getLineSize(ptr);
+            code->sidebar.items[last].pos = pos;
+            code->sidebar.items[last].size = getLineSize(code, pos);
         }
-
-        ptr++;
-        state++;
     }
 
     updateSidebarCode(code);
@@ -1859,7 +2158,6 @@ static void setOutlineMode(Code* code)
 
     initSidebarMode(code);
 
-    qsort(code->sidebar.items, code->sidebar.size, sizeof(tic_outline_item), funcCompare);
     updateSidebarCode(code);
 }
 
@@ -1898,19 +2196,19 @@ static void setCodeMode(Code* code, s32 mode)
 }
 
 static int getNumberOfLines(Code* code){
-    char* pos = code->cursor.position;
-    char* sel = code->cursor.selection;
+    s32 pos = code->cursor.position;
+    s32 sel = code->cursor.selection;
 
-    char* start = MIN(pos, sel);
-    while(*start == '\n') start++;
+    s32 start = MIN(pos, sel);
+    while(getChar(code, start) == '\n') start++;
 
-    char* end = MAX(pos, sel);
-    while(*end == '\n') end--;
+    s32 end = MAX(pos, sel);
+    while(getChar(code, end) == '\n') end--;
 
-    char* iter = start;
+    s32 iter = start;
     size_t lines = 1;
     while(iter <= end){
-        if(*iter == '\n'){
+        if(getChar(code, iter) == '\n'){
             ++lines;
         }
         ++iter;
@@ -1918,44 +2216,47 @@ static int getNumberOfLines(Code* code){
     return lines;
 }
 
-static char** getLines(Code* code, int lines){
-    char* pos = code->cursor.position;
-    char* sel = code->cursor.selection;
+static s32* getLines(Code* code, int lines){
+    s32 pos = code->cursor.position;
+    s32 sel = code->cursor.selection;
 
 
-    char* start = MIN(pos, sel);
-    while(*start == '\n') ++start;
+    s32 start = MIN(pos, sel);
+    while(getChar(code, start) == '\n') ++start;
 
-    char* end = MAX(pos, sel);
-    while(*end == '\n') --end;
+    s32 end = MAX(pos, sel);
+    while(getChar(code, end) == '\n') --end;
 
-    char* iter = start;
+    s32 iter = start;
     iter = start;
 
-    char** line_locations = malloc(sizeof(char*)*lines+1);
+    s32* line_locations = malloc(sizeof(s32)*lines+1);
     line_locations[0] = start;
 
     for(int i = 1; i < lines; ++i){
-       while(iter <=end && *iter!='\n') ++iter;
+       while(iter <=end && getChar(code, iter)!='\n') ++iter;
        line_locations[i] = ++iter;
     }
     return line_locations;
 }
 
-static inline bool isLineCommented(const char* comment, const char* line){
-    size_t size = strlen(comment);
-    return memcmp(line, comment, size) == 0;
+static inline bool isLineCommented(Code* code, const char* comment, s32 line){
+    for(const char* ptr = comment; *ptr; ptr++)
+        if(getChar(code, line++) != *ptr)
+            return false;
+
+    return true;
 };
 
-static void addCommentToLine(Code* code, char* line, size_t size, const char* comment){
+static void addCommentToLine(Code* code, s32 line, size_t size, const char* comment){
 
-    const char* end = line + getLineSize(line);
+    s32 end = line + getLineSize(code, line);
 
-    while((*line == ' ' || *line == '\t') && line < end) line++;
+    while((getChar(code, line) == ' ' || getChar(code, line) == '\t') && line < end) line++;
 
-    if(!isLineCommented(comment, line))
+    if(!isLineCommented(code, comment, line))
     {
-        if (strlen(code->src) + size >= MAX_CODE)
+        if (code->text.size + size >= MAX_CODE)
             return;
 
         insertCode(code, line, comment);
@@ -1969,9 +2270,11 @@ static void addCommentToLine(Code* code, char* line, size_t size, const char* co
 
         if(code->cursor.position > line + size)
             code->cursor.position -= size;
+
+        code->cursor.position = MIN(code->cursor.position, code->text.size);
     }
 
-    code->cursor.selection = NULL;
+    code->cursor.selection = -1;
 
     parseSyntaxColor(code);
 }
@@ -1981,27 +2284,27 @@ static void sexpify(Code* code)
     if (!shouldUseStructuredEdit(code))
         return;
 
-    char* pos = code->cursor.position;
-    char* start = NULL;
-    char* end = NULL;
-    char* sel = code->cursor.selection;
-    if (sel)
+    s32 pos = code->cursor.position;
+    s32 start = -1;
+    s32 end = -1;
+    s32 sel = code->cursor.selection;
+    if (sel >= 0)
     {
         start = sel<pos ? sel : pos;
         end = sel<pos ? pos : sel;
     }
-    else if (isopenparen_(code, *pos))
+    else if (isopenparen_(code, getChar(code, pos)))
     {
         start = pos;
         end = rightSexp(code, pos+1);
     }
-    else if (isalnum_(code, *pos))
+    else if (isalnum_(code, getChar(code, pos)))
     {
         start = leftPos(code, pos, isalnum_);
         end = rightPos(code, pos, isalnum_);
     }
 
-    if (start == NULL || end == NULL)
+    if (start < 0 || end < 0)
         return;
 
     insertCode(code, start, (const char[]){'(', '\0'});
@@ -2018,35 +2321,34 @@ static void extirpSExp(Code* code)
     if (!shouldUseStructuredEdit(code))
         return;
 
-    const char* start = code->src;
-    char* pos = code->cursor.position;
-    const char* end = code->src + strlen(code->src);
+    s32 pos = code->cursor.position;
+    s32 end = code->text.size;
 
-    char* sexp_start = NULL;
-    char* sexp_end = NULL;
+    s32 sexp_start = -1;
+    s32 sexp_end = -1;
 
-    if(pos > start)
+    if(pos > 0)
     {
-        if (isopenparen_(code, *pos))
+        if (isopenparen_(code, getChar(code, pos)))
         {
             sexp_start = pos;
             sexp_end = rightSexp(code, pos+1);
         }
-        if (iscloseparen_(code, *pos))
+        if (iscloseparen_(code, getChar(code, pos)))
         {
             sexp_start = leftSexp(code, pos-1);
             sexp_end = pos;
         }
-        if (isalnum_(code, *pos))
+        if (isalnum_(code, getChar(code, pos)))
         {
             sexp_start = leftPos(code, pos, isalnum_);
             sexp_end = rightPos(code, pos, isalnum_)-1;
         }
-        if (sexp_start != NULL && sexp_end != NULL)
+        if (sexp_start >= 0 && sexp_end >= 0)
         {
-            char* sexp_outer_start = leftSexp(code, sexp_start-1);
-            char* sexp_outer_end = rightSexp(code, sexp_end+1);
-            if (sexp_start > start && sexp_outer_start > start && sexp_end < end && sexp_outer_end < end)
+            s32 sexp_outer_start = leftSexp(code, sexp_start-1);
+            s32 sexp_outer_end = rightSexp(code, sexp_end+1);
+            if (sexp_start > 0 && sexp_outer_start > 0 && sexp_end < end && sexp_outer_end < end)
             {
                 deleteCode(code, sexp_end+1, sexp_outer_end+1);
                 deleteCode(code, sexp_outer_start, sexp_start);
@@ -2061,8 +2363,8 @@ static void extirpSExp(Code* code)
 
 static void toggleMark(Code* code)
 {
-    if (code->cursor.selection)
-        code->cursor.selection = NULL;
+    if (code->cursor.selection >= 0)
+        code->cursor.selection = -1;
     else
         code->cursor.selection = code->cursor.position;
 
@@ -2075,26 +2377,26 @@ static void commentLine(Code* code)
     const char* comment = tic_get_script(code->tic)->singleComment;
     size_t size = strlen(comment);
 
-    if(code->cursor.selection){
+    if(code->cursor.selection >= 0){
         int selectionLines = getNumberOfLines(code);
-        char** lines = getLines(code, selectionLines);
+        s32* lines = getLines(code, selectionLines);
 
         int comment_cursor = 0;
 
         for (int i = 0; i<selectionLines; ++i){
 
-            char* first = lines[i];
-            while(*first == ' ' || *first == '\t') ++first;
-            bool lineIsComment = isLineCommented(comment, first);
+            s32 first = lines[i];
+            while(getChar(code, first) == ' ' || getChar(code, first) == '\t') ++first;
+            bool lineIsComment = isLineCommented(code, comment, first);
 
             if(i < selectionLines - 1) {
-                if(*first != '\n' && lineIsComment) --comment_cursor;
-                else if (*first !='\n') ++comment_cursor;
+                if(getChar(code, first) != '\n' && lineIsComment) --comment_cursor;
+                else if (getChar(code, first) !='\n') ++comment_cursor;
 
                 lines[i + 1] += (size * comment_cursor);
             }
 
-            if(*first !='\n') {
+            if(getChar(code, first) !='\n') {
             addCommentToLine(code, lines[i], size, comment);
             }
         }
@@ -2109,12 +2411,22 @@ static void commentLine(Code* code)
 
 static void dupLine(Code* code)
 {
-    char *start = getLine(code);
-    if(*start)
+    s32 start = getLine(code);
+    if(getChar(code, start))
     {
-        s32 size = getLineSize(start) + 1;
+        s32 size = getLineSize(code, start) + 1;
+
+        // the line is copied out, the insert moves it,
+        // the last line gets a line break instead of the terminator
+        char* line = malloc(size + 1);
 
-        insertCodeSize(code, start, start, size);
+        if(line)
+        {
+            copyText(code, line, start, start + size - 1);
+            line[size - 1] = '\n';
+            insertCodeSize(code, start, line, size);
+            free(line);
+        }
 
         code->cursor.position += size;
 
@@ -2124,39 +2436,35 @@ static void dupLine(Code* code)
     }
 }
 
-static bool goPrevBookmark(Code* code, char* ptr)
+static bool goPrevBookmark(Code* code, s32 pos)
 {
-    const CodeState* state = getState(code, ptr);
-    while(ptr >= code->src)
+    while(pos >= 0)
     {
-        if(state->bookmark)
+        if(getState(code, pos)->bookmark)
         {
-            updateCursorPosition(code, ptr);
+            updateCursorPosition(code, pos);
             centerScroll(code);
             return true;
         }
 
-        ptr--;
-        state--;
+        pos--;
     }
 
     return false;
 }
 
-static bool goNextBookmark(Code* code, char* ptr)
+static bool goNextBookmark(Code* code, s32 pos)
 {
-    const CodeState* state = getState(code, ptr);
-    while(*ptr)
+    while(getChar(code, pos))
     {
-        if(state->bookmark)
+        if(getState(code, pos)->bookmark)
         {
-            updateCursorPosition(code, ptr);
+            updateCursorPosition(code, pos);
             centerScroll(code);
             return true;
         }
 
-        ptr++;
-        state++;
+        pos++;
     }
 
     return false;
@@ -2189,45 +2497,43 @@ static bool clipboardHasNewline()
     return found;
 }
 
-static char* upStrStr(const char* start, const char* from, const char* substr)
+// the search functions return the position of the string or -1
+static s32 upStrStr(Code* code, s32 from, const char* substr)
 {
-    const char* ptr = from-1;
+    const char* text = getText(code);
     size_t len = strlen(substr);
 
     if(len > 0)
-    {
-        while(ptr >= start)
-        {
-            if(memcmp(ptr, substr, len) == 0)
-                return (char*)ptr;
-
-            ptr--;
-        }
-    }
+        for(s32 pos = from - 1; pos >= 0; pos--)
+            if(strncmp(text + pos, substr, len) == 0)
+                return pos;
 
-    return NULL;
+    return -1;
 }
 
-static char* downStrStr(const char* start, const char* from, const char* substr)
+static s32 downStrStr(Code* code, s32 from, const char* substr)
 {
-    return strstr(from, substr);
+    const char* text = getText(code);
+    const char* ptr = strstr(text + from, substr);
+
+    return ptr ? (s32)(ptr - text) : -1;
 }
 
 
 static void seekEmptyLineForward(Code* code) {
-    char* pos = code->cursor.position;
+    s32 pos = code->cursor.position;
 
     //goto state machine, one of the few ways to use goto well
 start:
-    if (*pos == '\0') goto end;
-    else if (*pos == '\n') { pos++; goto check; }
+    if (getChar(code, pos) == '\0') goto end;
+    else if (getChar(code, pos) == '\n') { pos++; goto check; }
     else { pos++; goto start; }
 
 check:
-    if (*pos == '\0') goto end;
-    else if (*pos == '\t') { pos++; goto check; }
-    else if (*pos == ' ') { pos++; goto check; }
-    else if (*pos == '\n') goto end;
+    if (getChar(code, pos) == '\0') goto end;
+    else if (getChar(code, pos) == '\t') { pos++; goto check; }
+    else if (getChar(code, pos) == ' ') { pos++; goto check; }
+    else if (getChar(code, pos) == '\n') goto end;
     else goto start;
 
 end:
@@ -2238,22 +2544,22 @@ end:
 }
 
 static void seekEmptyLineBackward(Code* code) {
-    char* pos = code->cursor.position;
+    s32 pos = code->cursor.position;
 
-    if (pos == code->src) return;
+    if (pos == 0) return;
     else pos--; //need to start one behind so we don't match the one we are on
 
     //goto state machine, one of the few ways to use goto well
 start:
-    if (pos == code->src) goto end;
-    else if (*pos == '\n') { pos--; goto check; }
+    if (pos == 0) goto end;
+    else if (getChar(code, pos) == '\n') { pos--; goto check; }
     else { pos--; goto start; }
 
 check:
-    if (pos == code->src) goto end;
-    else if (*pos == '\t') { pos--; goto check; }
-    else if (*pos == ' ') { pos--; goto check; }
-    else if (*pos == '\n') { pos++; goto end; }
+    if (pos == 0) goto end;
+    else if (getChar(code, pos) == '\t') { pos--; goto check; }
+    else if (getChar(code, pos) == ' ') { pos--; goto check; }
+    else if (getChar(code, pos) == '\n') { pos++; goto end; }
     else goto start;
 
 end:
@@ -2264,15 +2570,15 @@ end:
 
 static void seekForward(Code* code, char sought)
 {
-    char* start = code->cursor.position;
+    s32 start = code->cursor.position;
     code->cursor.position++;
     while(
-        *code->cursor.position != sought
-        && *code->cursor.position != '\n'
-        && *code->cursor.position != '\0'
+        getChar(code, code->cursor.position) != sought
+        && getChar(code, code->cursor.position) != '\n'
+        && getChar(code, code->cursor.position) != '\0'
     )
         code->cursor.position++;
-    if (*code->cursor.position == '\n' || *code->cursor.position == '\0')
+    if (getChar(code, code->cursor.position) == '\n' || getChar(code, code->cursor.position) == '\0')
         code->cursor.position = start;
 
     updateColumn(code);
@@ -2281,16 +2587,16 @@ static void seekForward(Code* code, char sought)
 }
 static void seekBackward(Code* code, char sought)
 {
-    char* start = code->cursor.position;
+    s32 start = code->cursor.position;
     code->cursor.position--;
     while(
-        code->cursor.position > code->src
-        && *code->cursor.position != sought
-        && *code->cursor.position != '\n'
+        code->cursor.position > 0
+        && getChar(code, code->cursor.position) != sought
+        && getChar(code, code->cursor.position) != '\n'
     )
         code->cursor.position--;
 
-    if (code->cursor.position <= code->src || *code->cursor.position == '\n')
+    if (code->cursor.position <= 0 || getChar(code, code->cursor.position) == '\n')
         code->cursor.position = start;
 
     updateColumn(code);
@@ -2300,15 +2606,15 @@ static void seekBackward(Code* code, char sought)
 static void findNextPopupText(Code* code) {
     if (*code->popup.text)
     {
-        char* pos = downStrStr(code->src, code->cursor.position, code->popup.text);
+        s32 pos = downStrStr(code, code->cursor.position, code->popup.text);
         if (pos == code->cursor.position)
         {
             pos += strlen(code->popup.text);
-            pos = downStrStr(code->src, pos, code->popup.text);
+            pos = downStrStr(code, pos, code->popup.text);
         }
-        if (pos == NULL)
-            pos = downStrStr(code->src, code->src, code->popup.text);
-        if (pos != NULL)
+        if (pos < 0)
+            pos = downStrStr(code, 0, code->popup.text);
+        if (pos >= 0)
         {
             code->cursor.position = pos;
             updateColumn(code);
@@ -2351,7 +2657,7 @@ static bool processViPosition(Code* code, bool ctrl, bool alt, bool shift)
     else if (shift && keyWasPressed(code->studio, tic_key_6))
     {
         goHome(code);
-        while (*code->cursor.position == ' ' || *code->cursor.position == '\t')
+        while (getChar(code, code->cursor.position) == ' ' || getChar(code, code->cursor.position) == '\t')
             code->cursor.position++;
     }
 
@@ -2369,10 +2675,10 @@ static bool processViPosition(Code* code, bool ctrl, bool alt, bool shift)
 
     else if (shift && keyWasPressed(code->studio, tic_key_5))
     {
-        const char* pos = findMatchedDelim(code, code->cursor.position);
-        if (pos != NULL)
+        s32 pos = findMatchedDelim(code, code->cursor.position);
+        if (pos >= 0)
         {
-            code->cursor.position = (char*) pos;
+            code->cursor.position = pos;
             updateColumn(code);
             updateEditor(code);
         }
@@ -2385,10 +2691,10 @@ static bool processViPosition(Code* code, bool ctrl, bool alt, bool shift)
         setStudioViMode(code->studio, VI_SEEK_BACK);
 
     else if(clear && keyWasPressed(code->studio, tic_key_semicolon))
-        seekForward(code, *code->cursor.position);
+        seekForward(code, getChar(code, code->cursor.position));
 
     else if(shift && keyWasPressed(code->studio, tic_key_semicolon))
-        seekBackward(code, *code->cursor.position);
+        seekBackward(code, getChar(code, code->cursor.position));
 
     else processed = false;
 
@@ -2404,20 +2710,20 @@ static void processViGoto(Code* code, s32 initial)
     updateGotoCode(code);
 }
 
-static char* findStringStart(Code* code, char* pos) {
-    char sentinel = *pos;
+static s32 findStringStart(Code* code, s32 pos) {
+    char sentinel = getChar(code, pos);
 
-    char* target = pos; //we will scan to the given position
+    s32 target = pos; //we will scan to the given position
     pos = getLineByPos(code, pos); //from the beginning of the line
-    char* start = NULL;
+    s32 start = -1;
 
     //goto state machine!
 start:
     if(pos == target) goto end;
-    else if(*pos == '\\') { pos++; goto escape; }
-    else if (*pos == sentinel)
+    else if(getChar(code, pos) == '\\') { pos++; goto escape; }
+    else if (getChar(code, pos) == sentinel)
     {
-        start=start?NULL:pos;
+        start=start>=0?-1:pos;
         pos++;
         goto start;
     }
@@ -2429,37 +2735,41 @@ end:
     return start;
 }
 
-static char* findStringEnd(char* pos) {
-    char sentinel = *pos; //can handle single or double quotes
-                         //or anything else I guess
-    if (*pos == '\0') goto end;
+static s32 findStringEnd(Code* code, s32 pos) {
+    char sentinel = getChar(code, pos); //can handle single or double quotes
+                                        //or anything else I guess
+    if (getChar(code, pos) == '\0') goto end;
     else pos++; //move past the sentinel so we don't immediately detect the end
 
     //goto state machine!
 start:
-    if(*pos == '\0' || *pos == '\n' || *pos == sentinel) goto end;
-    else if(*pos == '\\') { pos++; goto escape; }
+    if(getChar(code, pos) == '\0' || getChar(code, pos) == '\n' || getChar(code, pos) == sentinel) goto end;
+    else if(getChar(code, pos) == '\\') { pos++; goto escape; }
     else { pos++; goto start; }
 escape :
-    if (*pos == '\0' || *pos == '\n') goto end;
+    if (getChar(code, pos) == '\0' || getChar(code, pos) == '\n') goto end;
     else { pos++; goto start; }
 end:
     return pos;
 }
 
 
-//pass in pointer to beginnign of word and its length
-//so you can just use the word in src
-static char* findFunctionDefinition(Code* code, char* name, size_t length) {
-    char* result = NULL;
+//pass in the position of the word and its length,
+//returns the position of the definition or -1
+static s32 findFunctionDefinition(Code* code, s32 name, size_t length) {
+    s32 result = -1;
 
     tic_mem* tic = code->tic;
     const tic_script* config = tic_get_script(tic);
 
     if(config->getOutline)
     {
+        // the outline points into the text, it has to stay in place while the items are checked
+        parseSyntax(code, code->text.size);
+        const char* text = getText(code);
+
         s32 osize = 0;
-        const tic_outline_item* items = config->getOutline(code->src, &osize);
+        const tic_outline_item* items = config->getOutline(text, &osize);
 
         if(items)
         {
@@ -2467,11 +2777,11 @@ static char* findFunctionDefinition(Code* code, char* name, size_t length) {
             {
                 const tic_outline_item* it = items + i;
 
-                if(code->state[it->pos - code->src].syntax == SyntaxType_COMMENT)
+                if(getState(code, (s32)(it->pos - text))->syntax == SyntaxType_COMMENT)
                     continue;
-                if (strncmp(name, it->pos, length) == 0)
+                if (strncmp(text + name, it->pos, length) == 0)
                 {
-                    result = (char*) it->pos;
+                    result = (s32)(it->pos - text);
                     break;
                 }
             }
@@ -2484,41 +2794,41 @@ static char* findFunctionDefinition(Code* code, char* name, size_t length) {
 
 static void processViChange(Code* code) {
     //if on a delimiter change the contents of the delimiter
-    if (matchingDelim(*code->cursor.position))
+    if (matchingDelim(getChar(code, code->cursor.position)))
     {
-        const char* match = findMatchedDelim(code, code->cursor.position);
-        if (match == 0)
+        s32 match = findMatchedDelim(code, code->cursor.position);
+        if (match < 0)
             deleteChar(code);
         else
         {
             if (code->cursor.position > match)
             {
-                char* temp = code->cursor.position;
-                code->cursor.position = (char*) match;
+                s32 temp = code->cursor.position;
+                code->cursor.position = match;
                 match = temp;
             }
-            deleteCode(code, code->cursor.position+1, (char*) match);
+            deleteCode(code, code->cursor.position+1, match);
             code->cursor.position++;
         }
     }
     //if on a quotation seek to change within the quotation
-    else if(*code->cursor.position == '"' || *code->cursor.position == '\'')
+    else if(getChar(code, code->cursor.position) == '"' || getChar(code, code->cursor.position) == '\'')
     {
-        char* start = findStringStart(code, code->cursor.position);
-        if (start == NULL) start = code->cursor.position;
-        char* end = findStringEnd(start);
+        s32 start = findStringStart(code, code->cursor.position);
+        if (start < 0) start = code->cursor.position;
+        s32 end = findStringEnd(code, start);
         start++; //advance one to leave the initial quote alone
         deleteCode(code, start, end);
         code->cursor.position = start;
     }
-    else if(!isalnum_(code, *code->cursor.position))
+    else if(!isalnum_(code, getChar(code, code->cursor.position)))
         deleteChar(code);
     else  //change the word under the cursor
     {
         //only call left word if we are not already on the word border
         if (
-            code->cursor.position > code->src
-            && isalnum_(code, *(code->cursor.position-1))
+            code->cursor.position > 0
+            && isalnum_(code, getChar(code, code->cursor.position-1))
         )
             leftWord(code);
         deleteWord(code);
@@ -2594,7 +2904,7 @@ static void processViKeyboard(Code* code)
     {
         bool processed = true;
 
-        code->cursor.selection = NULL;
+        code->cursor.selection = -1;
 
         if (processViPosition(code, ctrl, alt, shift));
 
@@ -2648,24 +2958,21 @@ static void processViKeyboard(Code* code)
 
         else if(shift && keyWasPressed(code->studio, tic_key_3))
         {
-            char* word_start = leftPos(code, code->cursor.position, isalnum_);
-            char* word_end = rightPos(code, code->cursor.position, isalnum_);
+            s32 word_start = leftPos(code, code->cursor.position, isalnum_);
+            s32 word_end = rightPos(code, code->cursor.position, isalnum_);
             size_t size = word_end - word_start;
             if (size+1 < STUDIO_TEXT_BUFFER_WIDTH)
-            {
-                memcpy(code->popup.text, word_start, size);
-                code->popup.text[size] = 0;
-            }
+                copyText(code, code->popup.text, word_start, word_end);
             findNextPopupText(code);
         }
         else if(shift && keyWasPressed(code->studio, tic_key_n))
         {
             if (*code->popup.text)
             {
-                char* pos = upStrStr(code->src, code->cursor.position, code->popup.text);
-                if (pos == NULL)
-                    pos = upStrStr(code->src, code->src+strlen(code->src), code->popup.text);
-                if (pos != NULL)
+                s32 pos = upStrStr(code, code->cursor.position, code->popup.text);
+                if (pos < 0)
+                    pos = upStrStr(code, code->text.size, code->popup.text);
+                if (pos >= 0)
                 {
                     code->cursor.position = pos;
                     updateColumn(code);
@@ -2675,12 +2982,12 @@ static void processViKeyboard(Code* code)
 
         else if (clear && keyWasPressed(code->studio, tic_key_leftbracket))
         {
-            char* word_start = leftPos(code, code->cursor.position, isalnum_);
-            char* word_end = rightPos(code, code->cursor.position, isalnum_);
+            s32 word_start = leftPos(code, code->cursor.position, isalnum_);
+            s32 word_end = rightPos(code, code->cursor.position, isalnum_);
             size_t size = word_end - word_start;
 
-            char* def = findFunctionDefinition(code, word_start, size);
-            if (def != NULL)
+            s32 def = findFunctionDefinition(code, word_start, size);
+            if (def >= 0)
             {
                 code->cursor.position = def;
                 updateColumn(code);
@@ -2700,7 +3007,7 @@ static void processViKeyboard(Code* code)
             {
                 downLine(code);
                 goHome(code);
-                char* pos = code->cursor.position;
+                s32 pos = code->cursor.position;
                 copyFromClipboard(code, false);
                 code->cursor.position = pos;
             } else copyFromClipboard(code, false);
@@ -2711,7 +3018,7 @@ static void processViKeyboard(Code* code)
             if (clipboardHasNewline())
             {
                 goHome(code);
-                char* pos = code->cursor.position;
+                s32 pos = code->cursor.position;
                 copyFromClipboard(code, false);
                 code->cursor.position = pos;
             } else copyFromClipboard(code, false);
@@ -2739,12 +3046,12 @@ static void processViKeyboard(Code* code)
         else if (clear && keyWasPressed(code->studio, tic_key_comma))
         {
             if(!goPrevBookmark(code, getPrevLineByPos(code, code->cursor.position)))
-                goPrevBookmark(code, code->src + strlen(code->src));
+                goPrevBookmark(code, code->text.size);
         }
         else if (clear && keyWasPressed(code->studio, tic_key_period))
         {
             if(!goNextBookmark(code, getNextLineByPos(code, code->cursor.position)))
-                goNextBookmark(code, code->src);
+                goNextBookmark(code, 0);
         }
 
         else if (clear && keyWasPressed(code->studio, tic_key_z))
@@ -2758,7 +3065,8 @@ static void processViKeyboard(Code* code)
 
         else if (shift && keyWasPressed(code->studio, tic_key_grave))
         {
-            *code->cursor.position = toggleCase(*code->cursor.position);
+            if(code->cursor.position < code->text.size)
+                setChar(code, code->cursor.position, toggleCase(getChar(code, code->cursor.position)));
             history(code);
         }
 
@@ -2781,7 +3089,7 @@ static void processViKeyboard(Code* code)
         else if (shift && keyWasPressed(code->studio, tic_key_c))
         {
             setStudioViMode(code->studio, VI_INSERT);
-            char* start = code->cursor.position;
+            s32 start = code->cursor.position;
             goEnd(code);
             deleteCode(code, start, code->cursor.position);
             code->cursor.position = start;
@@ -2797,7 +3105,7 @@ static void processViKeyboard(Code* code)
         if (processed) updateEditor(code);
     }
     else if (mode == VI_SELECT) {
-        if (code->cursor.selection == NULL)
+        if (code->cursor.selection < 0)
             code->cursor.selection = code->cursor.position;
 
         bool processed = true;
@@ -2831,10 +3139,11 @@ static void processViKeyboard(Code* code)
         } else if (clear && keyWasPressed(code->studio, tic_key_c))
         {
             setStudioViMode(code->studio, VI_INSERT);
-            if (code->cursor.selection != NULL)
-                deleteCode(code, code->cursor.selection, code->cursor.position);
-            code->cursor.position = code->cursor.selection;
-            code->cursor.selection = NULL;
+            if (code->cursor.selection >= 0)
+                deleteCode(code, MIN(code->cursor.selection, code->cursor.position),
+                    MAX(code->cursor.selection, code->cursor.position));
+            code->cursor.position = MIN(code->cursor.selection, code->cursor.position);
+            code->cursor.selection = -1;
         }
 
         else if (shift && keyWasPressed(code->studio, tic_key_comma))
@@ -2856,8 +3165,9 @@ static void processViKeyboard(Code* code)
 
         else if (shift && keyWasPressed(code->studio, tic_key_grave))
         {
-            for(char* i = code->cursor.selection ;i != code->cursor.position; i++)
-                *i = toggleCase(*i);
+            for(s32 i = MIN(code->cursor.selection, code->cursor.position),
+                end = MAX(code->cursor.selection, code->cursor.position); i != end; i++)
+                setChar(code, i, toggleCase(getChar(code, i)));
             history(code);
         }
 
@@ -2877,7 +3187,7 @@ static void processViKeyboard(Code* code)
             if(sym)
             {
                 seekForward(code, sym);
-                if (code->cursor.selection == NULL)
+                if (code->cursor.selection < 0)
                     setStudioViMode(code->studio, VI_NORMAL);
                 else
                     setStudioViMode(code->studio, VI_SELECT);
@@ -2895,7 +3205,7 @@ static void processViKeyboard(Code* code)
             if(sym)
             {
                 seekBackward(code, sym);
-                if (code->cursor.selection == NULL)
+                if (code->cursor.selection < 0)
                     setStudioViMode(code->studio, VI_NORMAL);
                 else
                     setStudioViMode(code->studio, VI_SELECT);
@@ -2951,8 +3261,8 @@ static void processKeyboard(Code* code)
         || keyWasPressed(code->studio, tic_key_pagedown))
     {
         changedSelection = true;
-        if(!shift) code->cursor.selection = NULL;
-        else if(code->cursor.selection == NULL) code->cursor.selection = code->cursor.position;
+        if(!shift) code->cursor.selection = -1;
+        else if(code->cursor.selection < 0) code->cursor.selection = code->cursor.position;
         else changedSelection = false;
     }
 
@@ -2971,6 +3281,9 @@ static void processKeyboard(Code* code)
         {
             for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
                 s->bookmark = 0;
+
+            markState(code, 0, TIC_CODE_SIZE);
+            code->historyEdited = true;
         }
         else if(ctrl)
         {
@@ -2979,12 +3292,12 @@ static void processKeyboard(Code* code)
         else if(shift)
         {
             if(!goPrevBookmark(code, getPrevLineByPos(code, code->cursor.position)))
-                goPrevBookmark(code, code->src + strlen(code->src));
+                goPrevBookmark(code, code->text.size);
         }
         else
         {
             if(!goNextBookmark(code, getNextLineByPos(code, code->cursor.position)))
-                goNextBookmark(code, code->src);
+                goNextBookmark(code, 0);
         }
     }
     else if(ctrl || alt)
@@ -3139,7 +3452,7 @@ static void processMouse(Code* code)
                     s32 x = (mx - rect.x) / getFontWidth(code);
                     s32 y = (my - rect.y) / STUDIO_TEXT_HEIGHT;
 
-                    char* position = code->cursor.position;
+                    s32 position = code->cursor.position;
                     setCursorPosition(code, x + code->scroll.x, y + code->scroll.y);
 
                     if(tic_api_key(tic, tic_key_shift))
@@ -3147,7 +3460,7 @@ static void processMouse(Code* code)
                         code->cursor.selection = code->cursor.position;
                         code->cursor.position = position;
                     }
-                    else if(!code->cursor.mouseDownPosition)
+                    else if(code->cursor.mouseDownPosition < 0)
                     {
                         code->cursor.selection = code->cursor.position;
                         code->cursor.mouseDownPosition = code->cursor.position;
@@ -3156,9 +3469,9 @@ static void processMouse(Code* code)
                 else
                 {
                     if(code->cursor.mouseDownPosition == code->cursor.position)
-                        code->cursor.selection = NULL;
+                        code->cursor.selection = -1;
 
-                    code->cursor.mouseDownPosition = NULL;
+                    code->cursor.mouseDownPosition = -1;
                 }
             }
         }
@@ -3234,9 +3547,9 @@ static void drawPopupBar(Code* code, const char* title)
     drawCursor(code, TextX+(s32)(strlen(title) + strlen(code->popup.text)) * getFontWidth(code), textY, ' ');
 }
 
-static void updateFindCode(Code* code, char* pos)
+static void updateFindCode(Code* code, s32 pos)
 {
-    if(pos)
+    if(pos >= 0)
     {
         code->cursor.position = pos;
         code->cursor.selection = pos + strlen(code->popup.text);
@@ -3258,18 +3571,19 @@ static void textFindTick(Code* code)
 		if(*code->popup.text)
 		{
 			bool reverse = keyWasPressed(code->studio, tic_key_up) || keyWasPressed(code->studio, tic_key_left);
-			char* (*func)(const char*, const char*, const char*) = reverse ? upStrStr : downStrStr;
-			char* from = reverse ? MIN(code->cursor.position, code->cursor.selection) : MAX(code->cursor.position, code->cursor.selection);
-			char* pos = func(code->src, from, code->popup.text);
-			if (!pos && !reverse)
+			s32 (*func)(Code*, s32, const char*) = reverse ? upStrStr : downStrStr;
+			s32 sel = code->cursor.selection >= 0 ? code->cursor.selection : code->cursor.position;
+			s32 from = reverse ? MIN(code->cursor.position, sel) : MAX(code->cursor.position, sel);
+			s32 pos = func(code, from, code->popup.text);
+			if (pos < 0 && !reverse)
 			{
 				// If not found in forward search, try from the beginning
-				pos = func(code->src, code->src, code->popup.text);
+				pos = func(code, 0, code->popup.text);
 			}
-			else if (!pos && reverse)
+			else if (pos < 0 && reverse)
 			{
 				// If not found in reverse search, try from the end
-				pos = func(code->src, code->src + strlen(code->src), code->popup.text);
+				pos = func(code, code->text.size, code->popup.text);
 			}				
 			updateFindCode(code, pos);
 		}
@@ -3279,7 +3593,7 @@ static void textFindTick(Code* code)
         if(*code->popup.text)
         {
             code->popup.text[strlen(code->popup.text)-1] = '\0';
-            updateFindCode(code, strstr(code->src, code->popup.text));
+            updateFindCode(code, downStrStr(code, 0, code->popup.text));
         }
     }
 
@@ -3292,11 +3606,11 @@ static void textFindTick(Code* code)
             strcat(code->popup.text, str);
 
             // Start searching after the current cursor position
-            char* pos = strstr(code->cursor.position, code->popup.text);
-            if (!pos) 
+            s32 pos = downStrStr(code, code->cursor.position, code->popup.text);
+            if (pos < 0)
             {
                 // If no match, search from the beginning
-                pos = strstr(code->src, code->popup.text);
+                pos = downStrStr(code, 0, code->popup.text);
             }
 
             updateFindCode(code, pos);
@@ -3326,21 +3640,20 @@ static void textReplaceTick(Code* code)
             //execute the replace
 
             //if we have a selection only replace within the selection
-            char* start = code->src;
-            if (code->cursor.selection != NULL)
+            s32 start = 0;
+            if (code->cursor.selection >= 0)
                 start = code->cursor.selection;
 
-            char* pos = downStrStr(start, start, code->popup.text);
-            size_t src_length = strlen(code->src);
-            while(pos != NULL)
+            s32 pos = downStrStr(code, start, code->popup.text);
+            while(pos >= 0)
             {
                 deleteCode(code, pos, pos+strlen(code->popup.text));
                 insertCode(code, pos, code->popup.offset);
-                pos += strlen(code->popup.offset);
-                if (pos - code->src > src_length) pos = code->src + src_length;
+                // the search goes on after the replacement, so it can't find the text it inserted
+                pos = MIN(pos + (s32)strlen(code->popup.offset), code->text.size);
 
-                pos = downStrStr(code->src, pos, code->popup.text);
-                if (code->cursor.selection != NULL && pos > code->cursor.position)
+                pos = downStrStr(code, pos, code->popup.text);
+                if (code->cursor.selection >= 0 && pos > code->cursor.position)
                     break;
             }
             history(code);
@@ -3391,7 +3704,7 @@ static void updateGotoCode(Code* code)
 
     if(line > count) line = count;
 
-    code->cursor.selection = NULL;
+    code->cursor.selection = -1;
     setCursorPosition(code, 0, line);
 
     code->jump.line = line;
@@ -3454,7 +3767,7 @@ static void drawSidebarBar(Code* code, s32 x, s32 y)
         mx /= STUDIO_TEXT_HEIGHT;
         mx += code->sidebar.scroll;
 
-        if(mx >= 0 && mx < code->sidebar.size && code->sidebar.items[mx].pos)
+        if(mx >= 0 && mx < code->sidebar.size)
         {
             setCursor(code->studio, tic_cursor_hand);
 
@@ -3481,16 +3794,18 @@ static void drawSidebarBar(Code* code, s32 x, s32 y)
 		tic_api_rect(code->tic, rect.x - 1, rect.y + (code->sidebar.index - code->sidebar.scroll) * STUDIO_TEXT_HEIGHT,
 			rect.w + 1, TIC_FONT_HEIGHT + 2, tic_color_red);
 
-		for(const tic_outline_item* ptr = code->sidebar.items, *end = ptr + code->sidebar.size;
-			ptr != end; ptr++, y += STUDIO_TEXT_HEIGHT)
+		for(s32 i = 0; i < code->sidebar.size; i++, y += STUDIO_TEXT_HEIGHT)
 		{
+			const s32 pos = code->sidebar.items[i].pos;
+			const s32 end = pos + code->sidebar.items[i].size;
+
 			// find the first non-space character
-			const char* trimmed = ptr->pos;
-			while (*trimmed && isspace(*trimmed))
+			s32 trimmed = pos;
+			while (trimmed < end && isspace(getChar(code, trimmed)))
 				trimmed++;
 
 			// calculate the new size after trimming
-			size_t trimmed_size = ptr->size - (trimmed - ptr->pos);
+			s32 trimmed_size = end - trimmed;
 
 			drawFilterMatch(code, x, y, trimmed, trimmed_size, filter);
 		}
@@ -3772,9 +4087,13 @@ static void escape(Code* code)
     default:
         code->anim.movie = resetMovie(&code->anim.hide);
 
-        code->cursor.position = code->popup.prevPos;
-        code->cursor.selection = code->popup.prevSel;
-        code->popup.prevSel = code->popup.prevPos = NULL;
+        // the popup can be escaped again while it's hiding
+        if(code->popup.prevPos >= 0)
+        {
+            code->cursor.position = code->popup.prevPos;
+            code->cursor.selection = code->popup.prevSel;
+            code->popup.prevSel = code->popup.prevPos = -1;
+        }
 
         updateEditor(code);
     }
@@ -3817,6 +4136,8 @@ void initCode(Code* code, Studio* studio)
 {
     bool firstLoad = code->state == NULL;
     FREE(code->state);
+    FREE(code->text.data);
+    FREE(code->text.index.items);
     freeAnim(code);
 
     if(code->history) history_delete(code->history);
@@ -3827,20 +4148,24 @@ void initCode(Code* code, Studio* studio)
     {
         .studio = studio,
         .tic = getMemory(studio),
-        .src = src->data,
         .tick = tick,
         .escape = escape,
-        .cursor = {{src->data, NULL, 0}, NULL, 0},
+        .cursor = {{0, -1, 0}, -1, 0},
         .scroll = {0, 0, {0, 0}, false},
         .state = calloc(TIC_CODE_SIZE, sizeof(CodeState)),
+        .text =
+        {
+            .data = calloc(TIC_CODE_SIZE, sizeof(char)),
+            .index = {.items = calloc(TIC_CODE_SIZE, sizeof(s32))},
+        },
         .tickCounter = 0,
         .history = NULL,
         .mode = TEXT_EDIT_MODE,
         .jump = {.line = -1},
         .popup =
         {
-            .prevPos = NULL,
-            .prevSel = NULL,
+            .prevPos = -1,
+            .prevSel = -1,
         },
         .sidebar =
         {
@@ -3849,7 +4174,7 @@ void initCode(Code* code, Studio* studio)
             .index = 0,
             .scroll = 0,
         },
-        .matchedDelim = NULL,
+        .matchedDelim = -1,
         .altFont = firstLoad ? getConfig(studio)->theme.code.altFont : code->altFont,
         .shadowText = getConfig(studio)->theme.code.shadow,
         .anim =
@@ -3874,8 +4199,12 @@ void initCode(Code* code, Studio* studio)
 
     code->anim.movie = resetMovie(&code->anim.idle);
 
+    code->text.size = code->text.gap = (s32)strnlen(src->data, TIC_CODE_SIZE - 1);
+    memcpy(code->text.data, src->data, code->text.size);
+
     packState(code);
     code->history = history_create(code->state, sizeof(CodeState) * TIC_CODE_SIZE);
+    history_budget(code->history, getConfig(studio)->undoBudget * 1024 * 1024);
 
     update(code);
 }
@@ -3886,19 +4215,24 @@ void freeCode(Code* code)
 
     history_delete(code->history);
     free(code->state);
+    free(code->text.data);
+    free(code->text.index.items);
     free(code);
 }
 
 void trimWhitespace(Code* code)
 {
-    char* data = code->src;
-    char* limit = data + MAX_CODE;
+    char* data = getText(code);
+    char* limit = data + MIN(MAX_CODE, TIC_CODE_SIZE - 1);
+
+    // the states stay in their cells, the terminator one joins them for the trim
+    code->state[code->text.size] = code->state[TIC_CODE_SIZE - 1];
 
     char* src = data;
     char* dst = data;
 
-    char* cursor = code->cursor.position;
-    char* select = code->cursor.selection;
+    s32 cursor = code->cursor.position;
+    s32 select = code->cursor.selection;
 
     while(src < limit && *src != '\0')
     {
@@ -3925,8 +4259,9 @@ void trimWhitespace(Code* code)
         }
 
         // Move the cursor back by the amount of trimmed spaces before it.
-        if(cursor > trim) code->cursor.position -= (cursor < end ? cursor : end) - trim;
-        if(select > trim) code->cursor.selection -= (select < end ? select : end) - trim;
+        s32 trimPos = (s32)(trim - data), endPos = (s32)(end - data);
+        if(cursor > trimPos) code->cursor.position -= MIN(cursor, endPos) - trimPos;
+        if(select > trimPos) code->cursor.selection -= MIN(select, endPos) - trimPos;
 
         // Go to the next line or exit the loop.
         src = end;
@@ -3935,14 +4270,47 @@ void trimWhitespace(Code* code)
     }
 
     // Terminate the string after the trailing newline.
-    while(dst[-1] == '\n') --dst;
+    while(dst > data && dst[-1] == '\n') --dst;
     if(dst < limit) ++dst;
     if(dst < limit) *dst = '\0';
 
+    // the gap stays at the end, behind the trimmed text
+    code->text.size = code->text.gap = (s32)strlen(data);
+    code->state[TIC_CODE_SIZE - 1] = code->state[code->text.size];
+    memset(data + code->text.size, 0, TIC_CODE_SIZE - code->text.size);
+    memset(code->state + code->text.size, 0, (TIC_CODE_SIZE - 1 - code->text.size) * sizeof(CodeState));
+
     // Move the cursor back if it was on one of the trimmed newlines.
-    if(code->cursor.position > dst) code->cursor.position = dst;
-    if(code->cursor.selection > dst) code->cursor.selection = dst;
+    if(code->cursor.position > code->text.size) code->cursor.position = code->text.size;
+    clampPositions(code);
+
+    packState(code);
+    markState(code, 0, TIC_CODE_SIZE);
+    code->historyEdited = true;
 
     history(code);
     update(code);
 }
+
+void codeSave(Code* code)
+{
+    memcpy(getMemory(code->studio)->cart.code.data, getText(code), TIC_CODE_SIZE);
+}
+
+void codeLoad(Code* code)
+{
+    const char* data = getMemory(code->studio)->cart.code.data;
+
+    if(strncmp(getText(code), data, TIC_CODE_SIZE) != 0)
+    {
+        // the cart was changed outside of the editor, the change can be undone
+        deleteCode(code, 0, code->text.size);
+        insertCodeSize(code, 0, data, (s32)strnlen(data, TIC_CODE_SIZE - 1));
+
+        code->cursor.position = MIN(code->cursor.position, code->text.size);
+        code->cursor.selection = MIN(code->cursor.selection, code->text.size);
+
+        history(code);
+        update(code);
+    }
+}
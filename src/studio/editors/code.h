@@ -31,18 +31,17 @@ struct Code
     Studio* studio;
     tic_mem* tic;
 
-    char* src;
-
+    // positions are offsets in the text, -1 if none
     struct
     {
         struct
         {
-            char* position;
-            char* selection;
+            s32 position;
+            s32 selection;
             s32 column;
         };
 
-        char* mouseDownPosition;
+        s32 mouseDownPosition;
         s32 delay;
     } cursor;
 
@@ -64,12 +63,35 @@ struct Code
             u8 syntax:3;
             u8 bookmark:1;
             u8 cursor:1;
-            u8 temp:3;
+            u8 lexer:3;
         };
 
         char sym;
     }* state;
 
+    struct
+    {
+        // the text and the states have a gap at the last edit, see getOffset()
+        char* data;
+        s32 gap;
+
+        s32 size;
+        s32 lines;
+
+        // offsets of the line starts in a gap buffer, see getLineStart()
+        struct
+        {
+            s32* items;
+            s32 gap;
+        } index;
+    } text;
+
+    struct
+    {
+        s32 parsed;
+        u8 mode;
+    } syntax;
+
     struct
     {
         char line[STUDIO_TEXT_BUFFER_WIDTH];
@@ -80,6 +102,10 @@ struct Code
     u32 tickCounter;
 
     struct History* history;
+    // cursor position packed in the states for the history, -1 if none
+    s32 historyCursor;
+    // the text or bookmarks changed since the last history entry, moving the gap alone doesn't count
+    bool historyEdited;
 
     enum
     {
@@ -97,8 +123,8 @@ struct Code
         char text[STUDIO_TEXT_BUFFER_WIDTH - sizeof "FIND:"];
         char* offset;
 
-        char* prevPos;
-        char* prevSel;
+        s32 prevPos;
+        s32 prevSel;
     } popup;
 
     struct
@@ -108,14 +134,18 @@ struct Code
 
     struct
     {
-        tic_outline_item* items;
+        struct
+        {
+            s32 pos;
+            s32 size;
+        }* items;
 
         s32 size;
         s32 index;
         s32 scroll;
     } sidebar;
 
-    const char* matchedDelim;
+    s32 matchedDelim;
     bool altFont;
     bool shadowText;
 
@@ -143,4 +173,8 @@ void freeCode(Code*);
 void codeGetPos(Code*, s32* x, s32* y);
 void codeSetPos(Code*, s32 x, s32 y);
 
+// the editor keeps its own copy of the code, these sync it with the cart
+void codeSave(Code*);
+void codeLoad(Code*);
+
 void trimWhitespace(Code*);
@@ -52,6 +52,12 @@
 #include <emscripten.h>
 #endif
 
+#if !defined(__TIC_WINDOWS__) && !defined(BAREMETALPI) && !defined(__EMSCRIPTEN__) && !defined(_3DS)
+#define FS_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
 #if defined(__TIC_WINDOWS__)
 #define SLASH_SYMBOL ('\\')
 #else
@@ -686,6 +692,45 @@ void* fs_read(const char* path, s32* size)
 #endif
 }
 
+void* fs_map(const char* path, s32* size)
+{
+#if defined(FS_MMAP)
+    void* data = NULL;
+    s32 fd = open(path, O_RDONLY);
+
+    if(fd >= 0)
+    {
+        struct stat s;
+
+        if(fstat(fd, &s) == 0 && s.st_size > 0 && s.st_size <= INT32_MAX)
+        {
+            data = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(data == MAP_FAILED)
+                data = NULL;
+            else
+                *size = (s32)s.st_size;
+        }
+
+        // the mapping stays valid after the file is closed
+        close(fd);
+    }
+
+    return data;
+#else
+    return fs_read(path, size);
+#endif
+}
+
+void fs_unmap(void* data, s32 size)
+{
+#if defined(FS_MMAP)
+    munmap(data, size);
+#else
+    free(data);
+#endif
+}
+
 bool fs_exists(const char* name)
 {
 #if defined(BAREMETALPI)
@@ -732,6 +777,30 @@ u64 fs_date(const char* path)
 #endif
 }
 
+u64 fs_size(const char* path)
+{
+#if defined(BAREMETALPI)
+    dbg("fs_size %s\n", path);
+    FILINFO s;
+
+    FRESULT res = f_stat(path, &s);
+    return res == FR_OK ? s.fsize : 0;
+#else
+    struct tic_stat_struct s;
+
+    const FsString* pathString = utf8ToString(path);
+    s32 ret = tic_stat(pathString, &s);
+    freeString(pathString);
+
+    if(ret == 0 && S_ISREG(s.st_mode))
+    {
+        return s.st_size;
+    }
+
+    return 0;
+#endif
+}
+
 bool tic_fs_save(tic_fs* fs, const char* name, const void* data, s32 size, bool overwrite)
 {
     if(!overwrite)
@@ -899,6 +968,15 @@ void* tic_fs_load(tic_fs* fs, const char* name, s32* size)
 #endif
 }
 
+void* tic_fs_map(tic_fs* fs, const char* name, s32* size)
+{
+#if defined(FS_MMAP)
+    return fs_map(tic_fs_path(fs, name), size);
+#else
+    return tic_fs_load(fs, name, size);
+#endif
+}
+
 void* tic_fs_loadroot(tic_fs* fs, const char* name, s32* size)
 {
     return fs_read(tic_fs_pathroot(fs, name), size);
@@ -46,6 +46,7 @@ bool    tic_fs_save         (tic_fs* fs, const char* name, const void* data, s32
 bool    tic_fs_saveroot     (tic_fs* fs, const char* name, const void* data, s32 size, bool overwrite);
 void*   tic_fs_load         (tic_fs* fs, const char* name, s32* size);
 void*   tic_fs_loadroot     (tic_fs* fs, const char* name, s32* size);
+void*   tic_fs_map          (tic_fs* fs, const char* name, s32* size);
 bool    tic_fs_makedir      (tic_fs* fs, const char* name);
 bool    tic_fs_exists       (tic_fs* fs, const char* name);
 void    tic_fs_openfolder   (tic_fs* fs);
@@ -58,9 +59,13 @@ void    tic_fs_dirback      (tic_fs* fs);
 void    tic_fs_homedir      (tic_fs* fs);
 
 u64     fs_date     (const char* name);
+u64     fs_size     (const char* name);
 bool    fs_exists   (const char* name);
 bool    fs_isdir    (const char* path);
 void*   fs_read     (const char* path, s32* size);
+// read-only view of the file, mmap on POSIX and fs_read elsewhere, release with fs_unmap
+void*   fs_map      (const char* path, s32* size);
+void    fs_unmap    (void* data, s32 size);
 bool    fs_write    (const char* path, const void* data, s32 size);
 void    fs_enum     (const char* path, fs_list_callback callback, void* data);
 
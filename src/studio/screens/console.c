@@ -157,6 +157,8 @@ static const struct HotkeysRowGeneral {const char* section; const char* info;} H
     {"F7",            "Assign cover image while in game."},
     {"F8",            "Take a screenshot."},
     {"F9",            "Start/stop GIF video recording."},
+    {"CTRL+F8",       "Toggle profiler overlay while in game."},
+    {"CTRL+F9",       "Start/stop profiler trace to trace.json."},
     {"F11/ALT+ENTER", "Fullscreen/window mode."},
     {"CTRL+Q",        "Quit the application.",
     },
@@ -798,6 +800,13 @@ static void* getDemoCart(Console* console, const tic_script* script, s32* size)
     return data;
 }
 
+// same as tic_cart_load, but PNG carts unpack into the buffer of the console index
+static void loadCartData(Console* console, tic_cartridge* cart, const void* data, s32 size)
+{
+    if(!tic_cart_load_index(cart, &console->index, data, size))
+        memset(cart, 0, sizeof(tic_cartridge));
+}
+
 static void setCartName(Console* console, const char* name, const char* path)
 {
     if(console->rom.name != name)
@@ -820,7 +829,7 @@ static void onLoadDemoCommandConfirmed(Console* console, const tic_script* scrip
     }
 
     data = getDemoCart(console, script, &size);
-    tic_cart_load(&console->tic->cart, data, size);
+    loadCartData(console, &console->tic->cart, data, size);
     tic_api_reset(console->tic);
 
     studioRomLoaded(console->studio);
@@ -871,7 +880,7 @@ static void updateProject(Console* console)
                 tic_project_load(console->rom.name, data, size, &tic->cart);
             else
 #endif
-                tic_cart_load(&tic->cart, data, size);
+                loadCartData(console, &tic->cart, data, size);
 
             studioRomLoaded(console->studio);
         }
@@ -896,7 +905,7 @@ static void loadByHashDone(const u8* buffer, s32 size, void* data)
 
     SCOPE(free(cart))
     {
-        tic_cart_load(cart, buffer, size);
+        loadCartData(console, cart, buffer, size);
         loadCartSection(console, cart, loadByHashData->section);
         onCartLoaded(console, loadByHashData->name, loadByHashData->section);
     }
@@ -1023,7 +1032,7 @@ static void onLoadCommandConfirmed(Console* console)
 
                 SCOPE(free(cart))
                 {
-                    tic_cart_load(cart, data, size);
+                    loadCartData(console, cart, data, size);
                     loadCartSection(console, cart, section);
                     onCartLoaded(console, name, section);
                 }
@@ -1035,14 +1044,17 @@ static void onLoadCommandConfirmed(Console* console)
 
                 SCOPE(free(buffer.data))
                 {
-                    tic_cartridge* cart = loadPngCart(buffer);
+                    tic_cartridge* cart = malloc(sizeof(tic_cartridge));
 
                     if(cart) SCOPE(free(cart))
                     {
-                        loadCartSection(console, cart, section);
-                        onCartLoaded(console, param, section);
+                        if(tic_cart_load_index(cart, &console->index, buffer.data, buffer.size))
+                        {
+                            loadCartSection(console, cart, section);
+                            onCartLoaded(console, param, section);
+                        }
+                        else printError(console, "\npng cart loading error");
                     }
-                    else printError(console, "\npng cart loading error");
                 }
             }
             else
@@ -1195,7 +1207,7 @@ static void loadDemo(Console* console, const tic_script* script)
 
     if(data)
     {
-        tic_cart_load(&console->tic->cart, data, size);
+        loadCartData(console, &console->tic->cart, data, size);
         tic_api_reset(console->tic);
 
         free(data);
@@ -2537,13 +2549,15 @@ static CartSaveResult saveCartName(Console* console, const char* name)
 
                             const char* comment = tic_get_script(tic)->singleComment;
 
-                            const char* title = tic_tool_metatag(tic->cart.code.data, "title", comment);
+                            char title[TIC_METATAG_SIZE];
+                            tic_tool_metatag(tic->cart.code.data, "title", comment, title, sizeof title);
                             if(*title)
                             {
                                 drawShadowText(tic, title, 0, 0, tic_color_white, Scale);
                             }
 
-                            const char* author = tic_tool_metatag(tic->cart.code.data, "author", comment);
+                            char author[TIC_METATAG_SIZE];
+                            tic_tool_metatag(tic->cart.code.data, "author", comment, author, sizeof author);
                             if(*author)
                             {
                                 char buf[TICNAME_MAX];
@@ -4421,7 +4435,7 @@ static bool cmdLoadCart(Console* console, const char* path)
     bool done = false;
 
     s32 size = 0;
-    void* data = fs_read(path, &size);
+    void* data = fs_map(path, &size);
 
     if(data)
     {
@@ -4438,18 +4452,11 @@ static bool cmdLoadCart(Console* console, const char* path)
 
         if(tic_tool_has_ext(cartName, PngExt))
         {
-            tic_cartridge* cart = loadPngCart((png_buffer){data, size});
-
-            if(cart)
-            {
-                memcpy(&tic->cart, cart, sizeof(tic_cartridge));
-                free(cart);
-                done = true;
-            }
+            done = tic_cart_load_index(&tic->cart, &console->index, data, size);
         }
         else if(tic_tool_has_ext(cartName, CART_EXT))
         {
-            tic_cart_load(&tic->cart, data, size);
+            loadCartData(console, &tic->cart, data, size);
             done = true;
         }
 #if defined(TIC80_PRO)
@@ -4460,7 +4467,7 @@ static bool cmdLoadCart(Console* console, const char* path)
         }
 #endif
 
-        free(data);
+        fs_unmap(data, size);
     }
 
     if(done)
@@ -4530,6 +4537,7 @@ void initConsole(Console* console, Studio* studio, tic_fs* fs, tic_net* net, Con
         .net = net,
         .args = args,
         .desc = console->desc,
+        .index = console->index,
     };
 
     // parse --cmd param
@@ -4601,5 +4609,6 @@ void freeConsole(Console* console)
 
     FREE(console->commands.items);
     free(console->desc);
+    tic_cart_index_close(&console->index);
     free(console);
 }
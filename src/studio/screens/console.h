@@ -24,6 +24,7 @@
 
 #include "studio/studio.h"
 #include "studio/fs.h"
+#include "cart.h"
 
 typedef enum
 {
@@ -81,6 +82,9 @@ struct Console
         char path[TICNAME_MAX];
     } rom;
 
+    // carts are loaded through one index, so PNG carts unpack into the same buffer
+    tic_cart_index index;
+
     struct
     {
         s32 index;
@@ -394,7 +394,8 @@ static void initGameMenu(StudioMainMenu* main)
 
     freeItems(main);
 
-    const char* value = tic_tool_metatag(tic->cart.code.data, "menu", tic_get_script(tic)->singleComment);
+    char value[TIC_METATAG_SIZE];
+    tic_tool_metatag(tic->cart.code.data, "menu", tic_get_script(tic)->singleComment, value, sizeof value);
 
     if(*value)
     {
@@ -50,6 +50,83 @@ static void onExit(void* data)
     run->exit = true;
 }
 
+#define BYTECODE_CACHE_EXT ".luac"
+
+// every edited version of the code gets its own cache entry,
+// so the oldest ones are evicted once the cache outgrows this
+enum {BytecodeCacheLimit = 4 * 1024 * 1024};
+
+typedef struct
+{
+    const char* dir;
+    const char* keep;
+    u64 total;
+    u64 date;
+    char oldest[TICNAME_MAX];
+} CacheUsage;
+
+static bool onCacheItem(const char* name, const char* title, const char* hash, s32 id, void* data, bool dir)
+{
+    CacheUsage* usage = data;
+
+    if(!dir && tic_tool_has_ext(name, BYTECODE_CACHE_EXT))
+    {
+        char path[TICNAME_MAX];
+        snprintf(path, sizeof path, "%s%s", usage->dir, name);
+
+        u64 date = fs_date(path);
+        usage->total += fs_size(path);
+
+        if(strcmp(name, usage->keep) && (!*usage->oldest || date < usage->date))
+        {
+            usage->date = date;
+            snprintf(usage->oldest, sizeof usage->oldest, "/" TIC_CACHE "%s", name);
+        }
+    }
+
+    return true;
+}
+
+static void evictCache(Run* run, const char* keep)
+{
+    char dir[TICNAME_MAX];
+    snprintf(dir, sizeof dir, "%s", tic_fs_pathroot(run->fs, TIC_CACHE));
+
+    while(true)
+    {
+        CacheUsage usage = {.dir = dir, .keep = keep};
+        fs_enum(dir, onCacheItem, &usage);
+
+        if(usage.total <= BytecodeCacheLimit || !*usage.oldest)
+            break;
+
+        // tic_fs_delfile() returns true on failure, don't spin on a file that can't be removed
+        if(tic_fs_delfile(run->fs, usage.oldest))
+            break;
+    }
+}
+
+static void* loadCache(void* data, const char* key, s32* size)
+{
+    Run* run = (Run*)data;
+    char path[TICNAME_MAX];
+    snprintf(path, sizeof path, TIC_CACHE "%s" BYTECODE_CACHE_EXT, key);
+
+    return tic_fs_loadroot(run->fs, path, size);
+}
+
+static void saveCache(void* data, const char* key, const void* buffer, s32 size)
+{
+    Run* run = (Run*)data;
+    char path[TICNAME_MAX];
+    snprintf(path, sizeof path, TIC_CACHE "%s" BYTECODE_CACHE_EXT, key);
+
+    tic_fs_makedir(run->fs, TIC_CACHE);
+    tic_fs_saveroot(run->fs, path, buffer, size, true);
+
+    evictCache(run, path + STRLEN(TIC_CACHE));
+}
+
 static const char* data2md5(const void* data, s32 length)
 {
     const char *str = data;
@@ -148,7 +225,12 @@ void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
             .exit = onExit,
             .data = run,
             .counter = getCounter,
-            .freq = getFreq
+            .freq = getFreq,
+            // cached bytecode is loaded without verification as well,
+            // so the cache is only used when bytecode is trusted
+            .cacheLoad = console->args.bytecode ? loadCache : NULL,
+            .cacheSave = console->args.bytecode ? saveCache : NULL,
+            .bytecode = console->args.bytecode,
         },
     };
 
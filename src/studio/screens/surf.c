@@ -28,6 +28,7 @@
 #include "menu.h"
 #include "ext/gif.h"
 #include "ext/png.h"
+#include "ext/md5.h"
 
 #if defined(TIC80_PRO)
 #include "studio/project.h"
@@ -37,6 +38,17 @@
 
 #include <string.h>
 
+// covers of local carts are loaded on a worker, platforms without threads load one per frame
+#if defined(__TIC_WINDOWS__)
+#   if !defined(__TIC_WIN7__)
+#       include <windows.h>
+#       define SURF_THREADS
+#   endif
+#elif !defined(__EMSCRIPTEN__) && !defined(BAREMETALPI) && !defined(_3DS)
+#   include <pthread.h>
+#   define SURF_THREADS
+#endif
+
 #define MAIN_OFFSET 4
 #define MENU_HEIGHT 10
 #define ANIM 10
@@ -48,10 +60,13 @@
 #define COVER_FADEIN 96
 #define COVER_FADEOUT 256
 #define CAN_OPEN_URL (__TIC_WINDOWS__ || __TIC_LINUX__ || __TIC_MACOSX__ || __TIC_ANDROID__)
+#define COVER_QUEUE_SIZE 16
+#define COVER_CACHE_EXT ".cover"
 
 static const char* PngExt = PNG_EXT;
 
 typedef struct SurfItem SurfItem;
+typedef struct SurfCovers SurfCovers;
 
 struct SurfItem
 {
@@ -261,6 +276,423 @@ static void addMenuItemsDone(void* data)
     surf->loading = false;
 }
 
+typedef struct
+{
+    s32 pos;
+    u32 dir;
+    char path[TICNAME_MAX];
+} CoverJob;
+
+typedef struct
+{
+    s32 pos;
+    u32 dir;
+    tic_screen* cover;
+    tic_palette* palette;
+} CoverResult;
+
+// cache entry of a cart with a cover, carts without one are stored as a single byte
+typedef struct
+{
+    tic_screen screen;
+    tic_palette palette;
+} CoverCache;
+
+struct SurfCovers
+{
+    // the worker can't use tic_fs, so the cache folder is resolved upfront
+    char cache[TICNAME_MAX];
+
+    // bumped on every menu reload, results from the previous folder are dropped
+    u32 dir;
+
+    // menu position the queue was built for
+    s32 scheduled;
+
+    // position the worker is loading now, -1 if none
+    s32 current;
+
+    struct
+    {
+        CoverJob items[COVER_QUEUE_SIZE];
+        s32 head;
+        s32 count;
+    } queue;
+
+    struct
+    {
+        CoverResult items[COVER_QUEUE_SIZE];
+        s32 count;
+    } done;
+
+    // owned by the worker, surf->index stays with the UI thread
+    tic_cart_index index;
+    tic_cartridge* cart;
+
+    bool threaded;
+
+#if defined(SURF_THREADS)
+    bool quit;
+#   if defined(__TIC_WINDOWS__)
+    HANDLE thread;
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE cond;
+#   else
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#   endif
+#endif
+};
+
+#if defined(SURF_THREADS)
+#   if defined(__TIC_WINDOWS__)
+#       define COVERS_LOCK(C)      EnterCriticalSection(&(C)->mutex)
+#       define COVERS_UNLOCK(C)    LeaveCriticalSection(&(C)->mutex)
+#       define COVERS_WAIT(C)      SleepConditionVariableCS(&(C)->cond, &(C)->mutex, INFINITE)
+#       define COVERS_NOTIFY(C)    WakeAllConditionVariable(&(C)->cond)
+#   else
+#       define COVERS_LOCK(C)      pthread_mutex_lock(&(C)->mutex)
+#       define COVERS_UNLOCK(C)    pthread_mutex_unlock(&(C)->mutex)
+#       define COVERS_WAIT(C)      pthread_cond_wait(&(C)->cond, &(C)->mutex)
+#       define COVERS_NOTIFY(C)    pthread_cond_broadcast(&(C)->cond)
+#   endif
+#else
+#   define COVERS_LOCK(C)
+#   define COVERS_UNLOCK(C)
+#   define COVERS_NOTIFY(C)
+#endif
+
+// the key is the path, date and size of the cart, so edited carts get a new entry
+static bool getCoverCachePath(const SurfCovers* covers, const char* path, char* out)
+{
+    u64 date = fs_date(path);
+    u64 size = fs_size(path);
+
+    if(!date || !size)
+        return false;
+
+    char key[TICNAME_MAX + 64];
+    s32 length = snprintf(key, sizeof key, "%s:%llu:%llu", path, (unsigned long long)date, (unsigned long long)size);
+
+    enum {HashSize = 16};
+    u8 digest[HashSize];
+
+    MD5_CTX c;
+    MD5_Init(&c);
+    MD5_Update(&c, key, MIN(length, (s32)sizeof key - 1));
+    MD5_Final(digest, &c);
+
+    char hash[HashSize * 2 + 1];
+    for(s32 i = 0; i < HashSize; i++)
+        sprintf(hash + i * 2, "%02x", digest[i]);
+
+    return snprintf(out, TICNAME_MAX, "%s%s" COVER_CACHE_EXT, covers->cache, hash) < TICNAME_MAX;
+}
+
+// runs on the worker, touches only the job and the worker's own cart and index
+static void readCover(SurfCovers* covers, const CoverJob* job, CoverResult* result)
+{
+    char cachePath[TICNAME_MAX];
+    bool cached = getCoverCachePath(covers, job->path, cachePath);
+
+    if(cached)
+    {
+        s32 size = 0;
+        CoverCache* entry = fs_read(cachePath, &size);
+
+        if(entry)
+        {
+            if(size == sizeof(CoverCache))
+            {
+                memcpy((result->cover = malloc(sizeof(tic_screen))), &entry->screen, sizeof(tic_screen));
+                memcpy((result->palette = malloc(sizeof(tic_palette))), &entry->palette, sizeof(tic_palette));
+            }
+
+            free(entry);
+
+            if(size == sizeof(CoverCache) || size == 1)
+                return;
+        }
+    }
+
+    s32 size = 0;
+    void* data = fs_map(job->path, &size);
+
+    if(!data)
+        return;
+
+    // only the cover is loaded, so clearing it is enough between carts
+    tic_cartridge* cart = covers->cart;
+    ZEROMEM(cart->bank0.screen);
+    ZEROMEM(cart->bank0.palette);
+
+#if defined(TIC80_PRO)
+    if(project_ext(job->path))
+        tic_project_load(job->path, data, size, cart);
+    else
+#endif
+    if(tic_cart_index_open(&covers->index, data, size))
+        tic_cart_load_cover(cart, &covers->index);
+
+    fs_unmap(data, size);
+
+    bool found = !EMPTY(cart->bank0.screen.data) && !EMPTY(cart->bank0.palette.vbank0.data);
+
+    if(found)
+    {
+        memcpy((result->palette = malloc(sizeof(tic_palette))), &cart->bank0.palette.vbank0, sizeof(tic_palette));
+        memcpy((result->cover = malloc(sizeof(tic_screen))), &cart->bank0.screen, sizeof(tic_screen));
+    }
+
+    if(cached)
+    {
+        if(found)
+        {
+            CoverCache* entry = malloc(sizeof(CoverCache));
+
+            if(entry)
+            {
+                memcpy(&entry->screen, &cart->bank0.screen, sizeof(tic_screen));
+                memcpy(&entry->palette, &cart->bank0.palette.vbank0, sizeof(tic_palette));
+                fs_write(cachePath, entry, sizeof(CoverCache));
+                free(entry);
+            }
+        }
+        else fs_write(cachePath, "", 1);
+    }
+}
+
+// the callers hold the lock
+static bool popCoverJob(SurfCovers* covers, CoverJob* job)
+{
+    if(covers->queue.count == 0 || covers->done.count == COVER_QUEUE_SIZE)
+        return false;
+
+    *job = covers->queue.items[covers->queue.head++];
+    covers->queue.count--;
+    covers->current = job->pos;
+
+    return true;
+}
+
+static void pushCoverResult(SurfCovers* covers, const CoverResult* result)
+{
+    covers->done.items[covers->done.count++] = *result;
+    covers->current = -1;
+}
+
+static void loadNextCover(SurfCovers* covers)
+{
+    CoverJob job;
+
+    if(popCoverJob(covers, &job))
+    {
+        CoverResult result = {job.pos, job.dir};
+        readCover(covers, &job, &result);
+        pushCoverResult(covers, &result);
+    }
+}
+
+#if defined(SURF_THREADS)
+
+static void coverWorker(SurfCovers* covers)
+{
+    COVERS_LOCK(covers);
+
+    while(!covers->quit)
+    {
+        CoverJob job;
+
+        if(popCoverJob(covers, &job))
+        {
+            COVERS_UNLOCK(covers);
+
+            CoverResult result = {job.pos, job.dir};
+            readCover(covers, &job, &result);
+
+            COVERS_LOCK(covers);
+            pushCoverResult(covers, &result);
+        }
+        else COVERS_WAIT(covers);
+    }
+
+    COVERS_UNLOCK(covers);
+}
+
+#   if defined(__TIC_WINDOWS__)
+static DWORD WINAPI coverThread(LPVOID data)
+{
+    coverWorker(data);
+    return 0;
+}
+#   else
+static void* coverThread(void* data)
+{
+    coverWorker(data);
+    return NULL;
+}
+#   endif
+
+#endif
+
+static SurfCovers* createCovers(Surf* surf)
+{
+    SurfCovers* covers = calloc(1, sizeof(SurfCovers));
+
+    if(covers)
+    {
+        if(!(covers->cart = calloc(1, sizeof(tic_cartridge))))
+        {
+            free(covers);
+            return NULL;
+        }
+
+        snprintf(covers->cache, sizeof covers->cache, "%s", tic_fs_pathroot(surf->fs, TIC_CACHE));
+        covers->scheduled = covers->current = -1;
+
+#if defined(SURF_THREADS)
+#   if defined(__TIC_WINDOWS__)
+        InitializeCriticalSection(&covers->mutex);
+        InitializeConditionVariable(&covers->cond);
+        covers->threaded = (covers->thread = CreateThread(NULL, 0, coverThread, covers, 0, NULL)) != NULL;
+#   else
+        pthread_mutex_init(&covers->mutex, NULL);
+        pthread_cond_init(&covers->cond, NULL);
+        covers->threaded = pthread_create(&covers->thread, NULL, coverThread, covers) == 0;
+#   endif
+#endif
+    }
+
+    return covers;
+}
+
+static void freeCovers(SurfCovers* covers)
+{
+    if(!covers)
+        return;
+
+#if defined(SURF_THREADS)
+    COVERS_LOCK(covers);
+    covers->quit = true;
+    COVERS_NOTIFY(covers);
+    COVERS_UNLOCK(covers);
+
+#   if defined(__TIC_WINDOWS__)
+    if(covers->threaded)
+    {
+        WaitForSingleObject(covers->thread, INFINITE);
+        CloseHandle(covers->thread);
+    }
+
+    DeleteCriticalSection(&covers->mutex);
+#   else
+    if(covers->threaded)
+        pthread_join(covers->thread, NULL);
+
+    pthread_mutex_destroy(&covers->mutex);
+    pthread_cond_destroy(&covers->cond);
+#   endif
+#endif
+
+    for(s32 i = 0; i < covers->done.count; i++)
+    {
+        FREE(covers->done.items[i].cover);
+        FREE(covers->done.items[i].palette);
+    }
+
+    tic_cart_index_close(&covers->index);
+    free(covers->cart);
+    free(covers);
+}
+
+static void resetCovers(SurfCovers* covers)
+{
+    COVERS_LOCK(covers);
+
+    covers->dir++;
+    covers->queue.head = covers->queue.count = 0;
+    covers->scheduled = -1;
+
+    COVERS_UNLOCK(covers);
+}
+
+// the selected item goes first and then its neighbours by distance, so the visible covers come before the rest
+static void scheduleCovers(Surf* surf, SurfCovers* covers)
+{
+    enum {Visible = TIC80_HEIGHT / MENU_HEIGHT / 2 + 1};
+
+    covers->queue.head = covers->queue.count = 0;
+    covers->scheduled = surf->menu.pos;
+
+    for(s32 d = 0; d <= Visible; d++)
+        for(s32 side = d ? -1 : 1; side <= 1; side += 2)
+        {
+            s32 pos = surf->menu.pos + d * side;
+
+            if(pos < 0 || pos >= surf->menu.count || pos == covers->current)
+                continue;
+
+            const SurfItem* item = &surf->menu.items[pos];
+
+            if(item->dir || item->coverLoading)
+                continue;
+
+            if(covers->queue.count == COVER_QUEUE_SIZE)
+                return;
+
+            CoverJob* job = &covers->queue.items[covers->queue.count++];
+            job->pos = pos;
+            job->dir = covers->dir;
+            snprintf(job->path, sizeof job->path, "%s", tic_fs_path(surf->fs, item->name));
+        }
+}
+
+static void updateCovers(Surf* surf)
+{
+    if(!surf->covers && !(surf->covers = createCovers(surf)))
+        return;
+
+    SurfCovers* covers = surf->covers;
+
+    COVERS_LOCK(covers);
+
+    for(s32 i = 0; i < covers->done.count; i++)
+    {
+        CoverResult* result = &covers->done.items[i];
+        SurfItem* item = result->dir == covers->dir && result->pos < surf->menu.count
+            ? &surf->menu.items[result->pos] : NULL;
+
+        if(item && !item->coverLoading)
+        {
+            item->cover = result->cover;
+            item->palette = result->palette;
+            item->coverLoading = true;
+        }
+        else
+        {
+            FREE(result->cover);
+            FREE(result->palette);
+        }
+    }
+
+    // a dropped result is queued again by the rescheduling
+    if(covers->done.count)
+    {
+        covers->done.count = 0;
+        covers->scheduled = -1;
+    }
+
+    if(covers->scheduled != surf->menu.pos)
+        scheduleCovers(surf, covers);
+
+    COVERS_NOTIFY(covers);
+    COVERS_UNLOCK(covers);
+
+    if(!covers->threaded)
+        loadNextCover(covers);
+}
+
 static void resetMenu(Surf* surf)
 {
     if(surf->menu.items)
@@ -284,6 +716,9 @@ static void resetMenu(Surf* surf)
     }
 
     surf->menu.pos = 0;
+
+    if(surf->covers)
+        resetCovers(surf->covers);
 }
 
 static void updateMenuItemCover(Surf* surf, s32 pos, const u8* cover, s32 size)
@@ -377,7 +812,11 @@ static void requestCover(Surf* surf, SurfItem* item)
 
 static void loadCover(Surf* surf)
 {
-    tic_mem* tic = surf->tic;
+    if(!tic_fs_ispubdir(surf->fs))
+    {
+        updateCovers(surf);
+        return;
+    }
 
     SurfItem* item = getMenuItem(surf);
 
@@ -386,53 +825,8 @@ static void loadCover(Surf* surf)
 
     item->coverLoading = true;
 
-    if(!tic_fs_ispubdir(surf->fs))
-    {
-
-        s32 size = 0;
-        void* data = tic_fs_load(surf->fs, item->name, &size);
-
-        if(data)
-        {
-            tic_cartridge* cart = (tic_cartridge*)malloc(sizeof(tic_cartridge));
-
-            if(cart)
-            {
-
-                if(tic_tool_has_ext(item->name, PngExt))
-                {
-                    tic_cartridge* pngcart = loadPngCart((png_buffer){data, size});
-
-                    if(pngcart)
-                    {
-                        memcpy(cart, pngcart, sizeof(tic_cartridge));
-                        free(pngcart);
-                    }
-                    else memset(cart, 0, sizeof(tic_cartridge));
-                }
-#if defined(TIC80_PRO)
-                else if(project_ext(item->name))
-                    tic_project_load(item->name, data, size, cart);
-#endif
-                else
-                    tic_cart_load(cart, data, size);
-
-                if(!EMPTY(cart->bank0.screen.data) && !EMPTY(cart->bank0.palette.vbank0.data))
-                {
-                    memcpy((item->palette = malloc(sizeof(tic_palette))), &cart->bank0.palette.vbank0, sizeof(tic_palette));
-                    memcpy((item->cover = malloc(sizeof(tic_screen))), &cart->bank0.screen, sizeof(tic_screen));
-                }
-
-                free(cart);
-            }
-
-            free(data);
-        }
-    }
-    else if(item->hash && !item->cover)
-    {
+    if(item->hash && !item->cover)
         requestCover(surf, item);
-    }
 }
 
 static void initItemsAsync(Surf* surf, fs_done_callback callback, void* calldata)
@@ -606,17 +1000,15 @@ static void loadCart(Surf* surf)
     if(tic_tool_has_ext(item->name, PngExt))
     {
         s32 size = 0;
-        void* data = tic_fs_load(surf->fs, item->name, &size);
+        void* data = tic_fs_map(surf->fs, item->name, &size);
 
         if(data)
         {
-            tic_cartridge* cart = loadPngCart((png_buffer){data, size});
-
-            if(cart)
-            {
+            // the PNG has to carry a cart
+            if(tic_cart_index_open(&surf->index, data, size) && surf->index.png.size)
                 surf->anim.movie = resetMovie(&surf->anim.play);
-                free(cart);
-            }
+
+            fs_unmap(data, size);
         }
     }
     else surf->anim.movie = resetMovie(&surf->anim.play);
@@ -841,6 +1233,8 @@ static void moveDone(void* data)
 void initSurf(Surf* surf, Studio* studio, struct Console* console)
 {
     freeAnim(surf);
+    freeCovers(surf->covers);
+    tic_cart_index_close(&surf->index);
 
     *surf = (Surf)
     {
@@ -927,5 +1321,7 @@ void freeSurf(Surf* surf)
 {
     freeAnim(surf);
     resetMenu(surf);
+    freeCovers(surf->covers);
+    tic_cart_index_close(&surf->index);
     free(surf);
 }
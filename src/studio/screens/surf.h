@@ -23,6 +23,7 @@
 #pragma once
 
 #include "studio/studio.h"
+#include "cart.h"
 
 typedef struct Surf Surf;
 
@@ -39,6 +40,12 @@ struct Surf
     bool loading;
     s32 ticks;
 
+    // carts are opened through one index, so PNG carts unpack into the same buffer
+    tic_cart_index index;
+
+    // local covers are loaded in the background and cached in TIC_CACHE
+    struct SurfCovers* covers;
+
     struct
     {
         s32 pos;
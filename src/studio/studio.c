@@ -237,6 +237,12 @@ struct Studio
     s32 samplerate;
     tic_font systemFont;
 
+    struct
+    {
+        bool show;
+        bool trace;
+    } profile;
+
 };
 
 static void emptyDone(void* data) {}
@@ -310,22 +316,16 @@ const char* studioExportSfx(Studio* studio, s32 index, const char* filename)
         music2ram(tic->ram, getMusicSrc(studio));
 
         {
-            const tic_sample* effect = &sfx->samples.data[index];
+            // the samples buffer holds one frame, it is reused as the render target
+            s16* buffer = tic->product.samples.buffer;
+            s32 count = tic->product.samples.count / TIC80_SAMPLE_CHANNELS;
 
-            enum{Channel = 0};
-            sfx_stop(tic, Channel);
-            tic_api_sfx(tic, index, effect->note, effect->octave, -1, Channel, MAX_VOLUME, MAX_VOLUME, SFX_DEF_SPEED);
+            tic_core_render_sfx(tic, index);
 
-            for(s32 ticks = 0, pos = 0; pos < SFX_TICKS; pos = tic_tool_sfx_pos(effect->speed, ++ticks))
-            {
-                tic_core_tick_start(tic);
-                tic_core_tick_end(tic);
-                tic_core_synth_sound(tic);
+            s32 size;
+            while((size = tic_core_render_sound(tic, buffer, count)))
+                wave_write(buffer, size * TIC80_SAMPLE_CHANNELS);
 
-                wave_write(tic->product.samples.buffer, tic->product.samples.count);
-            }
-
-            sfx_stop(tic, Channel);
             memset(tic->ram->registers, 0, sizeof(tic_sound_register));
         }
 
@@ -367,23 +367,24 @@ const char* studioExportMusic(Studio* studio, s32 track, s32 bank, const char* f
         const tic_music_state* state = &tic->ram->music_state;
         const Music* editor = studio->banks.music[bank];
 
-        tic_api_music(tic, track, -1, -1, false, editor->sustain, -1, -1);
+        u8 mute = 0;
+        for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+            if(!editor->on[i])
+                mute |= 1 << i;
+
+        tic_core_render_music(tic, track, editor->sustain, mute);
+
+        // one tick of samples per call, so the frame limit still stops looping tracks
+        s16* buffer = tic->product.samples.buffer;
+        s32 count = tic->product.samples.count / TIC80_SAMPLE_CHANNELS;
 
         s32 frame = state->music.frame;
         s32 frames = MUSIC_FRAMES * 16;
+        s32 size;
 
-        while(frames && state->flag.music_status == tic_music_play)
+        while(frames && (size = tic_core_render_sound(tic, buffer, count)))
         {
-            tic_core_tick_start(tic);
-
-            for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
-                if(!editor->on[i])
-                    tic->ram->registers[i].volume = 0;
-
-            tic_core_tick_end(tic);
-            tic_core_synth_sound(tic);
-
-            wave_write(tic->product.samples.buffer, tic->product.samples.count);
+            wave_write(buffer, size * TIC80_SAMPLE_CHANNELS);
 
             if(frame != state->music.frame)
             {
@@ -1008,6 +1009,8 @@ static void drawPopup(Studio* studio)
             for(s32 i = 0, y = 0; y < (Height + studio->anim.pos.popup); y++, dst += TIC80_MARGIN_RIGHT + TIC80_MARGIN_LEFT)
                 for(s32 x = 0; x < Width; x++)
                 *dst++ = tic_rgba(&bank->palette.vbank0.colors[tic_tool_peek4(tic->ram->vram.screen.data, i++)]);
+
+            tic_core_invalidate(tic, TIC80_MARGIN_TOP, TIC80_MARGIN_TOP + Height + studio->anim.pos.popup);
         }
     }
 }
@@ -1262,6 +1265,10 @@ void setStudioMode(Studio* studio, EditorMode mode)
         }
 
 #if defined(BUILD_EDITORS)
+        // the code editor keeps its own copy of the code, the other modes use the cart
+        if(prev == TIC_CODE_MODE)
+            codeSave(studio->code);
+
         switch(mode)
         {
         case TIC_RUN_MODE: initRunMode(studio); break;
@@ -1275,6 +1282,9 @@ void setStudioMode(Studio* studio, EditorMode mode)
         }
 
         studio->mode = mode;
+
+        if(mode == TIC_CODE_MODE)
+            codeLoad(studio->code);
 #else
         switch (mode)
         {
@@ -1549,6 +1559,9 @@ void studioRomLoaded(Studio* studio)
 
 bool studioCartChanged(Studio* studio)
 {
+    if(studio->mode == TIC_CODE_MODE)
+        codeSave(studio->code);
+
     CartHash hash;
     md5(&studio->tic->cart, sizeof(tic_cartridge), hash.data);
 
@@ -1560,18 +1573,6 @@ void runGame(Studio* studio)
 {
 #if defined(BUILD_EDITORS)
 
-    if (studio->config->data.fft) {
-        // initialize FFT data structures
-        fPeakMinValue = 0.01f;
-        fPeakSmoothing = 0.995f;
-        fPeakSmoothValue = 0.0f;
-        fAmplification = 1.0f;
-        memset(fftData, 0, sizeof(fftData[0]) * FFT_SIZE);
-        memset(fftSmoothingData, 0, sizeof(fftSmoothingData[0]) * FFT_SIZE);
-        memset(fftNormalizedData, 0, sizeof(fftNormalizedData[0]) * FFT_SIZE);
-        memset(fftNormalizedMaxData, 0, sizeof(fftNormalizedMaxData[0]) * FFT_SIZE);
-    }
-
     if(studio->console->args.keepcmd
         && studio->console->commands.count
         && studio->console->commands.current >= studio->console->commands.count)
@@ -1602,7 +1603,15 @@ void runGame(Studio* studio)
 #if defined(BUILD_EDITORS)
 void saveProject(Studio* studio)
 {
-    if(getConfig(studio)->trim) trimWhitespace(studio->code);
+    if(studio->mode == TIC_CODE_MODE)
+        codeSave(studio->code);
+
+    if(getConfig(studio)->trim)
+    {
+        codeLoad(studio->code);
+        trimWhitespace(studio->code);
+        codeSave(studio->code);
+    }
 
     CartSaveResult rom = studio->console->save(studio->console);
 
@@ -1852,6 +1861,49 @@ static bool showGameMenu(Studio* studio)
 
 #endif
 
+static void updateProfiler(Studio* studio)
+{
+    studio->profile.show || studio->profile.trace
+        ? tic_core_profile(studio->tic, tic_sys_counter_get, tic_sys_freq_get)
+        : tic_core_profile(studio->tic, NULL, NULL);
+}
+
+static void switchProfiler(Studio* studio)
+{
+    studio->profile.show = !studio->profile.show;
+    updateProfiler(studio);
+}
+
+#if defined(BUILD_EDITORS)
+static void switchProfilerTrace(Studio* studio)
+{
+    tic_mem* tic = studio->tic;
+
+    studio->profile.trace = !studio->profile.trace;
+
+    if(studio->profile.trace)
+    {
+        updateProfiler(studio);
+        tic_core_profile_trace(tic, true);
+    }
+    else
+    {
+        static const char Filename[] = "trace.json";
+
+        tic_core_profile_trace(tic, false);
+
+        s32 size = 0;
+        char* json = tic_core_profile_json(tic, &size);
+        bool done = json && tic_fs_save(studio->fs, Filename, json, size, true);
+        FREE(json);
+
+        updateProfiler(studio);
+
+        showPopupMessage(studio, done ? "trace.json saved :)" : "error: trace not saved :(");
+    }
+}
+#endif
+
 static void processShortcuts(Studio* studio)
 {
     tic_mem* tic = studio->tic;
@@ -1898,7 +1950,9 @@ static void processShortcuts(Studio* studio)
     else if(ctrl)
     {
         if(keyWasPressedOnce(studio, tic_key_q)) studio_exit(studio);
+        else if(keyWasPressedOnce(studio, tic_key_f8)) switchProfiler(studio);
 #if defined(BUILD_EDITORS)
+        else if(keyWasPressedOnce(studio, tic_key_f9)) switchProfilerTrace(studio);
         else if(keyWasPressedOnce(studio, tic_key_pageup)) changeStudioMode(studio, -1);
         else if(keyWasPressedOnce(studio, tic_key_pagedown)) changeStudioMode(studio, +1);
         else if(enterWasPressedOnce(studio)) runGame(studio);
@@ -2316,17 +2370,22 @@ static void doCodeExport(Studio* studio)
         sprintf(pos, "-- pos: %i,%i\n", x, y);
     }
 
-    if(strcmp(studio->bytebattle.last.postag, pos) || strcmp(studio->bytebattle.last.code.data, studio->code->src))
+    if(studio->mode == TIC_CODE_MODE)
+        codeSave(studio->code);
+
+    const char* src = studio->tic->cart.code.data;
+
+    if(strcmp(studio->bytebattle.last.postag, pos) || strcmp(studio->bytebattle.last.code.data, src))
     {
         FILE* file = fopen(studio->bytebattle.exp, "wb");
 
         if(file)
         {
             strcpy(studio->bytebattle.last.postag, pos);
-            strcpy(studio->bytebattle.last.code.data, studio->code->src);
+            strcpy(studio->bytebattle.last.code.data, src);
 
             fwrite(pos, 1, strlen(pos), file);
-            fwrite(studio->code->src, 1, strlen(studio->code->src), file);
+            fwrite(src, 1, strlen(src), file);
             fclose(file);
         }
     }
@@ -2369,7 +2428,8 @@ static void doCodeImport(Studio* studio)
                     else
                     {
                         s32 offset = end - code.data + 1;
-                        memcpy(studio->code->src, code.data + offset, sizeof(tic_code) - offset);
+                        memcpy(studio->tic->cart.code.data, code.data + offset, sizeof(tic_code) - offset);
+                        codeLoad(studio->code);
                         codeSetPos(studio->code, x - 1, y - 1);
 
                         if(studio->mode == TIC_RUN_MODE)
@@ -2423,9 +2483,70 @@ static void blitCursor(Studio* studio)
                     if(c)
                         *dst = tic_rgba(&pal->colors[c]);
                 }
+
+        tic_core_invalidate(tic, s.y, s.y + TIC_SPRITESIZE);
     }
 }
 
+static void drawProfiler(Studio* studio)
+{
+    if(!studio->profile.show || studio->mode != TIC_RUN_MODE)
+        return;
+
+    tic_mem* tic = studio->tic;
+
+    static const char* Names[] =
+    {
+#define TIC_PROFILE_DEF(_, name) name,
+        TIC_PROFILE_LIST(TIC_PROFILE_DEF)
+#undef TIC_PROFILE_DEF
+    };
+
+    enum
+    {
+        Left = TIC80_MARGIN_LEFT, Top = TIC80_MARGIN_TOP,
+        TextWidth = 17 * TIC_FONT_WIDTH, BarWidth = 32,
+        Width = TextWidth + BarWidth + 2, Height = TIC_FONT_HEIGHT + 1,
+        Rows = tic_profile_count + 1,
+    };
+
+    const tic_profile_frame* frame = tic_core_profile_frame(tic);
+    const tic_palette* pal = &getConfig(studio)->cart->bank0.palette.vbank0;
+    const tic_font_data* font = &studio->systemFont.regular;
+    const double Budget = 1000.0 / TIC80_FRAMERATE;
+
+    u32 bg = tic_rgba(&pal->colors[tic_color_black]);
+    u32 fg = tic_rgba(&pal->colors[tic_color_white]);
+
+    for(s32 r = 0; r < Rows; r++)
+    {
+        char text[32];
+        double time = r < tic_profile_count
+            ? frame->time[r]
+            : frame->time[tic_profile_tick] + frame->time[tic_profile_sound] + frame->time[tic_profile_blit];
+
+        s32 len = snprintf(text, sizeof text, "%-10s%7.2f", r < tic_profile_count ? Names[r] : "FRAME", time);
+
+        s32 bar = (s32)MIN(time / Budget * BarWidth, BarWidth);
+        u32 color = tic_rgba(&pal->colors[time > Budget ? tic_color_red : tic_color_green]);
+        u32* dst = tic->product.screen + Left + (Top + r * Height) * TIC80_FULLWIDTH;
+
+        for(s32 y = 0; y < Height; y++, dst += TIC80_FULLWIDTH)
+            for(s32 x = 0; x < Width; x++)
+            {
+                s32 tx = x - 1, ty = y - 1, i = tx / TIC_FONT_WIDTH;
+                bool pixel = tx >= 0 && tx < TextWidth && ty >= 0 && ty < TIC_FONT_HEIGHT && i < len
+                    && (font->data[(u8)text[i] * BITS_IN_BYTE + ty] >> (tx % TIC_FONT_WIDTH)) & 1;
+
+                dst[x] = pixel
+                    ? fg
+                    : x > TextWidth && x <= TextWidth + bar && y > 0 && y < Height - 1 ? color : bg;
+            }
+    }
+
+    tic_core_invalidate(tic, Top, Top + Rows * Height);
+}
+
 tic_mem* getMemory(Studio* studio)
 {
     return studio->tic;
@@ -2485,6 +2606,7 @@ void studio_tick(Studio* studio, tic80_input input)
             : tic_core_blit(tic);
 
         blitCursor(studio);
+        drawProfiler(studio);
 
 #if defined(BUILD_EDITORS)
         if(isRecordFrame(studio))
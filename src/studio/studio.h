@@ -83,6 +83,7 @@
     macro(cmd,          char*,  STRING,     "=<str>",   "run commands in the console")      \
     macro(keepcmd,      int,    BOOLEAN,    "",         "re-execute commands on every run") \
     macro(version,      int,    BOOLEAN,    "",         "print program version")            \
+    macro(bytecode,     int,    BOOLEAN,    "",         "use cart bytecode (trusted only)") \
     CRT_CMD_PARAM(macro)
 
 #define SHOW_TOOLTIP(STUDIO, FORMAT, ...)   \
@@ -213,7 +214,6 @@ bool checkMouseDown(Studio* studio, const tic_rect* rect, tic_mouse_btn button);
 void drawToolbar(Studio* studio, tic_mem* tic, bool bg);
 void drawBitIcon(Studio* studio, s32 id, s32 x, s32 y, u8 color);
 
-tic_cartridge* loadPngCart(png_buffer buffer);
 void studioRomLoaded(Studio* studio);
 void studioRomSaved(Studio* studio);
 void studioConfigChanged(Studio* studio);
@@ -126,6 +126,12 @@ typedef struct
     bool soft;
     bool trim;
 
+    // code editor undo memory in megabytes
+    s32 undoBudget;
+
+    // a cart frame running longer is interrupted, in ms, 0 never interrupts
+    s32 frameTimeout;
+
     struct StudioOptions
     {
 #if defined(CRT_SHADER_SUPPORT)
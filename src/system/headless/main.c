@@ -0,0 +1,695 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Runs a cart without video or audio devices, as fast as the host allows.
+//
+// Time is derived from the frame number, so `time()` advances exactly
+// 1000/60 ms per tick and a run is reproducible for a given cart and input.
+//
+// The input script is a text file with one line per input change:
+//
+//   <frame> <gamepads> [<mouse x> <mouse y> <mouse buttons> [<keyboard>]]
+//
+// Numbers are C literals (hex with 0x). The state is held until the next line,
+// lines must be ordered by frame, and '#' starts a comment.
+//
+// With --tracks the cart isn't run, every music track is rendered offline
+// through the sound path only and written to its own wav file.
+//
+// With --timeout a watchdog thread interrupts a frame that runs longer than
+// the given wall clock time, so a stuck cart fails instead of hanging the run.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <tic80.h>
+
+#if defined(__TIC_WINDOWS__)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <time.h>
+#endif
+
+#include "api.h"
+#include "tools.h"
+#include "argparse.h"
+#include "wave_writer.h"
+#include "ext/md5.h"
+#include "ext/png.h"
+
+#define TIC80_EXECUTABLE_NAME "tic80-headless"
+#define TIC80_DEFAULT_FRAMES TIC80_FRAMERATE
+#define TIC80_DEFAULT_SECONDS 600
+
+enum
+{
+    HeadlessOk,
+    HeadlessFail,
+    HeadlessScriptError,
+};
+
+typedef struct
+{
+    const char* cart;
+    const char* input;
+    const char* hash;
+    const char* png;
+    const char* wav;
+    const char* tracks;
+    s32 frames;
+    s32 every;
+    s32 samplerate;
+    s32 seconds;
+    s32 timeout;
+    s32 quiet;
+} Args;
+
+static struct
+{
+    u64 frame;
+    bool quit;
+    bool error;
+    bool quiet;
+
+    struct
+    {
+        FILE* file;
+        u64 frame;
+        tic80_input value;
+        bool pending;
+        bool error;
+        s32 line;
+    } input;
+} state;
+
+static u64 counter()
+{
+    return state.frame;
+}
+
+static u64 freq()
+{
+    return TIC80_FRAMERATE;
+}
+
+static void onExit()
+{
+    state.quit = true;
+}
+
+static void onError(const char* info)
+{
+    fprintf(stderr, "frame %llu: %s\n", (unsigned long long)state.frame, info);
+    state.error = true;
+}
+
+static void onTrace(const char* text, u8 color)
+{
+    if(!state.quiet)
+        printf("%s\n", text);
+}
+
+static void* loadFile(const char* path, s32* size)
+{
+    FILE* file = fopen(path, "rb");
+    void* data = NULL;
+
+    if(file)
+    {
+        fseek(file, 0, SEEK_END);
+        *size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        data = malloc(*size);
+
+        if(data && fread(data, *size, 1, file) != 1)
+        {
+            free(data);
+            data = NULL;
+        }
+
+        fclose(file);
+    }
+
+    return data;
+}
+
+// reads the next input line into state.input.value/frame, returns false at the end of the script
+static bool readInput()
+{
+    char line[256];
+
+    while(fgets(line, sizeof line, state.input.file))
+    {
+        state.input.line++;
+
+        char* comment = strchr(line, '#');
+        if(comment) *comment = '\0';
+
+        unsigned long long frame;
+        long long gamepads, x = 0, y = 0, btns = 0, keyboard = 0;
+
+        s32 count = sscanf(line, "%llu %lli %lli %lli %lli %lli", &frame, &gamepads, &x, &y, &btns, &keyboard);
+
+        if(count <= 0)
+            continue;
+
+        if(count < 2 || count == 3 || count == 4)
+        {
+            fprintf(stderr, "input:%i: expected <frame> <gamepads> [<x> <y> <buttons> [<keyboard>]]\n", state.input.line);
+            state.input.error = true;
+            return false;
+        }
+
+        tic80_input* input = &state.input.value;
+        input->gamepads.data = gamepads;
+
+        if(count >= 5)
+        {
+            input->mouse.x = x;
+            input->mouse.y = y;
+            input->mouse.btns = btns;
+        }
+
+        if(count >= 6)
+            input->keyboard.data = keyboard;
+
+        state.input.frame = frame;
+        return true;
+    }
+
+    return false;
+}
+
+// returns the input for the current frame, applying every script line up to it
+static tic80_input nextInput(tic80_input input)
+{
+    while(state.input.pending && state.input.frame <= state.frame)
+    {
+        input = state.input.value;
+        state.input.pending = readInput();
+    }
+
+    return input;
+}
+
+static void writeHash(FILE* file, const tic80* tic)
+{
+    u8 digest[16];
+
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    MD5_Update(&ctx, tic->screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32));
+    MD5_Final(digest, &ctx);
+
+    fprintf(file, "%llu ", (unsigned long long)state.frame);
+
+    for(s32 i = 0; i < (s32)sizeof digest; i++)
+        fprintf(file, "%02x", digest[i]);
+
+    fprintf(file, "\n");
+}
+
+// writes the pattern with every `placeholder` replaced by the value and %% by %,
+// the pattern comes from the command line, so it's never used as a format string,
+// returns the number of replaced placeholders or -1 on any other conversion or overflow
+static s32 formatPath(char* path, s32 size, const char* pattern, const char* placeholder, u64 value)
+{
+    char number[32];
+    snprintf(number, sizeof number, "%llu", (unsigned long long)value);
+
+    s32 length = (s32)strlen(placeholder);
+    s32 pos = 0, replaced = 0;
+
+    for(const char* ptr = pattern; *ptr;)
+    {
+        const char* text = ptr;
+        s32 count = 1;
+
+        if(*ptr == '%')
+        {
+            if(strncmp(ptr, placeholder, length) == 0)
+            {
+                text = number;
+                count = (s32)strlen(number);
+                ptr += length;
+                replaced++;
+            }
+            else if(ptr[1] == '%')
+                ptr += 2;
+            else
+                return -1;
+        }
+        else ptr++;
+
+        if(pos + count >= size)
+            return -1;
+
+        memcpy(path + pos, text, count);
+        pos += count;
+    }
+
+    path[pos] = '\0';
+
+    return replaced;
+}
+
+static bool writePng(const char* pattern, const tic80* tic)
+{
+    char path[1024];
+
+    if(formatPath(path, sizeof path, pattern, "%llu", state.frame) < 0)
+    {
+        fprintf(stderr, "Error: The name of frame %llu is too long.\n", (unsigned long long)state.frame);
+        return false;
+    }
+
+    // the screen is created in RGBA8888, which is the png_rgba byte order
+    png_img img = {TIC80_FULLWIDTH, TIC80_FULLHEIGHT, .values = tic->screen};
+    png_buffer png = png_write(img, (png_buffer){NULL, 0});
+
+    bool done = false;
+    FILE* file = fopen(path, "wb");
+
+    if(file)
+    {
+        done = fwrite(png.data, png.size, 1, file) == 1;
+        fclose(file);
+    }
+
+    free(png.data);
+
+    if(!done)
+        fprintf(stderr, "Error: Could not write %s.\n", path);
+
+    return done;
+}
+
+static Args parseArgs(s32 argc, char **argv)
+{
+    static const char *const usage[] =
+    {
+        TIC80_EXECUTABLE_NAME " <cart> [options]",
+        NULL,
+    };
+
+    Args args =
+    {
+        .frames = TIC80_DEFAULT_FRAMES,
+        .every = 1,
+        .samplerate = TIC80_SAMPLERATE,
+        .seconds = TIC80_DEFAULT_SECONDS,
+    };
+
+    struct argparse_option options[] =
+    {
+        OPT_HELP(),
+        OPT_INTEGER('n',    "frames",   &args.frames,   "number of frames to run (60 by default)"),
+        OPT_STRING('i',     "input",    &args.input,    "scripted input file"),
+        OPT_STRING('\0',    "hash",     &args.hash,     "write per frame md5 of the screen to file (- for stdout)"),
+        OPT_STRING('\0',    "png",      &args.png,      "write frames to png, %llu in the name is the frame number, otherwise the last frame only"),
+        OPT_INTEGER('\0',   "every",    &args.every,    "hash and png every N frames (1 by default)"),
+        OPT_STRING('\0',    "wav",      &args.wav,      "write audio to wav file"),
+        OPT_STRING('\0',    "tracks",   &args.tracks,   "don't run the cart, render every music track to wav, %i in the name is the track number"),
+        OPT_INTEGER('\0',   "samplerate", &args.samplerate, "audio sample rate (44100 by default)"),
+        OPT_INTEGER('\0',   "seconds",  &args.seconds,  "longest rendered track in seconds (600 by default)"),
+        OPT_INTEGER('\0',   "timeout",  &args.timeout,  "interrupt the cart when a frame takes longer than N ms (off by default)"),
+        OPT_BOOLEAN('q',    "quiet",    &args.quiet,    "don't print trace() output"),
+        OPT_END(),
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, "\nRuns a cart without window and audio, as fast as possible.\n"
+        "Exit code is 0 on success, 1 on load or output errors and 2 on script errors.", NULL);
+    argc = argparse_parse(&argparse, argc, (const char**)argv);
+
+    if(argc == 1)
+        args.cart = argv[0];
+    else
+        argparse_usage(&argparse);
+
+    return args;
+}
+
+// the core publishes the frame it ticks, the watchdog times it on its own clock and
+// interrupts it by its token, so a frame that ends in the meantime is never hit
+static struct
+{
+    tic80* tic;
+    u64 timeout;
+    tic_atomic quit;
+
+#if defined(__TIC_WINDOWS__)
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} watchdog;
+
+static u64 clockMs()
+{
+#if defined(__TIC_WINDOWS__)
+    return GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+static void watchdogWorker()
+{
+    enum {Period = 5};
+
+    u32 watched = 0;
+    u64 start = 0;
+
+    while(!tic_atomic_load(&watchdog.quit))
+    {
+        u32 frame = tic80_frame(watchdog.tic);
+        u64 now = clockMs();
+
+        // a frame is timed from when it was first seen, up to a period late
+        if(frame != watched)
+        {
+            watched = frame;
+            start = now;
+        }
+        else if(frame && now - start > watchdog.timeout)
+            tic80_interrupt(watchdog.tic, frame);
+
+#if defined(__TIC_WINDOWS__)
+        Sleep(Period);
+#else
+        nanosleep(&(struct timespec){0, Period * 1000000}, NULL);
+#endif
+    }
+}
+
+#if defined(__TIC_WINDOWS__)
+static DWORD WINAPI watchdogThread(LPVOID data)
+{
+    watchdogWorker();
+    return 0;
+}
+#else
+static void* watchdogThread(void* data)
+{
+    watchdogWorker();
+    return NULL;
+}
+#endif
+
+static bool startWatchdog(tic80* tic, s32 timeout)
+{
+    watchdog.tic = tic;
+    watchdog.timeout = timeout;
+
+#if defined(__TIC_WINDOWS__)
+    return (watchdog.thread = CreateThread(NULL, 0, watchdogThread, NULL, 0, NULL)) != NULL;
+#else
+    return pthread_create(&watchdog.thread, NULL, watchdogThread, NULL) == 0;
+#endif
+}
+
+static void stopWatchdog()
+{
+    tic_atomic_store(&watchdog.quit, true);
+
+#if defined(__TIC_WINDOWS__)
+    WaitForSingleObject(watchdog.thread, INFINITE);
+    CloseHandle(watchdog.thread);
+#else
+    pthread_join(watchdog.thread, NULL);
+#endif
+}
+
+static s32 runCart(void* cart, s32 size, const Args* args)
+{
+    tic80* tic = tic80_create(args->samplerate, TIC80_PIXEL_COLOR_RGBA8888);
+
+    if(!tic)
+    {
+        fprintf(stderr, "Error: Could not create TIC-80 instance.\n");
+        return HeadlessFail;
+    }
+
+    tic->callback.exit = onExit;
+    tic->callback.error = onError;
+    tic->callback.trace = onTrace;
+
+    tic80_load(tic, cart, size);
+
+    // tic80_load() doesn't report errors, a file that isn't a cart loads without code
+    if(!*((tic_mem*)tic)->cart.code.data)
+    {
+        fprintf(stderr, "Error: %s is not a cart or has no code.\n", args->cart);
+        tic80_delete(tic);
+        return HeadlessFail;
+    }
+
+    s32 output = HeadlessOk;
+    char name[1024];
+    bool lastPng = args->png && formatPath(name, sizeof name, args->png, "%llu", 0) == 0;
+    FILE* hash = NULL;
+
+    if(args->hash)
+    {
+        hash = strcmp(args->hash, "-") == 0 ? stdout : fopen(args->hash, "w");
+
+        if(!hash)
+        {
+            fprintf(stderr, "Error: Could not write %s.\n", args->hash);
+            output = HeadlessFail;
+        }
+    }
+
+    if(args->wav)
+    {
+        if(wave_open(args->samplerate, args->wav))
+            wave_enable_stereo();
+        else
+        {
+            fprintf(stderr, "Error: Could not write %s.\n", args->wav);
+            output = HeadlessFail;
+        }
+    }
+
+    bool watched = output == HeadlessOk && args->timeout;
+
+    if(watched && !startWatchdog(tic, args->timeout))
+    {
+        fprintf(stderr, "Error: Could not start the watchdog.\n");
+        output = HeadlessFail;
+        watched = false;
+    }
+
+    tic80_input input = {0};
+
+    for(state.frame = 0; output == HeadlessOk && !state.quit && state.frame < (u64)args->frames; state.frame++)
+    {
+        input = nextInput(input);
+
+        tic80_tick(tic, input, counter, freq);
+
+        tic80_sound(tic);
+
+        if(state.error)
+        {
+            output = HeadlessScriptError;
+            break;
+        }
+
+        if(state.input.error)
+        {
+            output = HeadlessFail;
+            break;
+        }
+
+        if(args->wav)
+            wave_write(tic->samples.buffer, tic->samples.count);
+
+        if(state.frame % args->every == 0)
+        {
+            if(hash)
+                writeHash(hash, tic);
+
+            if(args->png && !lastPng && !writePng(args->png, tic))
+                output = HeadlessFail;
+        }
+    }
+
+    if(output == HeadlessOk && lastPng)
+    {
+        // state.frame is one past the last ticked frame here
+        state.frame--;
+        if(!writePng(args->png, tic))
+            output = HeadlessFail;
+    }
+
+    if(watched)
+        stopWatchdog();
+
+    if(args->wav)
+        wave_close();
+
+    if(hash && hash != stdout)
+        fclose(hash);
+
+    tic80_delete(tic);
+
+    return output;
+}
+
+// tracks that render to silence are not written
+static s32 renderTracks(void* cart, s32 size, const Args* args)
+{
+    tic80* tic = tic80_create(args->samplerate, TIC80_PIXEL_COLOR_RGBA8888);
+
+    if(!tic)
+    {
+        fprintf(stderr, "Error: Could not create TIC-80 instance.\n");
+        return HeadlessFail;
+    }
+
+    tic80_load(tic, cart, size);
+
+    enum {Frames = 4096};
+    static s16 buffer[Frames * TIC80_SAMPLE_CHANNELS];
+
+    s32 output = HeadlessOk;
+
+    for(s32 track = 0; track < MUSIC_TRACKS && output == HeadlessOk; track++)
+    {
+        char path[1024];
+        formatPath(path, sizeof path, args->tracks, "%i", track);
+
+        if(!wave_open(args->samplerate, path))
+        {
+            fprintf(stderr, "Error: Could not write %s.\n", path);
+            output = HeadlessFail;
+            break;
+        }
+
+        wave_enable_stereo();
+        tic80_render_music(tic, track);
+
+        bool silent = true;
+        s64 left = (s64)args->seconds * args->samplerate;
+        s32 count;
+
+        while(left > 0 && (count = tic80_render(tic, buffer, left < Frames ? (s32)left : Frames)))
+        {
+            for(s32 i = 0; silent && i < count * TIC80_SAMPLE_CHANNELS; i++)
+                silent = buffer[i] == 0;
+
+            wave_write(buffer, count * TIC80_SAMPLE_CHANNELS);
+            left -= count;
+        }
+
+        wave_close();
+
+        if(silent)
+            remove(path);
+        else if(!state.quiet)
+            printf("%s\n", path);
+    }
+
+    tic80_delete(tic);
+
+    return output;
+}
+
+s32 main(s32 argc, char **argv)
+{
+    Args args = parseArgs(argc, argv);
+
+    if(!args.cart)
+        return HeadlessFail;
+
+    if(args.frames <= 0 || args.every <= 0 || args.samplerate <= 0 || args.seconds <= 0)
+    {
+        fprintf(stderr, "Error: --frames, --every, --samplerate and --seconds must be positive.\n");
+        return HeadlessFail;
+    }
+
+    if(args.timeout < 0)
+    {
+        fprintf(stderr, "Error: --timeout can't be negative.\n");
+        return HeadlessFail;
+    }
+
+    char path[1024];
+
+    if(args.png && formatPath(path, sizeof path, args.png, "%llu", 0) < 0)
+    {
+        fprintf(stderr, "Error: --png is too long or has a conversion other than %%llu and %%%%.\n");
+        return HeadlessFail;
+    }
+
+    // every track name must be unique and fit, the longest track number has two digits
+    if(args.tracks && formatPath(path, sizeof path, args.tracks, "%i", MUSIC_TRACKS - 1) <= 0)
+    {
+        fprintf(stderr, "Error: --tracks needs %%i for the track number and takes no other conversion than %%%%.\n");
+        return HeadlessFail;
+    }
+
+    state.quiet = args.quiet;
+
+    if(args.input)
+    {
+        state.input.file = fopen(args.input, "r");
+
+        if(!state.input.file)
+        {
+            fprintf(stderr, "Error: Could not load %s.\n", args.input);
+            return HeadlessFail;
+        }
+
+        state.input.pending = readInput();
+
+        if(state.input.error)
+            return HeadlessFail;
+    }
+
+    s32 size = 0;
+    void* cart = loadFile(args.cart, &size);
+
+    if(!cart)
+    {
+        fprintf(stderr, "Error: Could not load %s.\n", args.cart);
+        return HeadlessFail;
+    }
+
+    s32 output = args.tracks
+        ? renderTracks(cart, size, &args)
+        : runCart(cart, size, &args);
+
+    free(cart);
+
+    if(state.input.file)
+        fclose(state.input.file);
+
+    return output;
+}
@@ -0,0 +1,373 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Checks that core instances don't interfere with each other.
+//
+// Every cart is run on N instances, first one instance after another and then
+// all of them at once, each on its own thread. Each instance gets its own
+// pseudo random input, so they don't run in lockstep. The screen and the
+// samples of every frame are hashed, and both passes must give the same hash
+// for every instance.
+//
+// Carts are binary .tic files or text projects like the demos. They have to be
+// deterministic, so they can't use tstamp() or an unseeded random generator.
+// Janet, mruby and Wren carts share their runtime between instances, as noted
+// in tic80.h, and aren't expected to pass.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(__TIC_WINDOWS__)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+#include "api.h"
+#include "tools.h"
+#include "script.h"
+#include "argparse.h"
+#include "ext/md5.h"
+#include "studio/project.h"
+
+#define TIC80_EXECUTABLE_NAME "tic80-stress"
+
+enum
+{
+    StressOk,
+    StressFail,
+    StressMismatch,
+};
+
+typedef struct
+{
+    const void* cart;
+    s32 size;
+    s32 frames;
+    u32 seed;
+
+    u64 frame;
+    bool error;
+    u8 digest[16];
+} Instance;
+
+static u64 getCounter(void* data)
+{
+    Instance* instance = data;
+    return instance->frame;
+}
+
+static u64 getFreq(void* data)
+{
+    return TIC80_FRAMERATE;
+}
+
+static void onError(void* data, const char* info)
+{
+    Instance* instance = data;
+
+    // errors are part of the output, a cart that fails has to fail the same way on every pass
+    if(!instance->error)
+        fprintf(stderr, "seed %u, frame %llu: %s\n", instance->seed, (unsigned long long)instance->frame, info);
+
+    instance->error = true;
+}
+
+static void onTrace(void* data, const char* text, u8 color) {}
+static void onExit(void* data) {}
+
+static u32 nextRandom(u32* state)
+{
+    // xorshift32
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void runInstance(Instance* instance)
+{
+    tic80* product = tic80_create(TIC80_SAMPLERATE, TIC80_PIXEL_COLOR_RGBA8888);
+
+    if(!product)
+    {
+        instance->error = true;
+        return;
+    }
+
+    tic_mem* tic = (tic_mem*)product;
+    tic80_load(product, (void*)instance->cart, instance->size);
+
+    tic_tick_data tickData =
+    {
+        .error = onError,
+        .trace = onTrace,
+        .exit = onExit,
+        .counter = getCounter,
+        .freq = getFreq,
+        .data = instance,
+    };
+
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+
+    u32 random = instance->seed;
+
+    for(instance->frame = 0; instance->frame < (u64)instance->frames; instance->frame++)
+    {
+        tic80_input* input = &tic->ram->input;
+        input->gamepads.data = nextRandom(&random);
+        input->mouse.x = nextRandom(&random) % TIC80_WIDTH;
+        input->mouse.y = nextRandom(&random) % TIC80_HEIGHT;
+        input->mouse.btns = nextRandom(&random);
+
+        tic_core_tick_start(tic);
+        tic_core_tick(tic, &tickData);
+        tic_core_tick_end(tic);
+        tic_core_blit(tic);
+        tic_core_synth_sound(tic);
+
+        MD5_Update(&ctx, product->screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32));
+        MD5_Update(&ctx, product->samples.buffer, product->samples.count * sizeof(s16));
+    }
+
+    MD5_Final(instance->digest, &ctx);
+
+    tic80_delete(product);
+}
+
+#if defined(__TIC_WINDOWS__)
+static DWORD WINAPI instanceThread(LPVOID data)
+{
+    runInstance(data);
+    return 0;
+}
+#else
+static void* instanceThread(void* data)
+{
+    runInstance(data);
+    return NULL;
+}
+#endif
+
+static bool runParallel(Instance* instances, s32 count)
+{
+    bool done = true;
+
+#if defined(__TIC_WINDOWS__)
+    HANDLE* threads = calloc(count, sizeof(HANDLE));
+#else
+    pthread_t* threads = calloc(count, sizeof(pthread_t));
+    bool* started = calloc(count, sizeof(bool));
+#endif
+
+    for(s32 i = 0; i < count; i++)
+    {
+#if defined(__TIC_WINDOWS__)
+        if(!(threads[i] = CreateThread(NULL, 0, instanceThread, &instances[i], 0, NULL)))
+            done = false;
+#else
+        if(!(started[i] = pthread_create(&threads[i], NULL, instanceThread, &instances[i]) == 0))
+            done = false;
+#endif
+    }
+
+    for(s32 i = 0; i < count; i++)
+    {
+#if defined(__TIC_WINDOWS__)
+        if(threads[i])
+        {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+#else
+        if(started[i])
+            pthread_join(threads[i], NULL);
+#endif
+    }
+
+#if !defined(__TIC_WINDOWS__)
+    free(started);
+#endif
+    free(threads);
+
+    return done;
+}
+
+static void* loadFile(const char* path, s32* size)
+{
+    FILE* file = fopen(path, "rb");
+    void* data = NULL;
+
+    if(file)
+    {
+        fseek(file, 0, SEEK_END);
+        *size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        data = malloc(*size);
+
+        if(data && fread(data, *size, 1, file) != 1)
+        {
+            free(data);
+            data = NULL;
+        }
+
+        fclose(file);
+    }
+
+    return data;
+}
+
+static bool projectExt(const char* path)
+{
+    FOREACH_LANG(script)
+        if(tic_tool_has_ext(path, script->fileExtension))
+            return true;
+
+    return false;
+}
+
+// text projects like the demos are converted to the binary cart tic80_load() takes
+static void* loadCart(const char* path, s32* size)
+{
+    void* data = loadFile(path, size);
+
+    if(data && projectExt(path))
+    {
+        tic_cartridge* cart = calloc(1, sizeof(tic_cartridge));
+        u8* buffer = malloc(sizeof(tic_cartridge));
+
+        bool done = tic_project_load(path, data, *size, cart);
+        free(data);
+
+        if(done)
+            *size = tic_cart_save(cart, buffer);
+        else
+            free(buffer), buffer = NULL;
+
+        data = buffer;
+        free(cart);
+    }
+
+    return data;
+}
+
+static s32 stressCart(const char* path, s32 threads, s32 frames)
+{
+    s32 size = 0;
+    void* cart = loadCart(path, &size);
+
+    if(!cart)
+    {
+        fprintf(stderr, "Error: Could not load %s.\n", path);
+        return StressFail;
+    }
+
+    Instance* serial = calloc(threads, sizeof(Instance));
+    Instance* parallel = calloc(threads, sizeof(Instance));
+
+    for(s32 i = 0; i < threads; i++)
+        serial[i] = (Instance){cart, size, frames, .seed = 0x9e3779b9u * (i + 1)};
+
+    memcpy(parallel, serial, threads * sizeof(Instance));
+
+    for(s32 i = 0; i < threads; i++)
+        runInstance(&serial[i]);
+
+    s32 output = StressOk;
+
+    if(!runParallel(parallel, threads))
+    {
+        fprintf(stderr, "Error: Could not start the threads.\n");
+        output = StressFail;
+    }
+
+    for(s32 i = 0; i < threads && output == StressOk; i++)
+    {
+        if(memcmp(serial[i].digest, parallel[i].digest, sizeof serial[i].digest)
+            || serial[i].error != parallel[i].error)
+        {
+            fprintf(stderr, "%s: instance %i differs from its serial run.\n", path, i);
+            output = StressMismatch;
+        }
+    }
+
+    if(output == StressOk)
+        printf("%s: %i instances, %i frames, ok\n", path, threads, frames);
+
+    free(parallel);
+    free(serial);
+    free(cart);
+
+    return output;
+}
+
+s32 main(s32 argc, char **argv)
+{
+    static const char *const usage[] =
+    {
+        TIC80_EXECUTABLE_NAME " <cart>... [options]",
+        NULL,
+    };
+
+    s32 threads = 8;
+    s32 frames = 600;
+
+    struct argparse_option options[] =
+    {
+        OPT_HELP(),
+        OPT_INTEGER('t',    "threads",  &threads,   "number of instances and threads (8 by default)"),
+        OPT_INTEGER('n',    "frames",   &frames,    "number of frames to run (600 by default)"),
+        OPT_END(),
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, "\nRuns every cart on many instances, serially and on parallel threads,\n"
+        "and compares the output. Exit code is 0 when every run matches, 1 on errors and 2 on mismatches.", NULL);
+    argc = argparse_parse(&argparse, argc, (const char**)argv);
+
+    if(argc == 0)
+    {
+        argparse_usage(&argparse);
+        return StressFail;
+    }
+
+    if(threads <= 0 || frames <= 0)
+    {
+        fprintf(stderr, "Error: --threads and --frames must be positive.\n");
+        return StressFail;
+    }
+
+    s32 output = StressOk;
+
+    for(s32 i = 0; i < argc; i++)
+    {
+        s32 result = stressCart(argv[i], threads, frames);
+        output = MAX(output, result);
+    }
+
+    return output;
+}
@@ -0,0 +1,318 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Times the sound synthesizer alone.
+//
+// Random sfx data is played on all four channels, with notes, volumes and
+// speeds changing every half second and the sound registers poked now and then,
+// so every waveform, the noise channel and the stereo volumes are exercised.
+// Only the synthesis is timed: tic_core_synth_sound() and, on the same
+// registers every frame, a reference copy of the former synthesizer that walks
+// the channels once per stereo side. Both must produce the same samples, the
+// hash of which depends on the seed only, so running the same seed on two
+// builds also checks they synthesize identical audio.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdio.h>
+
+#if defined(__TIC_WINDOWS__)
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+#include "core/core.h"
+#include "blip_buf.h"
+#include "argparse.h"
+
+#define TIC80_EXECUTABLE_NAME "tic80-synthbench"
+
+// as in sound.c
+#define ENVELOPE_FREQ_SCALE 2
+#define ENDTIME (CLOCKRATE / TIC80_FRAMERATE)
+
+static u64 clockNs()
+{
+#if defined(__TIC_WINDOWS__)
+    LARGE_INTEGER counter, freq;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return (u64)(counter.QuadPart * (1e9 / freq.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static u32 nextRandom(u32* state)
+{
+    // xorshift32
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static u64 hashSamples(u64 hash, const s16* buffer, s32 count)
+{
+    // FNV-1a
+    const u8* samples = (const u8*)buffer;
+    for(s32 i = 0; i < count * (s32)sizeof(s16); i++)
+    {
+        hash ^= samples[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// the two pass synthesizer, every stereo side walks the channels with its own time and phase
+
+typedef struct
+{
+    s32 time;
+    s32 phase;
+    s32 amp;
+} RefRegister;
+
+typedef struct
+{
+    struct
+    {
+        RefRegister data[TIC_SOUND_CHANNELS];
+        RefRegister pcm;
+    } sides[TIC80_SAMPLE_CHANNELS];
+
+    blip_buffer_t* blip[TIC80_SAMPLE_CHANNELS];
+    s16* samples;
+    s32 count;
+} Reference;
+
+static void refUpdateAmp(blip_buffer_t* blip, RefRegister* data, s32 new_amp)
+{
+    s32 delta = new_amp - data->amp;
+    data->amp += delta;
+    blip_add_delta(blip, data->time, delta);
+}
+
+static inline s32 refPeriod(s32 freq)
+{
+    enum
+    {
+        MinPeriodValue = 10,
+        MaxPeriodValue = 4096,
+        Rate = CLOCKRATE * ENVELOPE_FREQ_SCALE / WAVE_VALUES
+    };
+
+    if (freq == 0) return MaxPeriodValue;
+
+    return CLAMP(Rate / freq - 1, MinPeriodValue, MaxPeriodValue);
+}
+
+static inline s32 refAmp(s32 volume, s32 amp)
+{
+    return amp * volume / MAX_VOLUME / (TIC_SOUND_CHANNELS + 1);
+}
+
+static void refRunPcm(blip_buffer_t* blip, const tic_pcm* pcm, RefRegister* data)
+{
+    enum{Period = ENDTIME / TIC_PCM_SIZE};
+
+    for (data->time = 0; data->time < ENDTIME; data->time += Period, data->phase = (data->phase + 1) % TIC_PCM_SIZE)
+        refUpdateAmp(blip, data, refAmp(MAX_VOLUME, pcm->data[data->phase] * SHRT_MAX / UCHAR_MAX));
+}
+
+static void refRunEnvelope(blip_buffer_t* blip, const tic_sound_register* reg, RefRegister* data, u8 stereo_volume)
+{
+    s32 period = refPeriod(tic_sound_register_get_freq(reg) * ENVELOPE_FREQ_SCALE);
+
+    // the phase fix of the single pass synthesizer, without it the waveform is read out of bounds
+    data->phase %= WAVE_VALUES;
+
+    for (; data->time < ENDTIME; data->time += period, data->phase = (data->phase + 1) % WAVE_VALUES)
+        refUpdateAmp(blip, data, refAmp(reg->volume, tic_tool_peek4(reg->waveform.data, data->phase) * SHRT_MAX / MAX_VOLUME * stereo_volume / MAX_VOLUME));
+}
+
+static void refRunNoise(blip_buffer_t* blip, const tic_sound_register* reg, RefRegister* data, u8 stereo_volume)
+{
+    if (data->phase == 0)
+        data->phase = 1;
+
+    s32 period = refPeriod(tic_sound_register_get_freq(reg));
+    s32 fb = *reg->waveform.data ? 0x14 : 0x12000;
+
+    for (; data->time < ENDTIME; data->time += period, data->phase = ((data->phase & 1) * fb) ^ (data->phase >> 1))
+        refUpdateAmp(blip, data, refAmp(reg->volume, (data->phase & 1) ? stereo_volume * SHRT_MAX / MAX_VOLUME : 0));
+}
+
+static void refSynthesize(Reference* ref, const struct sound_ring_buf* ringbuf)
+{
+    for (s32 side = 0; side < TIC80_SAMPLE_CHANNELS; side++)
+    {
+        blip_buffer_t* blip = ref->blip[side];
+
+        for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i)
+        {
+            u8 stereo_volume = tic_tool_peek4(&ringbuf->stereo, side + i * 2);
+
+            const tic_sound_register* reg = &ringbuf->registers[i];
+            RefRegister* data = &ref->sides[side].data[i];
+
+            tic_tool_noise(&reg->waveform)
+                ? refRunNoise(blip, reg, data, stereo_volume)
+                : refRunEnvelope(blip, reg, data, stereo_volume);
+
+            data->time -= ENDTIME;
+        }
+
+        refRunPcm(blip, &ringbuf->pcm, &ref->sides[side].pcm);
+
+        blip_end_frame(blip, ENDTIME);
+    }
+
+    for (s32 side = 0; side < TIC80_SAMPLE_CHANNELS; side++)
+        blip_read_samples(ref->blip[side], ref->samples + side, ref->count / TIC80_SAMPLE_CHANNELS, TIC80_SAMPLE_CHANNELS);
+}
+
+s32 main(s32 argc, char **argv)
+{
+    static const char *const usage[] =
+    {
+        TIC80_EXECUTABLE_NAME " [options]",
+        NULL,
+    };
+
+    s32 frames = 20000;
+    s32 samplerate = TIC80_SAMPLERATE;
+    s32 seed = 77;
+
+    struct argparse_option options[] =
+    {
+        OPT_HELP(),
+        OPT_INTEGER('n',    "frames",   &frames,    "number of frames to synthesize (20000 by default)"),
+        OPT_INTEGER('\0',   "samplerate", &samplerate, "audio sample rate (44100 by default)"),
+        OPT_INTEGER('\0',   "seed",     &seed,      "seed of the random sfx data (77 by default)"),
+        OPT_END(),
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, usage, 0);
+    argparse_describe(&argparse, "\nTimes the sound synthesizer on random sfx playing on every channel.", NULL);
+    argparse_parse(&argparse, argc, (const char**)argv);
+
+    if(frames <= 0 || samplerate <= 0 || seed == 0)
+    {
+        fprintf(stderr, "Error: --frames and --samplerate must be positive and --seed non zero.\n");
+        return 1;
+    }
+
+    tic_mem* tic = tic_core_create(samplerate, TIC80_PIXEL_COLOR_RGBA8888);
+
+    if(!tic)
+    {
+        fprintf(stderr, "Error: Could not create TIC-80 instance.\n");
+        return 1;
+    }
+
+    tic_core* core = (tic_core*)tic;
+
+    Reference ref = {.count = tic->product.samples.count, .samples = calloc(tic->product.samples.count, sizeof(s16))};
+
+    for (s32 side = 0; side < TIC80_SAMPLE_CHANNELS; side++)
+    {
+        ref.blip[side] = blip_new(samplerate / 10);
+        blip_set_rates(ref.blip[side], CLOCKRATE, samplerate);
+    }
+
+    u32 random = seed;
+
+    u8* sfx = (u8*)&tic->ram->sfx;
+    for(s32 i = 0; i < (s32)sizeof tic->ram->sfx; i++)
+        sfx[i] = nextRandom(&random);
+
+    u64 hash = 0xcbf29ce484222325ull, refHash = hash;
+    u64 elapsed = 0, refElapsed = 0;
+
+    for(s32 frame = 0; frame < frames; frame++)
+    {
+        tic_core_sound_tick_start(tic);
+
+        if(frame % (TIC80_FRAMERATE / 2) == 0)
+            for(s32 channel = 0; channel < TIC_SOUND_CHANNELS; channel++)
+            {
+                // drawn one by one, the order of evaluation of the arguments is unspecified
+                s32 index = nextRandom(&random) % SFX_COUNT;
+                s32 note = nextRandom(&random) % NOTES;
+                s32 octave = nextRandom(&random) % OCTAVES;
+                s32 left = nextRandom(&random) % (MAX_VOLUME + 1);
+                s32 right = nextRandom(&random) % (MAX_VOLUME + 1);
+                s32 speed = (s32)(nextRandom(&random) % 8) - 4;
+
+                tic_api_sfx(tic, index, note, octave, -1, channel, left, right, speed);
+            }
+
+        if(frame % 500 == 0)
+        {
+            s32 address = offsetof(tic_ram, registers) + nextRandom(&random) % (sizeof(tic_sound_register) * TIC_SOUND_CHANNELS);
+            u8 value = nextRandom(&random);
+
+            tic_api_poke(tic, address, value, BITS_IN_BYTE);
+        }
+
+        tic_core_sound_tick_end(tic);
+
+        // the same registers tic_core_synth_sound() is about to read
+        const struct sound_ring_buf* ringbuf = &core->state.sound_ringbuf[(core->state.sound_ringbuf_tail + TIC_SOUND_RINGBUF_LEN - 1) % TIC_SOUND_RINGBUF_LEN];
+
+        u64 start = clockNs();
+        refSynthesize(&ref, ringbuf);
+        refElapsed += clockNs() - start;
+
+        start = clockNs();
+        tic_core_synth_sound(tic);
+        elapsed += clockNs() - start;
+
+        hash = hashSamples(hash, tic->product.samples.buffer, tic->product.samples.count);
+        refHash = hashSamples(refHash, ref.samples, ref.count);
+    }
+
+    for (s32 side = 0; side < TIC80_SAMPLE_CHANNELS; side++)
+        blip_delete(ref.blip[side]);
+
+    free(ref.samples);
+    tic_core_close(tic);
+
+    printf("single pass %016llx %.3f ms, %.2f us per frame\n", (unsigned long long)hash, elapsed / 1e6, elapsed / 1e3 / frames);
+    printf("two pass    %016llx %.3f ms, %.2f us per frame\n", (unsigned long long)refHash, refElapsed / 1e6, refElapsed / 1e3 / frames);
+
+    if(hash != refHash)
+    {
+        fprintf(stderr, "Error: the synthesizers produced different samples.\n");
+        return 1;
+    }
+
+    return 0;
+}
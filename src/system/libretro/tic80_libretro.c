@@ -828,6 +828,9 @@ void tic80_libretro_mousecursor(tic80* game, tic80_mouse* mouse, enum mouse_curs
 	// Calculate the final 32-bit color value
 	u32 cursor_color = get_screen_color(tic, state->mouseCursorColor);
 
+	// The cursor is drawn over the blitted rows, so they have to be redrawn next frame.
+	tic_core_invalidate(tic, my + TIC80_OFFSET_TOP - 4, my + TIC80_OFFSET_TOP + 5);
+
 	// Draw the cursor directly to the screen buffer.
 	switch (cursortype) {
 		case MOUSE_CURSOR_NONE:
@@ -1090,7 +1093,6 @@ RETRO_API void retro_run(void)
 RETRO_API bool retro_load_game(const struct retro_game_info *info)
 {
 	// TODO: Warn that Audio Synchronization required to run at a proper speed.
-	// TODO: Warn that the core doesn't support Runahead.
 
 	// Initialize the core if it hasn't been yet.
 	if (state == NULL) {
@@ -1126,6 +1128,10 @@ RETRO_API bool retro_load_game(const struct retro_game_info *info)
 		return false;
 	}
 
+	// Save states cover RAM and the core, but not the variables living in the script VM.
+	uint64_t quirks = RETRO_SERIALIZATION_QUIRK_INCOMPLETE;
+	environ_cb(RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS, &quirks);
+
 	// Set up the TIC-80 environment.
 #if RETRO_IS_BIG_ENDIAN
 	state->tic = tic80_create(TIC80_SAMPLERATE, TIC80_PIXEL_COLOR_ARGB8888);
@@ -1198,34 +1204,37 @@ RETRO_API bool retro_load_game_special(unsigned type, const struct retro_game_in
 }
 
 /**
- * libretro callback; Retrieve the size of the serialized memory.
+ * libretro callback; Retrieve the size of the save state.
  */
 size_t retro_serialize_size(void)
 {
-	return TIC_PERSISTENT_SIZE * sizeof(u32);
+	if (state == NULL || state->tic == NULL) {
+		return 0;
+	}
+
+	return tic_core_snapshot_size((tic_mem*)state->tic) + sizeof(state->frameTime);
 }
 
 /**
- * libretro callback; Get the current persistent memory.
+ * libretro callback; Save RAM and the core state, along with the frame time that drives time().
  */
 RETRO_API bool retro_serialize(void *data, size_t size)
 {
-	TIC_UNUSED(size);
-	if (state == NULL || state->tic == NULL || data == NULL) {
+	if (state == NULL || state->tic == NULL || data == NULL || size < retro_serialize_size()) {
 		return false;
 	}
 
 	tic_mem* tic = (tic_mem*)state->tic;
-	u32* udata = (u32*)data;
-	for (u32 i = 0; i < TIC_PERSISTENT_SIZE; i++) {
-		udata[i] = tic->ram->persistent.data[i];
-	}
+	u32 snapshotSize = tic_core_snapshot_size(tic);
+
+	tic_core_snapshot(tic, data);
+	memcpy((u8*)data + snapshotSize, &state->frameTime, sizeof(state->frameTime));
 
 	return true;
 }
 
 /**
- * libretro callback; Given the serialized data, load it into the persistent memory.
+ * libretro callback; Given the serialized data, restore RAM and the core state.
  */
 RETRO_API bool retro_unserialize(const void *data, size_t size)
 {
@@ -1234,11 +1243,14 @@ RETRO_API bool retro_unserialize(const void *data, size_t size)
 	}
 
 	tic_mem* tic = (tic_mem*)state->tic;
-	u32* uData = (u32*)data;
-	for (u32 i = 0; i < TIC_PERSISTENT_SIZE; i++) {
-		tic->ram->persistent.data[i] = uData[i];
+	u32 snapshotSize = tic_core_snapshot_size(tic);
+
+	if (!tic_core_restore(tic, data, snapshotSize)) {
+		return false;
 	}
 
+	memcpy(&state->frameTime, (const u8*)data + snapshotSize, sizeof(state->frameTime));
+
 	return true;
 }
 
@@ -0,0 +1,113 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string.h>
+#include <SDL.h>
+#include <tic80_types.h>
+
+// Single producer, single consumer sample queue between the main thread and
+// the SDL audio callback. The main thread synthesizes ahead and writes whole
+// frames, the callback only copies out, so neither side ever waits on a lock.
+//
+// head and tail are running byte counts, the buffer size is a power of two so
+// they can wrap freely. The counters are kept for monitoring: an underrun is a
+// callback that got less than it asked for, an overrun is a write that didn't fit.
+
+typedef struct
+{
+    u8* data;
+    u32 size;
+
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+
+    SDL_atomic_t underruns;
+    SDL_atomic_t overruns;
+} AudioFifo;
+
+static inline bool audioFifoInit(AudioFifo* fifo, u32 size)
+{
+    u32 pow2 = 1;
+    while(pow2 < size) pow2 <<= 1;
+
+    SDL_memset(fifo, 0, sizeof *fifo);
+    fifo->data = SDL_malloc(pow2);
+    fifo->size = fifo->data ? pow2 : 0;
+
+    return fifo->data != NULL;
+}
+
+static inline void audioFifoFree(AudioFifo* fifo)
+{
+    SDL_free(fifo->data);
+    SDL_memset(fifo, 0, sizeof *fifo);
+}
+
+static inline u32 audioFifoCount(AudioFifo* fifo)
+{
+    return (u32)SDL_AtomicGet(&fifo->head) - (u32)SDL_AtomicGet(&fifo->tail);
+}
+
+// producer side, the part that doesn't fit is dropped
+static inline void audioFifoWrite(AudioFifo* fifo, const void* data, u32 size)
+{
+    u32 head = SDL_AtomicGet(&fifo->head);
+    u32 space = fifo->size - (head - (u32)SDL_AtomicGet(&fifo->tail));
+
+    if(size > space)
+    {
+        SDL_AtomicIncRef(&fifo->overruns);
+        size = space;
+    }
+
+    u32 pos = head & (fifo->size - 1);
+    u32 first = SDL_min(size, fifo->size - pos);
+
+    memcpy(fifo->data + pos, data, first);
+    memcpy(fifo->data, (const u8*)data + first, size - first);
+
+    SDL_AtomicSet(&fifo->head, head + size);
+}
+
+// consumer side, a short read is padded with silence
+static inline void audioFifoRead(AudioFifo* fifo, void* data, u32 size)
+{
+    u32 tail = SDL_AtomicGet(&fifo->tail);
+    u32 count = (u32)SDL_AtomicGet(&fifo->head) - tail;
+
+    if(size > count)
+    {
+        SDL_AtomicIncRef(&fifo->underruns);
+        memset((u8*)data + count, 0, size - count);
+        size = count;
+    }
+
+    u32 pos = tail & (fifo->size - 1);
+    u32 first = SDL_min(size, fifo->size - pos);
+
+    memcpy(data, fifo->data + pos, first);
+    memcpy((u8*)data + first, fifo->data, size - first);
+
+    SDL_AtomicSet(&fifo->tail, tail + size);
+}
@@ -39,6 +39,8 @@
 #include <SDL.h>
 #endif
 
+#include "audiofifo.h"
+
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
 #endif
@@ -70,8 +72,6 @@
 #define KBD_COLS 22
 #define KBD_ROWS 17
 
-#define LOCK_MUTEX(MUTEX) SDL_LockMutex(MUTEX); SCOPE(SDL_UnlockMutex(MUTEX))
-
 enum
 {
     tic_key_board = tic_keys_count + 1,
@@ -106,6 +106,9 @@ static struct
         Renderer renderer;
         Texture texture;
 
+        // texture content is lost, upload all the rows
+        bool invalid;
+
 #if defined(CRT_SHADER_SUPPORT)
         u32 shader;
         GPU_ShaderBlock block;
@@ -180,10 +183,9 @@ static struct
 
     struct
     {
-        SDL_mutex           *mutex;
         SDL_AudioSpec       spec;
         SDL_AudioDeviceID   device;
-        s32                 bufferRemaining;
+        AudioFifo           fifo;
     } audio;
 
     struct
@@ -191,6 +193,13 @@ static struct
       SDL_AudioSpec       spec;
       SDL_AudioDeviceID   device;
     } audioIn;
+
+    struct
+    {
+        SDL_Thread* thread;
+        SDL_atomic_t timeout;
+        SDL_atomic_t quit;
+    } watchdog;
 } platform
 #if defined(TOUCH_INPUT_SUPPORT)
 =
@@ -289,27 +298,26 @@ static void renderCopy(Renderer render, Texture tex, SDL_Rect src, SDL_Rect dst)
 
 static void audioCallback(void* userdata, u8* stream, s32 len)
 {
-    LOCK_MUTEX(platform.audio.mutex)
-    {
-        const tic_mem* tic = studio_mem(platform.studio);
+    audioFifoRead(&platform.audio.fifo, stream, len);
+}
 
-        while(len--)
-        {
-            if (platform.audio.bufferRemaining <= 0)
-            {
-                studio_sound(platform.studio);
-                platform.audio.bufferRemaining = tic->product.samples.count * TIC80_SAMPLESIZE;
-            }
+// runs on the main thread after the tick, keeps two device buffers queued
+static void updateSound()
+{
+    if(!platform.audio.device)
+        return;
 
-            *stream++ = ((u8*)tic->product.samples.buffer)[tic->product.samples.count * TIC80_SAMPLESIZE - platform.audio.bufferRemaining--];
-        }
+    const tic_mem* tic = studio_mem(platform.studio);
+
+    while(audioFifoCount(&platform.audio.fifo) < platform.audio.spec.size * 2)
+    {
+        studio_sound(platform.studio);
+        audioFifoWrite(&platform.audio.fifo, tic->product.samples.buffer, tic->product.samples.count * TIC80_SAMPLESIZE);
     }
 }
 
 static void initSound()
 {
-    platform.audio.mutex = SDL_CreateMutex();
-
     SDL_AudioSpec want =
     {
         .freq = TIC80_SAMPLERATE,
@@ -322,10 +330,17 @@ static void initSound()
 
     if (studio_config(platform.studio)->fft)
     {
-        FFT_Open(studio_config(platform.studio)->fftcaptureplaybackdevices, studio_config(platform.studio)->fftdevice);
+        bool enabled = FFT_Open(studio_config(platform.studio)->fftcaptureplaybackdevices, studio_config(platform.studio)->fftdevice);
+        tic_core_fft((tic_mem*)studio_mem(platform.studio), enabled);
     }
 
     platform.audio.device = SDL_OpenAudioDevice(NULL, 0, &want, &platform.audio.spec, 0);
+
+    if(platform.audio.device && !audioFifoInit(&platform.audio.fifo, platform.audio.spec.size * 4))
+    {
+        SDL_CloseAudioDevice(platform.audio.device);
+        platform.audio.device = 0;
+    }
 }
 
 static const u8* getSpritePtr(const tic_tile* tiles, s32 x, s32 y)
@@ -384,6 +399,39 @@ static void updateTextureBytes(Texture texture, const void* data, s32 width, s32
     }
 }
 
+static void updateScreenTexture(Texture texture, const tic80* product)
+{
+    // upload continuous runs of the rows updated by the last tick only
+    for(s32 top = 0, bottom; top < TIC80_FULLHEIGHT; top = bottom)
+    {
+        for(bottom = top; bottom < TIC80_FULLHEIGHT
+            && (platform.screen.invalid || TIC80_DIRTY_ROW(product, bottom)); ++bottom);
+
+        if(bottom == top)
+        {
+            ++bottom;
+            continue;
+        }
+
+        const u32* pixels = product->screen + top * TIC80_FULLWIDTH;
+
+#if defined(CRT_SHADER_SUPPORT)
+        if(!studio_config(platform.studio)->soft)
+        {
+            GPU_Rect rect = {0, top, TIC80_FULLWIDTH, bottom - top};
+            GPU_UpdateImageBytes(texture.gpu, &rect, (const u8*)pixels, TIC80_FULLWIDTH * sizeof(u32));
+        }
+        else
+#endif
+        {
+            SDL_Rect rect = {0, top, TIC80_FULLWIDTH, bottom - top};
+            SDL_UpdateTexture(texture.sdl, &rect, pixels, TIC80_FULLWIDTH * sizeof(u32));
+        }
+    }
+
+    platform.screen.invalid = false;
+}
+
 #if defined(TOUCH_INPUT_SUPPORT)
 
 static void drawKeyboardLabels(tic_mem* tic, s32 shift)
@@ -583,6 +631,8 @@ static void initGPU()
             SDL_TEXTUREACCESS_STREAMING, TIC80_FULLWIDTH, TIC80_FULLHEIGHT);
     }
 
+    platform.screen.invalid = true;
+
 #if defined(TOUCH_INPUT_SUPPORT)
     initTouchGamepad();
     initTouchKeyboard();
@@ -1728,6 +1778,63 @@ void tic_sys_default_mapping(tic_mapping* mapping)
     }
 }
 
+// the core publishes the frame it ticks, the watchdog times it on its own clock and
+// interrupts a cart frame that runs longer than the FRAME_TIMEOUT of the config
+static s32 watchdogThread(void* data)
+{
+    enum {Period = 5};
+
+    tic80* tic = (tic80*)&studio_mem(platform.studio)->product;
+
+    u32 watched = 0;
+    u32 start = 0;
+
+    while(!SDL_AtomicGet(&platform.watchdog.quit))
+    {
+        u32 frame = tic80_frame(tic);
+        u32 now = SDL_GetTicks();
+        s32 timeout = SDL_AtomicGet(&platform.watchdog.timeout);
+
+        // a frame is timed from when it was first seen, up to a period late
+        if(frame != watched)
+        {
+            watched = frame;
+            start = now;
+        }
+        else if(frame && timeout > 0 && now - start > (u32)timeout)
+            tic80_interrupt(tic, frame);
+
+        SDL_Delay(Period);
+    }
+
+    return 0;
+}
+
+static void startWatchdog()
+{
+#if !defined(__EMSCRIPTEN__)
+    SDL_AtomicSet(&platform.watchdog.quit, 0);
+    platform.watchdog.thread = SDL_CreateThread(watchdogThread, "tic80 watchdog", NULL);
+
+    if(!platform.watchdog.thread)
+        SDL_Log("Unable to start the watchdog: %s\n", SDL_GetError());
+#endif
+}
+
+static void stopWatchdog()
+{
+    SDL_AtomicSet(&platform.watchdog.quit, 1);
+    SDL_WaitThread(platform.watchdog.thread, NULL);
+    platform.watchdog.thread = NULL;
+}
+
+static void tickStudio()
+{
+    // the config can change on any tick
+    SDL_AtomicSet(&platform.watchdog.timeout, studio_config(platform.studio)->frameTimeout);
+    studio_tick(platform.studio, platform.input);
+}
+
 static void gpuTick()
 {
     const tic_mem* tic = studio_mem(platform.studio);
@@ -1742,13 +1849,11 @@ static void gpuTick()
         return;
     }
 
-    LOCK_MUTEX(platform.audio.mutex)
-    {
-        studio_tick(platform.studio, platform.input);
-    }
+    tickStudio();
+    updateSound();
 
     renderClear(platform.screen.renderer);
-    updateTextureBytes(platform.screen.texture, tic->product.screen, TIC80_FULLWIDTH, TIC80_FULLHEIGHT);
+    updateScreenTexture(platform.screen.texture, &tic->product);
 
     SDL_Rect rect;
     calcTextureRect(&rect);
@@ -1915,12 +2020,15 @@ static s32 start(s32 argc, char **argv, const char* folder)
 
     platform.studio = studio_create(argc, argv, TIC80_SAMPLERATE, SCREEN_FORMAT, folder, determineMaximumScale(), detect_keyboard_layout());
 
-    SCOPE(studio_delete(platform.studio))
+    startWatchdog();
+
+    // the watchdog is stopped before the studio it watches is gone
+    SCOPE(stopWatchdog(), studio_delete(platform.studio))
     {
         if (studio_config(platform.studio)->cli)
         {
             while (!studio_alive(platform.studio))
-                studio_tick(platform.studio, platform.input);
+                tickStudio();
         }
         else
         {
@@ -2002,13 +2110,18 @@ static s32 start(s32 argc, char **argv, const char* folder)
                 SDL_DestroyWindow(platform.window);
                 SDL_CloseAudioDevice(platform.audio.device);
 
+                if(SDL_AtomicGet(&platform.audio.fifo.underruns) || SDL_AtomicGet(&platform.audio.fifo.overruns))
+                    SDL_Log("audio: %i underruns, %i overruns",
+                        SDL_AtomicGet(&platform.audio.fifo.underruns), SDL_AtomicGet(&platform.audio.fifo.overruns));
+
+                audioFifoFree(&platform.audio.fifo);
+
                 if (studio_config(platform.studio)->fft)
                 {
+                    tic_core_fft((tic_mem*)studio_mem(platform.studio), false);
                     FFT_Close();
                 }
             }
-
-            SDL_DestroyMutex(platform.audio.mutex);
         }
     }
 
@@ -25,6 +25,8 @@
 #include <SDL.h>
 #include <tic80.h>
 
+#include "audiofifo.h"
+
 #if defined(__APPLE__)
 # if MAC_OS_X_VERSION_MIN_REQUIRED < 1060
 #    error SDL for Mac OS X only supports deploying on 10.6 and above.
@@ -38,8 +40,7 @@
 
 static struct
 {
-    s32 remaining;
-    SDL_mutex *mutex;
+    AudioFifo fifo;
     bool quit;
 } state = {0};
 
@@ -60,22 +61,7 @@ static u64 tic_sys_freq_get()
 
 static void audioCallback(void* userdata, u8* stream, s32 len)
 {
-    SDL_LockMutex(state.mutex);
-    {
-        tic80* tic = userdata;
-
-        while(len--)
-        {
-            if (state.remaining <= 0)
-            {
-                tic80_sound(tic);
-                state.remaining = tic->samples.count * TIC80_SAMPLESIZE;
-            }
-
-            *stream++ = ((u8*)tic->samples.buffer)[tic->samples.count * TIC80_SAMPLESIZE - state.remaining--];
-        }
-    }
-    SDL_UnlockMutex(state.mutex);
+    audioFifoRead(&state.fifo, stream, len);
 }
 
 s32 runCart(void* cart, s32 size)
@@ -105,8 +91,6 @@ s32 runCart(void* cart, s32 size)
         SDL_AudioSpec audioSpec;
 
         {
-            state.mutex = SDL_CreateMutex();
-
             SDL_AudioSpec want =
             {
                 .freq = TIC80_SAMPLERATE,
@@ -114,10 +98,15 @@ s32 runCart(void* cart, s32 size)
                 .channels = TIC80_SAMPLE_CHANNELS,
                 .callback = audioCallback,
                 .samples = 1024,
-                .userdata = tic,
             };
 
             audioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &audioSpec, 0);
+
+            if(audioDevice && !audioFifoInit(&state.fifo, audioSpec.size * 4))
+            {
+                SDL_CloseAudioDevice(audioDevice);
+                audioDevice = 0;
+            }
         }
 
         const u64 Delta = SDL_GetPerformanceFrequency() / TIC80_FRAMERATE;
@@ -172,11 +161,14 @@ s32 runCart(void* cart, s32 size)
                 }
             }
 
-            SDL_LockMutex(state.mutex);
+            tic80_tick(tic, input, tic_sys_counter_get, tic_sys_freq_get);
+
+            // synthesize ahead on this thread, the callback only copies from the queue
+            while(audioDevice && audioFifoCount(&state.fifo) < audioSpec.size * 2)
             {
-                tic80_tick(tic, input, tic_sys_counter_get, tic_sys_freq_get);
+                tic80_sound(tic);
+                audioFifoWrite(&state.fifo, tic->samples.buffer, tic->samples.count * TIC80_SAMPLESIZE);
             }
-            SDL_UnlockMutex(state.mutex);
 
             SDL_RenderClear(renderer);
 
@@ -214,10 +206,9 @@ s32 runCart(void* cart, s32 size)
             }
         }
 
-        tic80_delete(tic);
-
         SDL_CloseAudioDevice(audioDevice);
-        SDL_DestroyMutex(state.mutex);
+        audioFifoFree(&state.fifo);
+        tic80_delete(tic);
         SDL_DestroyTexture(texture);
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
@@ -77,7 +77,8 @@ TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
 #if defined(TIC_MODULE_EXT)
     else
     {
-        const char* tag = tic_tool_metatag(mem->cart.code.data, "script", NULL);
+        char tag[TIC_METATAG_SIZE];
+        tic_tool_metatag(mem->cart.code.data, "script", NULL, tag, sizeof tag);
         char name[128];
         sprintf(name, "%s" TIC_MODULE_EXT, tag);
 
@@ -124,12 +125,50 @@ TIC80_API void tic80_tick(tic80* tic, tic80_input input, CounterCallback counter
     tic_core_blit(mem);
 }
 
+TIC80_API u32 tic80_frame(tic80* tic)
+{
+    return tic_core_frame((tic_mem*)tic);
+}
+
+TIC80_API bool tic80_interrupt(tic80* tic, u32 frame)
+{
+    return tic_core_interrupt((tic_mem*)tic, frame);
+}
+
 TIC80_API void tic80_sound(tic80* tic)
 {
     tic_mem* mem = (tic_mem*)tic;
     tic_core_synth_sound(mem);
 }
 
+static void sound2ram(tic_mem* mem)
+{
+    memcpy(&mem->ram->sfx, &mem->cart.bank0.sfx, sizeof mem->ram->sfx);
+    memcpy(&mem->ram->music, &mem->cart.bank0.music, sizeof mem->ram->music);
+}
+
+TIC80_API void tic80_render_music(tic80* tic, s32 track)
+{
+    tic_mem* mem = (tic_mem*)tic;
+
+    sound2ram(mem);
+    tic_core_render_music(mem, track, false, 0);
+}
+
+TIC80_API void tic80_render_sfx(tic80* tic, s32 index)
+{
+    tic_mem* mem = (tic_mem*)tic;
+
+    sound2ram(mem);
+    tic_core_render_sfx(mem, index);
+}
+
+TIC80_API s32 tic80_render(tic80* tic, s16* buffer, s32 frames)
+{
+    tic_mem* mem = (tic_mem*)tic;
+    return tic_core_render_sound(mem, buffer, frames);
+}
+
 TIC80_API void tic80_delete(tic80* tic)
 {
     tic_mem* mem = (tic_mem*)tic;
@@ -517,6 +517,7 @@ typedef struct
 
     tic_code code;
     tic_binary binary;
+    tic_binary bytecode;
     u8 lang;
 
 } tic_cartridge;
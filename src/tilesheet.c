@@ -30,24 +30,25 @@ static const tic_blit_segment segments[] = {
     //   |  +bank +bank_size
     //   |  |  |  |     +sheet_width
     //   |  |  |  |     |   +tile_width
-        {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system gfx
-        {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system font
-        {0, 0, 1, 256,  16, 8,  sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 bg
-        {0, 1, 1, 256,  16, 8,  sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 fg
-
-        {0, 0, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 bg
-        {1, 0, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 bg
-        {0, 1, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 fg
-        {1, 1, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 fg
-
-        {0, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 bg
-        {1, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 bg
-        {2, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 bg
-        {3, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 bg
-        {0, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 fg
-        {1, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 fg
-        {2, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 fg
-        {3, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 fg
+    //   |  |  |  |     |   |   +ptr_size         +bpp
+        {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   1, tic_tool_peek1, tic_tool_poke1}, // system gfx
+        {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   1, tic_tool_peek1, tic_tool_poke1}, // system font
+        {0, 0, 1, 256,  16, 8,  sizeof(tic_tile), 4, tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 bg
+        {0, 1, 1, 256,  16, 8,  sizeof(tic_tile), 4, tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 fg
+
+        {0, 0, 2, 512,  32, 16, sizeof(tic_tile), 2, tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 bg
+        {1, 0, 2, 512,  32, 16, sizeof(tic_tile), 2, tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 bg
+        {0, 1, 2, 512,  32, 16, sizeof(tic_tile), 2, tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 fg
+        {1, 1, 2, 512,  32, 16, sizeof(tic_tile), 2, tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 fg
+
+        {0, 0, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 bg
+        {1, 0, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 bg
+        {2, 0, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 bg
+        {3, 0, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 bg
+        {0, 1, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 fg
+        {1, 1, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 fg
+        {2, 1, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 fg
+        {3, 1, 4, 1024, 64, 32, sizeof(tic_tile), 1, tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 fg
 };
 
 extern u8 tic_tilesheet_getpix(const tic_tilesheet* sheet, s32 x, s32 y);
@@ -93,6 +94,51 @@ tic_tileptr tic_tilesheet_gettile(const tic_tilesheet* sheet, s32 index, bool lo
     return (tic_tileptr) { segment, offset, ptr };
 }
 
+// a tile row is 8 pixels, so it always starts on a byte and takes bpp bytes,
+// pixels are packed from the low bits as in tic_tool_peek1/2/4
+
+static inline void unpackRow4(u8* dst, const u8* src)
+{
+    for(s32 i = 0; i < 4; i++, dst += 2)
+        dst[0] = src[i] & 0xf,
+        dst[1] = src[i] >> 4;
+}
+
+static inline void unpackRow2(u8* dst, const u8* src)
+{
+    for(s32 i = 0; i < 2; i++, dst += 4)
+        dst[0] = src[i] & 3,
+        dst[1] = (src[i] >> 2) & 3,
+        dst[2] = (src[i] >> 4) & 3,
+        dst[3] = src[i] >> 6;
+}
+
+static inline void unpackRow1(u8* dst, const u8* src)
+{
+    for(s32 i = 0; i < 8; i++)
+        dst[i] = (*src >> i) & 1;
+}
+
+#define UNPACK_TILE(BPP) do                                                         \
+{                                                                                   \
+    for(s32 y = 0; y < TIC_SPRITESIZE; y++, pixels += TIC_SPRITESIZE)               \
+        unpackRow##BPP(pixels, tile->ptr + ((tile->offset + y * width) * BPP >> 3));\
+} while(0)
+
+void tic_tilesheet_gettilepixels(const tic_tileptr* tile, u8 pixels[TIC_SPRITESIZE * TIC_SPRITESIZE])
+{
+    const u32 width = tile->segment->tile_width;
+
+    switch(tile->segment->bpp)
+    {
+    case 4: UNPACK_TILE(4); break;
+    case 2: UNPACK_TILE(2); break;
+    case 1: UNPACK_TILE(1); break;
+    }
+}
+
+#undef UNPACK_TILE
+
 extern s32 tic_blit_calc_segment(const tic_blit* blit);
 extern void tic_blit_update_bpp(tic_blit* blit, tic_bpp bpp);
 extern s32 tic_blit_calc_index(const tic_blit* blit);
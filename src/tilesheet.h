@@ -34,6 +34,7 @@ typedef struct
     u32    sheet_width;
     u32    tile_width;
     size_t ptr_size;
+    u32    bpp;
     u8     (*peek)(const void*, u32);
     void   (*poke)(void*, u32, u8);
 } tic_blit_segment;
@@ -54,6 +55,9 @@ typedef struct
 tic_tilesheet tic_tilesheet_get(u8 segment, u8* ptr);
 tic_tileptr tic_tilesheet_gettile(const tic_tilesheet* sheet, s32 index, bool local);
 
+// unpacks all the tile pixels at once, row by row, one byte per pixel
+void tic_tilesheet_gettilepixels(const tic_tileptr* tile, u8 pixels[TIC_SPRITESIZE * TIC_SPRITESIZE]);
+
 inline u8 tic_tilesheet_getpix(const tic_tilesheet* sheet, s32 x, s32 y)
 {
     // tile coord
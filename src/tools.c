@@ -36,6 +36,9 @@ extern u8 tic_tool_peek1(const void* addr, u32 index);
 extern s32 tic_tool_sfx_pos(s32 speed, s32 ticks);
 extern u32 tic_rgba(const tic_rgb* c);
 extern s32 tic_modulo(s32 x, s32 m);
+extern u32 tic_atomic_load(tic_atomic* value);
+extern void tic_atomic_store(tic_atomic* value, u32 desired);
+extern bool tic_atomic_cas(tic_atomic* value, u32 expected, u32 desired);
 
 static u32 getPatternData(const tic_track* track, s32 frame)
 {
@@ -202,7 +205,7 @@ void tic_tool_str2buf(const char* str, s32 size, void* buf, bool flip)
     }
 }
 
-const char* tic_tool_metatag(const char* code, const char* tag, const char* comment)
+const char* tic_tool_metatag(const char* code, const char* tag, const char* comment, char* value, s32 size)
 {
     const char* start = NULL;
 
@@ -218,7 +221,6 @@ const char* tic_tool_metatag(const char* code, const char* tag, const char* comm
             start += strlen(tagBuffer);
     }
 
-    static char value[128];
     *value = '\0';
 
     if (start)
@@ -230,10 +232,10 @@ const char* tic_tool_metatag(const char* code, const char* tag, const char* comm
             while (isspace(*start) && start < end) start++;
             while (isspace(*(end - 1)) && end > start) end--;
 
-            const s32 size = MIN((s32)(end - start), sizeof value - 1);
+            const s32 length = MIN((s32)(end - start), size - 1);
 
-            memcpy(value, start, size);
-            value[size] = '\0';
+            memcpy(value, start, length);
+            value[length] = '\0';
         }
     }
 
@@ -26,6 +26,14 @@
 #include "tic.h"
 #include <stddef.h>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+typedef volatile long tic_atomic;
+#else
+#include <stdatomic.h>
+typedef atomic_uint tic_atomic;
+#endif
+
 inline s32 tic_tool_sfx_pos(s32 speed, s32 ticks)
 {
     return speed > 0 ? ticks * (1 + speed) : ticks / (1 - speed);
@@ -87,6 +95,44 @@ inline s32 tic_modulo(s32 x, s32 m)
     return r;
 }
 
+// sequentially consistent u32 shared between threads, all accesses go through these
+#if defined(_MSC_VER) && !defined(__clang__)
+
+inline u32 tic_atomic_load(tic_atomic* value)
+{
+    return (u32)_InterlockedOr(value, 0);
+}
+
+inline void tic_atomic_store(tic_atomic* value, u32 desired)
+{
+    _InterlockedExchange(value, (long)desired);
+}
+
+inline bool tic_atomic_cas(tic_atomic* value, u32 expected, u32 desired)
+{
+    return (u32)_InterlockedCompareExchange(value, (long)desired, (long)expected) == expected;
+}
+
+#else
+
+inline u32 tic_atomic_load(tic_atomic* value)
+{
+    return atomic_load(value);
+}
+
+inline void tic_atomic_store(tic_atomic* value, u32 desired)
+{
+    atomic_store(value, desired);
+}
+
+inline bool tic_atomic_cas(tic_atomic* value, u32 expected, u32 desired)
+{
+    unsigned int current = expected;
+    return atomic_compare_exchange_strong(value, &current, desired);
+}
+
+#endif
+
 tic_blitpal tic_tool_palette_blit(const tic_palette* src, tic80_pixel_color_format fmt);
 
 s32     tic_tool_get_pattern_id(const tic_track* track, s32 frame, s32 channel);
@@ -110,4 +156,7 @@ bool    tic_tool_flat4(const void* buffer, s32 size);
 bool    tic_tool_noise(const tic_waveform* wave);
 u32     tic_nearest_color(const tic_rgb* palette, const tic_rgb* color, s32 count);
 
-const char* tic_tool_metatag(const char* code, const char* tag, const char* comment);
+#define TIC_METATAG_SIZE 128
+
+// copies the tag value into `value` of `size` bytes and returns it, empty if the tag is missing
+const char* tic_tool_metatag(const char* code, const char* tag, const char* comment, char* value, s32 size);
@@ -234,6 +234,10 @@ WASM_IMPORT("cls")
 // Clear the screen.
 void cls(int8_t color);
 
+WASM_IMPORT("drawlist")
+// Execute a batch of packed draw commands, returns the number of values consumed.
+int32_t drawlist(const int32_t* list, int32_t size);
+
 WASM_IMPORT("font")
 // Print a string using foreground sprite data as the font.
 int8_t font(const char* text, int32_t x, int32_t y, uint8_t* trans_colors, int8_t trans_count, int8_t char_width, int8_t char_height, bool fixed, int8_t scale, bool alt);